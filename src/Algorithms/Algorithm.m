@@ -62,7 +62,13 @@ classdef Algorithm < handle
                 error('Number of train patterns and targets must agree')
             end
             
-            [projectedTrain, predictedTrain] = obj.privfit(train, param);
+            if nargout > 0
+                [projectedTrain, predictedTrain] = obj.privfit(train, param);
+            else
+                % nothing is asked about the training patterns, so methods
+                % may skip computing their projection
+                obj.privfit(train, param);
+            end
         end
         
         function [projected, predicted]= predict(obj,test)
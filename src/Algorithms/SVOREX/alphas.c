@@ -18,6 +18,35 @@
 #include "smo.h"
 
 
+typedef struct _Kernel_Task
+{
+	Alphas * alphas ;
+	smo_Settings * settings ;
+} Kernel_Task ;
+
+/*/ fill the rows [begin,end) of the kernel triangle from the packed inputs*/
+static void Task_Kernel_Rows ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	Kernel_Task * task = (Kernel_Task *) arg ;
+	smo_Settings * settings = task->settings ;
+	Alphas * alpha ;
+	double * xi ;
+	unsigned long int i, count = 0 ;
+
+	for ( i = begin ; i < end ; i ++ )
+	{
+		alpha = task->alphas + i ;
+		if ( NULL == alpha->kernel )
+			continue ;
+		xi = MATRIX.x + i*MATRIX.stride ;
+		KOPS->row( &(MATRIX), P, xi, 0, i+1, alpha->kernel ) ;
+		alpha->kernel[i] += 0.001 ;
+		count += i + 1 ;
+	}
+	COUNT_ADD( settings->stats.kernels, count ) ;
+}
+
+
 /*******************************************************************************\
 
 	Alphas * Create_Alphas ( smo_Settings * settings )
@@ -34,7 +63,8 @@ Alphas * Create_Alphas ( smo_Settings * settings )
 	Alphas * alpha = NULL ;
 	Alphas * alphas = NULL ;
 	Data_List * pairs = NULL ;
-	unsigned int  i = 0, j ;
+	unsigned int  i = 0 ;
+	Kernel_Task task ;
 	
 	if ( NULL == settings )
 	{
@@ -60,23 +90,28 @@ Alphas * Create_Alphas ( smo_Settings * settings )
 		return NULL ;		
 	}
 
+	if ( MATRIX.count != pairs->count || NULL == MATRIX.x )
+	{ 
+		printf( "\r\nFATAL ERROR : Data_Matrix have not be initialized.\r\n") ;
+		free( alphas ) ;
+		return  NULL ;
+	}
+
 	pair = pairs->front ;
-	while ( pair != NULL )
+	for ( i = 0 ; i < MATRIX.count ; i ++ )
 	{		
 		alpha = alphas + i ;
-		i++ ;	
 		alpha->f_cache = 0 ;
 		alpha->pair = pair ;
 		alpha->kernel = NULL ;
-		alpha->kernel = (double *) malloc(i*sizeof(double)) ;
-		if ( NULL == alpha->kernel )
-			printf("Fatal Error : fail to malloc memory.\r\n") ;
-		else
+		/* keep the whole triangle only if it fits into the cache, otherwise
+		   the rows are computed on demand by Get_Kernel_Row*/
+		if ( TRUE == settings->cacheall )
 		{
-			/*/ initial the kernel matrix cache*/
-			for (j=0 ; j<i ; j++)
-				alpha->kernel[j] = Calc_Kernel(alpha, alphas+j, settings) ;	
-		}	
+			alpha->kernel = (double *) malloc((i+1)*sizeof(double)) ;
+			if ( NULL == alpha->kernel )
+				printf("Fatal Error : fail to malloc memory.\r\n") ;
+		}
 		if (ORDINAL == pairs->datatype)
 		{
 			alpha->alpha = 0 ;	
@@ -91,9 +126,17 @@ Alphas * Create_Alphas ( smo_Settings * settings )
 			printf("Error datatype.\n") ;
 			exit(1) ;
 		}
-		alpha->cache = NULL ;
+		alpha->cache = 0 ;
+		alpha->shrunk = FALSE ;
 		pair = pair->next ;
 	}
+	/*/ initial the kernel matrix cache, a few rows per thread at a time*/
+	if ( TRUE == settings->cacheall )
+	{
+		task.alphas = alphas ;
+		task.settings = settings ;
+		Run_Thread_Pool( POOL, MATRIX.count, 16, Task_Kernel_Rows, &task ) ;
+	}
 	return alphas ;
 } /*/ end of Create_Alphas*/
 
@@ -116,6 +159,9 @@ BOOL Clear_Alphas ( smo_Settings * settings )
 		return FALSE ;
 	}
 
+	if ( NULL == ALPHA )
+		return FALSE ;
+
 	for (i=0;i<settings->pairs->count;i++)
 	{
 		alpha = ALPHA + i ;
@@ -161,6 +207,8 @@ BOOL Clean_Alphas ( Alphas * alphas, smo_Settings * settings )
 	{
 		settings->mu[i-1] = 0 ;
 	}
+	if ( NULL != settings->weight )
+		memset( settings->weight, 0, MATRIX.cont*sizeof(double) ) ;
 
 	i=0 ;
 	node = pairs->front ;
@@ -185,7 +233,8 @@ BOOL Clean_Alphas ( Alphas * alphas, smo_Settings * settings )
 			printf("Error datatype.\n") ;
 			exit(1) ;
 		}
-		alpha->cache = NULL ; /*/ clear the reference to Io_Cache here*/
+		alpha->cache = 0 ; /*/ clear the reference to Io_Cache here*/
+		alpha->shrunk = FALSE ;
 		alpha->pair = node ;			
 		node = node->next ;
 	}
@@ -193,6 +242,144 @@ BOOL Clean_Alphas ( Alphas * alphas, smo_Settings * settings )
 
 } /*/ end of Clean_Alphas*/
 
+/*******************************************************************************\
+
+	BOOL Seed_Alphas ( Alphas * alphas, double vc, smo_Settings * settings )
+	
+	scale the solution found at the regularization factor vc to the current VC,
+	so that the next smo_ordinal starts from it rather than from zero. the 
+	equality constraints are homogeneous, so the scaled alphas and mu are still
+	feasible; Check_Alphas then clips them to the box and rebuilds f_cache, 
+	Io_CACHE and the bounds.
+	input:  the pointer to the head of Alphas matrix, the former C and the pointer to smo_Settings
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Seed_Alphas ( Alphas * alphas, double vc, smo_Settings * settings )
+{
+	Alphas * alpha ;
+	long unsigned int i ;
+	unsigned int j ;
+	double ratio ;
+
+	if ( NULL == alphas || NULL == settings || vc <= 0 )
+	{
+		printf("\r\nFATAL ERROR : input is wrong in Seed_Alphas.\r\n") ;
+		return FALSE ;
+	}
+
+	ratio = VC / vc ;
+	for ( i = 0 ; i < settings->pairs->count ; i ++ )
+	{
+		alpha = alphas + i ;
+		/*/ keep the bounded alphas exactly on the new bound*/
+		if ( fabs(alpha->alpha_up - vc) < EPS*EPS )
+			alpha->alpha_up = VC ;
+		else
+			alpha->alpha_up = alpha->alpha_up * ratio ;
+		if ( fabs(alpha->alpha_dw - vc) < EPS*EPS )
+			alpha->alpha_dw = VC ;
+		else
+			alpha->alpha_dw = alpha->alpha_dw * ratio ;
+		alpha->alpha = - alpha->alpha_up + alpha->alpha_dw ;
+	}
+	for ( j = 1 ; j < settings->pairs->classes ; j ++ )
+		settings->mu[j-1] = settings->mu[j-1] * ratio ;
+	settings->warm = TRUE ;
+	return TRUE ;
+} /*/ end of Seed_Alphas*/
+
+
+/*******************************************************************************\
+
+	BOOL Assign_Alphas ( Alphas * alphas, double * init, smo_Settings * settings )
+	
+	take alpha_up and alpha_dw of every sample from init, a column major matrix
+	of count rows and 2 columns, as the initial point of the next smo_ordinal. 
+	mu is recovered from the equality constraints on the thresholds, 
+		mu_1 = 0, mu_{j+1} = mu_j + sum alpha_up(rank j) - sum alpha_dw(rank j+1),
+	and the seed is refused if it is out of the box or infeasible.
+	input:  the pointer to the head of Alphas matrix, the initial alphas and the pointer to smo_Settings
+	output: TRUE if the alphas are seeded, otherwise FALSE and they are cleaned
+
+\*******************************************************************************/
+
+BOOL Assign_Alphas ( Alphas * alphas, double * init, smo_Settings * settings )
+{
+	Alphas * alpha ;
+	long unsigned int i ;
+	unsigned int j ;
+	double * up = NULL ;
+	double * dw = NULL ;
+	BOOL feasible = TRUE ;
+
+	if ( NULL == alphas || NULL == init || NULL == settings )
+	{
+		printf("\r\nFATAL ERROR : input is NULL in Assign_Alphas.\r\n") ;
+		return FALSE ;
+	}
+	up = (double *) calloc(settings->pairs->classes+1, sizeof(double)) ;
+	dw = (double *) calloc(settings->pairs->classes+1, sizeof(double)) ;
+	if ( NULL == up || NULL == dw )
+	{
+		printf("\r\nFATAL ERROR : fail to malloc in Assign_Alphas.\r\n") ;
+		if (NULL != up)
+			free(up) ;
+		if (NULL != dw)
+			free(dw) ;
+		return FALSE ;
+	}
+
+	for ( i = 0 ; i < settings->pairs->count && TRUE == feasible ; i ++ )
+	{
+		alpha = alphas + i ;
+		alpha->alpha_up = init[i] ;
+		alpha->alpha_dw = init[i+settings->pairs->count] ;
+		if ( alpha->alpha_up > VC + EPS || alpha->alpha_dw > VC + EPS )
+			feasible = FALSE ;
+		if ( alpha->alpha_up < -EPS || alpha->alpha_dw < -EPS )
+			feasible = FALSE ;
+		/*/ no alpha_up on the highest rank, no alpha_dw on the lowest*/
+		if ( alpha->alpha_up > 0 && alpha->pair->target >= settings->pairs->classes )
+			feasible = FALSE ;
+		if ( alpha->alpha_dw > 0 && alpha->pair->target <= 1 )
+			feasible = FALSE ;
+		alpha->alpha_up = max(min(alpha->alpha_up, VC), 0) ;
+		alpha->alpha_dw = max(min(alpha->alpha_dw, VC), 0) ;
+		alpha->alpha = - alpha->alpha_up + alpha->alpha_dw ;
+		up[alpha->pair->target] += alpha->alpha_up ;
+		dw[alpha->pair->target] += alpha->alpha_dw ;
+	}
+	if ( TRUE == feasible )
+	{
+		settings->mu[0] = 0 ;
+		for ( j = 1 ; j < settings->pairs->classes ; j ++ )
+		{
+			if ( settings->mu[j-1] < -EPS )
+				feasible = FALSE ;
+			if ( settings->mu[j-1] < 0 )
+				settings->mu[j-1] = 0 ;
+			if ( j + 1 < settings->pairs->classes )
+				settings->mu[j] = settings->mu[j-1] + up[j] - dw[j+1] ;
+			else if ( fabs(settings->mu[j-1] + up[j] - dw[j+1]) > EPS )
+				feasible = FALSE ;
+		}
+	}
+	free(up) ;
+	free(dw) ;
+	if ( FALSE == feasible )
+	{
+		printf("Warning : the initial alphas are not feasible, SMO starts from zero.\r\n") ;
+		Clean_Alphas( alphas, settings ) ;
+		settings->warm = FALSE ;
+		return FALSE ;
+	}
+	settings->warm = TRUE ;
+	return TRUE ;
+} /*/ end of Assign_Alphas*/
+
+
 
 BOOL Check_Alphas ( Alphas * alphas, smo_Settings * settings )
 {
@@ -239,13 +426,15 @@ BOOL Check_Alphas ( Alphas * alphas, smo_Settings * settings )
 			printf("Error datatype.\n") ;
 			exit(1) ;
 		}
-		alpha->f_cache = Calculate_Ordinal_Fi(i+1, settings) ;
-		alpha->cache = NULL ; /*/ clear the reference to Io_Cache here*/
+		alpha->cache = 0 ; /*/ clear the reference to Io_Cache here*/
+		alpha->shrunk = FALSE ;
 		if (alpha->pair != node )
 			printf("error in data list.\r\n") ;			
 		node = node->next ;	
 		i++ ;
 	}
+	/*/ Fi from the clipped alphas*/
+	Refresh_Ordinal_Fi( settings ) ;
 	/*/ create Io_cache */
 	/*/ initial b_up b_low		*/
 	for (loop = 1 ; loop < settings->pairs->classes ; loop ++)
@@ -1,12 +1,12 @@
 /*******************************************************************************\
 
 	cachelist.c in Sequential Minimal Optimization ver2.0
-		
+
 	implements manipulations for cache list.
-		
+
 	Chu Wei Copyright(C) National Univeristy of Singapore
-	Create on Jan. 16 2000 at Control Lab of Mechanical Engineering 
-	Update on Aug. 23 2001 
+	Create on Jan. 16 2000 at Control Lab of Mechanical Engineering
+	Update on Aug. 23 2001
 
 \*******************************************************************************/
 
@@ -14,70 +14,66 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "smo.h"
 
-BOOL Create_Cache_List ( Cache_List * list ) 
-{  
+/*/ the Io set is kept as a packed array of alphas, the latest one at the end.
+/ it is walked from the end, so that the order matches the former linked list
+/ where a node was always added at the front.*/
+
+BOOL Create_Cache_List ( Cache_List * list )
+{
 	if (NULL == list)
 		return FALSE ;
 	list -> count = 0 ;
-	list -> front = NULL ;
-	list -> rear = NULL ;
+	list -> size = 0 ;
+	list -> member = NULL ;
 	return TRUE ;
 }
 
 
 BOOL Is_Cache_Empty ( Cache_List * list )
 {
-	if (NULL == list) 
+	if (NULL == list)
 	{
 		printf ("Cache_List has been abused \n") ;
 		return FALSE ;
 	}
-	if (list -> front == NULL)
+	if (0 == list -> count)
 		return  TRUE ;
-	else 
+	else
 		return  FALSE ;
 }
 
 
 BOOL Add_Cache_Node ( Cache_List * list, Alphas * alpha )
 {
-	Cache_Node * node = NULL ;
+	Alphas ** member = NULL ;
+	long unsigned int size ;
 
-	if (NULL != alpha->cache)
+	if (0 != alpha->cache)
 	{
 		printf ("alpha->cache is not NULL\n") ;
 		return FALSE ;
 	}
 
-	node = (Cache_Node *) malloc (sizeof(Cache_Node)) ;
-	if (NULL == node)
+	if (list -> count == list -> size)
 	{
-		printf ("Fail to create Cache_Node, or alpha is wrong \n") ;
-		return FALSE ;
+		size = list -> size > 0 ? 2 * list -> size : 64 ;
+		member = (Alphas **) realloc (list -> member, size * sizeof(Alphas *)) ;
+		if (NULL == member)
+		{
+			printf ("Fail to create Cache_Node, or alpha is wrong \n") ;
+			return FALSE ;
+		}
+		list -> member = member ;
+		list -> size = size ;
 	}
 
-	node -> alpha = alpha ;
- 	node -> previous = NULL ;
-	node -> next = NULL ;
-
-	if (NULL == list->front)
-	{
-		list -> front = node ;
-		list -> rear = node ;
-	}
-	else
-	{
-		node -> next = list -> front ;
-		list -> front -> previous = node ;
-		list -> front = node ;
-		node -> previous = NULL ;
-	}
-	
+	list -> member[list -> count] = alpha ;
 	list -> count ++ ;
 
-	alpha -> cache = node ;
+	alpha -> cache = list -> count ;
 
 #ifdef SMO_DEBUG
 	/*/printf ("Add index %d into Cache List\n", alpha->pair->index) ;*/
@@ -89,202 +85,249 @@ BOOL Add_Cache_Node ( Cache_List * list, Alphas * alpha )
 
 /*******************************************************************************\
 
-	BOOL Sort_Cache_Node ( Cache_List * list, Alphas * alpha )
-	
-	add alpha into cache list, the position is determined by alpha->Fi
-	we guarantee the node is sorted by deceasing Fi.
-	input:  the pointer to the head of Data_List 
+	BOOL Del_Cache_Node ( Cache_List * list, Alphas * alpha )
+
+	remove alpha from the cache list. the later members are moved down by one
+	so that the walking order of the rest is not changed.
+	input:  the pointer to Cache_List and the alpha in it
 	output: TRUE or FALSE
 
 \*******************************************************************************/
 
-BOOL Sort_Cache_Node ( Cache_List * list, Alphas * alpha )
+BOOL Del_Cache_Node ( Cache_List * list, Alphas * alpha )
 {
-	Cache_Node * node = NULL ;
-	Cache_Node * cur = NULL ;
-	/*/Cache_Node * temp = NULL ;*/
-	double Fi = 0 ;
- 
-	if ( NULL == list || NULL ==alpha )
-		return FALSE ;
+	long unsigned int pos ;
 
-	if (NULL != alpha->cache)
+	if (0 == alpha->cache)
 	{
-		printf ("alpha->cache is not NULL\n") ;
+		printf ("\r\nalpha->cache is NULL.\r\n") ;
 		return FALSE ;
 	}
 
-	node = (Cache_Node *) malloc (sizeof(Cache_Node)) ;
-	if (NULL == node)
+	if (TRUE == Is_Cache_Empty (list) )
 	{
-		printf ("Fail to create Cache_Node, or alpha is wrong \n") ;
+		printf ("\r\nFatal Error in Del_Cache_Node: Cache_List is empty!\r\n") ;
 		return FALSE ;
 	}
 
-	node -> alpha = alpha ;
- 	node -> previous = NULL ;
-	node -> next = NULL ;
-
-	if ( NULL == list -> front )
+	for ( pos = alpha->cache ; pos < list->count ; pos ++ )
 	{
-#ifdef SMO_DEBUG
-		if ( NULL != list -> rear )
-		{
-			printf("\r\nfatal error in Cache_List.\r\n") ;
-			return FALSE ;
-		}
-#endif
-		list -> front = node ;
-		list -> rear = node ;
+		list->member[pos-1] = list->member[pos] ;
+		list->member[pos-1]->cache = pos ;
 	}
-	else
-	{	
-		/*/ sorting the list by alpha->Fi*/
-		cur = list->front ;
-		Fi= cur->alpha->f_cache ;
-		
-		while ( NULL != cur &&  fabs(Fi) > fabs(alpha->f_cache) )
-		{
-			cur = cur->next ;
-			if (NULL != cur)
-				Fi = cur->alpha->f_cache ;
-		}
 
-		if ( NULL == cur )
-		{
-			/*/insert at tail*/
-			list -> rear -> next = node ;
-			node -> previous = list -> rear ;
-			list -> rear = node ; 
-		}
-		else if ( NULL == cur -> previous )
-		{
-			/*/insert at head*/
-#ifdef SMO_DEBUG
-			if ( cur != list -> front )
-			{
-				printf("fatal error in Cache_List.") ;
-				return FALSE ;
-			}
-#endif
-			node -> next = cur ;
-			list-> front ->previous = node ;
-			list -> front = node ;
-		}
-		else
-		{
-			node -> next = cur ;
-			node -> previous = cur->previous ;
-			cur->previous->next = node ;
-			cur->previous = node ;
-		}
-	}
-	
-	list -> count ++ ;
-	/*/ add pointer into alpha list*/
-	alpha -> cache = node ;
+	list->count -- ;
+	alpha->cache = 0 ;
 
 #ifdef SMO_DEBUG
-	/*/printf ("\r\nAdd index %d into Cache List\r\n", alpha->pair->index) ;*/
+	/*printf("\r\nDelete index %d from Cache List\r\n", alpha->pair->index) ;*/
 #endif
 
 	return TRUE ;
 }
 
 
-
-BOOL Del_Cache_Node ( Cache_List * list, Alphas * alpha )
+BOOL Clear_Cache_List ( Cache_List * list )
 {
-	Cache_Node * node = NULL ;
+	long unsigned int pos ;
 
-	if (NULL == alpha->cache)
+#ifdef SMO_DEBUG
+	if (NULL == list)
 	{
-		printf ("\r\nalpha->cache is NULL.\r\n") ;
+		printf ("\r\nError : Cache_List is abused!\r\n") ;
 		return FALSE ;
 	}
-	else 
-		node = alpha->cache ;
+#endif
 
-	if (TRUE == Is_Cache_Empty (list) )
-	{
-		printf ("\r\nFatal Error in Del_Cache_Node: Cache_List is empty!\r\n") ;
-		return FALSE ; 
-	}
+	for ( pos = 0 ; pos < list->count ; pos ++ )
+		list->member[pos]->cache = 0 ;
+
+	if (NULL != list->member)
+		free(list->member) ;
+	list->member = NULL ;
+	list->count = 0 ;
+	list->size = 0 ;
+
+	return TRUE ;
+}
 
-	if ( NULL != node->previous )  
+
+typedef struct _Io_Task
+{
+	smo_Settings * settings ;
+	Alphas * alpha1 ;
+	Alphas * alpha2 ;
+	double d1 ;
+	double d2 ;
+	int * index ;
+	double * bj_up ;                /*/ classes-1 bounds per block*/
+	double * bj_low ;
+	long unsigned int * ij_up ;
+	long unsigned int * ij_low ;
+} Io_Task ;
+
+static void Task_Io_Cache ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	Io_Task * task = (Io_Task *) arg ;
+	smo_Settings * settings = task->settings ;
+	unsigned int classes = settings->pairs->classes - 1 ;
+	double * bj_up = task->bj_up + block * classes ;
+	double * bj_low = task->bj_low + block * classes ;
+	long unsigned int * ij_up = task->ij_up + block * classes ;
+	long unsigned int * ij_low = task->ij_low + block * classes ;
+	Alphas * alpha3 ;
+	unsigned long int w ;
+	unsigned int loop ;
+
+	for ( w = begin ; w < end ; w ++ )
 	{
-		node->previous->next = node->next ;
-		if ( NULL != node->next ) 
-			node->next->previous = node->previous ;
-		else					
+		alpha3 = Io_CACHE.member[Io_CACHE.count - 1 - w] ;
+		if ( 0 == task->index[alpha3-ALPHA] )
 		{
-			node->previous->next = NULL ;
-			list->rear = node->previous ;
+			if ( TRUE == settings->primal )
+				alpha3->f_cache = Linear_Fi( alpha3, settings ) ;
+			else
+			{
+				if ( 0 != task->d1 )
+					alpha3->f_cache = alpha3->f_cache + task->d1 * Calc_Kernel( task->alpha1, alpha3, settings ) ;
+				if ( 0 != task->d2 )
+					alpha3->f_cache = alpha3->f_cache + task->d2 * Calc_Kernel( task->alpha2, alpha3, settings ) ;
+			}
+			task->index[alpha3-ALPHA] = 1 ;
+		}
+
+		if (alpha3->pair->target > 1 )
+		{
+			loop = alpha3->pair->target - 2 ;
+			/*/lower*/
+			if (alpha3->setname_dw==Io_b || alpha3->setname_dw==I_One)
+			{
+				if (alpha3->f_cache-1<bj_up[loop])
+				{
+					bj_up[loop] = alpha3->f_cache-1 ;
+					ij_up[loop] = alpha3 - ALPHA + 1 ;
+				}
+			}
+			if (alpha3->setname_dw==Io_b || alpha3->setname_dw==I_Fou)
+			{
+				if (alpha3->f_cache-1>bj_low[loop])
+				{
+					bj_low[loop] = alpha3->f_cache-1 ;
+					ij_low[loop] = alpha3 - ALPHA + 1 ;
+				}
+			}
+		}
+		if ( alpha3->pair->target < settings->pairs->classes )
+		{
+			loop = alpha3->pair->target - 1 ;
+			/*/upper*/
+			if (alpha3->setname_up==Io_a || alpha3->setname_up==I_Thr)
+			{
+				if (alpha3->f_cache+1<bj_up[loop])
+				{
+					bj_up[loop] = alpha3->f_cache+1 ;
+					ij_up[loop] = alpha3 - ALPHA + 1 ;
+				}
+			}
+			if (alpha3->setname_up==Io_a || alpha3->setname_up==I_Two)
+			{
+				if (alpha3->f_cache+1>bj_low[loop])
+				{
+					bj_low[loop] = alpha3->f_cache+1 ;
+					ij_low[loop] = alpha3 - ALPHA + 1 ;
+				}
+			}
 		}
 	}
-	else if ( NULL != node->next ) 
-	{
-		list->front = node->next ;
-		node->next->previous = NULL ;
-	}		
-	else   
-	{          
-		list->front = NULL ;
-		list->rear = NULL ;
-	}
+}
 
-	list->count -- ;
-	alpha->cache = NULL ;
-	free (node) ;
+/*******************************************************************************\
 
-#ifdef SMO_DEBUG
-	/*printf("\r\nDelete index %d from Cache List\r\n", alpha->pair->index) ;*/
-#endif
+	void Update_Io_Cache ( Alphas * alpha1, double d1, Alphas * alpha2, double d2, int * index, smo_Settings * settings )
 
-	return TRUE ;	
-}
+	add d1*K(x1,x)+d2*K(x2,x) to f_cache of the samples in Io whose index is 0,
+	and vote bj_up/bj_low over all of Io, in one pass over the packed array.
+	with the thread pool each block votes on its own and the blocks are merged
+	in the walking order, so that the same sample wins as in the serial pass.
+	without a kernel cache for the linear kernel f_cache is taken from the 
+	weight vector, one product instead of two kernel values.
+	input:  the two updated alphas and the changes of their coefficients,
+	        the flags of updated samples, and the pointer to smo_Settings
+	output: none
 
+\*******************************************************************************/
 
-BOOL Clear_Cache_List ( Cache_List * list ) 
+void Update_Io_Cache ( Alphas * alpha1, double d1, Alphas * alpha2, double d2, int * index, smo_Settings * settings )
 {
-
-	Cache_Node * temp = NULL ;
-
-#ifdef SMO_DEBUG
-	if (NULL == list)
+	Io_Task task ;
+	unsigned int threads = Thread_Pool_Size( POOL ) ;
+	unsigned int classes = settings->pairs->classes - 1 ;
+	unsigned long int count = Io_CACHE.count ;
+	unsigned long int chunk, blocks, b ;
+	unsigned int loop ;
+	double * bj = NULL ;
+	long unsigned int * ij = NULL ;
+
+	if ( count > settings->stats.io_peak )
+		settings->stats.io_peak = count ;
+	task.settings = settings ;
+	task.alpha1 = alpha1 ;
+	task.alpha2 = alpha2 ;
+	task.d1 = d1 ;
+	task.d2 = d2 ;
+	task.index = index ;
+
+	if ( threads > 1 && count >= MINPARALLEL )
 	{
-		printf ("\r\nError : Cache_List is abused!\r\n") ;
-		return FALSE ; 
+		chunk = (count + 4*threads - 1)/(4*threads) ;
+		blocks = (count + chunk - 1)/chunk ;
+		bj = (double *) malloc(2*blocks*classes*sizeof(double)) ;
+		ij = (long unsigned int *) calloc(2*blocks*classes, sizeof(long unsigned int)) ;
 	}
-#endif
-	
-	while (NULL != list->front)	
+	if ( NULL == bj || NULL == ij )
 	{
-		temp = list->front ;
-		list->front = temp->next ;
-		list->count -- ;
-		temp->alpha->cache = NULL ;
-		
-#ifdef SMO_DEBUG
-		/*/printf ("\r\nDelete index %d in Cache_List\r\n", temp->alpha->pair->index) ;*/
-#endif
-	
-		free(temp) ;
+		/*/ vote into the bounds directly*/
+		if (NULL != bj)
+			free(bj) ;
+		if (NULL != ij)
+			free(ij) ;
+		task.bj_up = settings->bj_up ;
+		task.bj_low = settings->bj_low ;
+		task.ij_up = settings->ij_up ;
+		task.ij_low = settings->ij_low ;
+		Task_Io_Cache( &task, 0, count, 0 ) ;
+		return ;
 	}
 
-	if ( 0 != list->count )
+	task.bj_up = bj ;
+	task.bj_low = bj + blocks*classes ;
+	task.ij_up = ij ;
+	task.ij_low = ij + blocks*classes ;
+	for ( b = 0 ; b < blocks*classes ; b ++ )
 	{
-		printf( "\r\nError happened in Clear_Cache_List!" ) ;
-		list->count = 0 ;
-		return FALSE ;
+		task.bj_up[b] = (double)INT_MAX ;
+		task.bj_low[b] = (double)INT_MIN ;
 	}
-	else
+	Run_Thread_Pool( POOL, count, chunk, Task_Io_Cache, &task ) ;
+
+	for ( b = 0 ; b < blocks ; b ++ )
 	{
-		list->front = NULL ;
-		list->rear = NULL ;
+		for ( loop = 0 ; loop < classes ; loop ++ )
+		{
+			if ( 0 != task.ij_up[b*classes+loop] && task.bj_up[b*classes+loop] < settings->bj_up[loop] )
+			{
+				settings->bj_up[loop] = task.bj_up[b*classes+loop] ;
+				settings->ij_up[loop] = task.ij_up[b*classes+loop] ;
+			}
+			if ( 0 != task.ij_low[b*classes+loop] && task.bj_low[b*classes+loop] > settings->bj_low[loop] )
+			{
+				settings->bj_low[loop] = task.bj_low[b*classes+loop] ;
+				settings->ij_low[loop] = task.ij_low[b*classes+loop] ;
+			}
+		}
 	}
-
-	return TRUE ;
+	free(bj) ;
+	free(ij) ;
 }
 
 /*/ the end of cachelist.c*/
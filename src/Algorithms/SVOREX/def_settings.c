@@ -64,6 +64,13 @@ def_Settings * Create_def_SettingsMatlab ( void )
 	INDEX = 1 ;
 	
 	settings->cache_size = DEF_CACHE ;
+	settings->threads = DEF_THREADS ;
+	settings->fcacheall = DEF_FCACHEALL ;
+	settings->seeding = DEF_SEEDING ;
+	settings->shrinking = DEF_SHRINKING ;
+	settings->approx = DEF_APPROX ;
+	settings->rank = DEF_RANK ;
+	settings->secondorder = DEF_SECONDORDER ;
 	settings->lnC_step = DEF_COARSESTEP ;
 	settings->lnK_step = DEF_COARSESTEP ;
 	settings->lnC_start = DEF_INFERLNC ;
@@ -138,7 +145,7 @@ def_Settings * Create_def_SettingsMatlab ( void )
 }
 
 //BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol, double ** train,double ** test )
-BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol, double ** train)
+BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol, double * train)
 {
 	char buf[LENGTH] ;
 	char msg[20] ;
@@ -205,14 +212,14 @@ BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol,
 		if ( NULL == ( defsetting->testfile = strdup(buf) ) )
 			batchgoon = FALSE ;
 		/*/ load data into pairs */ 
-		if ( FALSE == smo_LoadMatrix(&(defsetting->pairs), defsetting->inputfile, 0, nFil,nCol,train) )
+		if ( FALSE == smo_LoadMatrix(&(defsetting->pairs), defsetting->inputfile, 0, nFil,nCol,train,nFil) )
 			batchgoon = FALSE ;
 	}
 	else
 	{
 
 		/* load data into pairs*/ 
-		if ( FALSE == smo_LoadMatrix(&(defsetting->pairs), defsetting->inputfile, 0, nFil,nCol,train) )
+		if ( FALSE == smo_LoadMatrix(&(defsetting->pairs), defsetting->inputfile, 0, nFil,nCol,train,nFil) )
 		{	
 	
 			batchgoon = FALSE ;
@@ -230,7 +237,6 @@ BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol,
 	{	
 		defsetting->beta = 1.0 ;
 	}
-	defsetting->cache_size = DEF_CACHE ;	
 	defsetting->time = 0 ;
 
 	defsetting->lnC_step = defsetting->def_lnC_step ;
@@ -295,6 +301,13 @@ def_Settings * Create_def_Settings ( char * filename )
 	INDEX = 1 ;
 	
 	settings->cache_size = DEF_CACHE ;
+	settings->threads = DEF_THREADS ;
+	settings->fcacheall = DEF_FCACHEALL ;
+	settings->seeding = DEF_SEEDING ;
+	settings->shrinking = DEF_SHRINKING ;
+	settings->approx = DEF_APPROX ;
+	settings->rank = DEF_RANK ;
+	settings->secondorder = DEF_SECONDORDER ;
 	settings->lnC_step = DEF_COARSESTEP ;
 	settings->lnK_step = DEF_COARSESTEP ;
 	settings->lnC_start = DEF_INFERLNC ;
@@ -440,13 +453,13 @@ BOOL Update_def_Settings( def_Settings * defsetting )
 		if ( NULL == ( defsetting->testfile = strdup(buf) ) )
 			batchgoon = FALSE ;
 		// load data into pairs 
-		if ( FALSE == smo_Loadfile(&(defsetting->pairs), defsetting->inputfile, 0) )
+		if ( FALSE == smo_Loadfile(&(defsetting->pairs), defsetting->inputfile, 0, defsetting->threads) )
 			batchgoon = FALSE ;
 	}
 	else
 	{
 		// load data into pairs 
-		if ( FALSE == smo_Loadfile(&(defsetting->pairs), defsetting->inputfile, 0) )
+		if ( FALSE == smo_Loadfile(&(defsetting->pairs), defsetting->inputfile, 0, defsetting->threads) )
 		{	
 			batchgoon = FALSE ;
 			printf("Failed to load training data from the file %s\n", defsetting->inputfile) ;
@@ -463,7 +476,6 @@ BOOL Update_def_Settings( def_Settings * defsetting )
 	{	
 		defsetting->beta = 1.0 ;
 	}
-	defsetting->cache_size = DEF_CACHE ;	
 	defsetting->time = 0 ;
 
 	defsetting->lnC_step = defsetting->def_lnC_step ;
@@ -476,7 +488,7 @@ BOOL Update_def_Settings( def_Settings * defsetting )
 	// load data into pairs 
 	// load testing data into pairs
 	//if (batchgoon == TRUE)
-	//	if ( FALSE == smo_Loadfile(&(defsetting->testdata), defsetting->testfile, defsetting->pairs.dimen) )
+	//	if ( FALSE == smo_Loadfile(&(defsetting->testdata), defsetting->testfile, defsetting->pairs.dimen, defsetting->threads) )
 	//		printf ("Failed to load testing data from the file %s", defsetting->testfile ) ;	
 	
 	return batchgoon ;	
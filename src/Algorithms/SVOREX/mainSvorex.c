@@ -14,6 +14,35 @@
 #define VERSION (0)
 
 
+/* the counters and the wall times of the solver as a struct for the sixth output */
+static mxArray * Stats_Struct ( smo_Settings * settings )
+{
+	const char * fields[] = { "precomputed", "kernels", "hits", "misses", "accepted", "rejected", 
+		"sweeps", "io_peak", "io", "precompute", "optimise", "predict", "memory" } ;
+	Smo_Stats * stats = &(settings->stats) ;
+	mxArray * out = mxCreateStructMatrix(1, 1, 13, fields) ;
+	mxArray * io = mxCreateDoubleMatrix(1, stats->io_count, mxREAL) ;
+	double * data = mxGetPr(io) ;
+	unsigned long int i ;
+
+	for (i = 0; i < stats->io_count; i ++)
+		data[i] = (double) stats->io[i] ;
+	mxSetField(out, 0, "precomputed", mxCreateDoubleScalar((double) stats->precomputed)) ;
+	mxSetField(out, 0, "kernels", mxCreateDoubleScalar((double) stats->kernels)) ;
+	mxSetField(out, 0, "hits", mxCreateDoubleScalar((double) stats->hits)) ;
+	mxSetField(out, 0, "misses", mxCreateDoubleScalar((double) stats->misses)) ;
+	mxSetField(out, 0, "accepted", mxCreateDoubleScalar((double) stats->accepted)) ;
+	mxSetField(out, 0, "rejected", mxCreateDoubleScalar((double) stats->rejected)) ;
+	mxSetField(out, 0, "sweeps", mxCreateDoubleScalar((double) stats->sweeps)) ;
+	mxSetField(out, 0, "io_peak", mxCreateDoubleScalar((double) stats->io_peak)) ;
+	mxSetField(out, 0, "io", io) ;
+	mxSetField(out, 0, "precompute", mxCreateDoubleScalar(stats->precompute)) ;
+	mxSetField(out, 0, "optimise", mxCreateDoubleScalar(stats->optimise)) ;
+	mxSetField(out, 0, "predict", mxCreateDoubleScalar(stats->predict)) ;
+	mxSetField(out, 0, "memory", mxCreateDoubleScalar(stats->memory)) ;
+	return out ;
+}
+
 /* mexFunction es la rutina de enlace con el código C. */
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 {
@@ -28,9 +57,9 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
         mexErrMsgTxt("Error. 7 parámetros requeridos => Train , Test , Ko , Co, Normalizar(1: SI, 0:NO), Salidas MexPrintf(1:SI, 0: NO), Kernel Polinómico(1: SI, 0:NO)");
 	}*/
 
-	if(nrhs != 6)
+	if(nrhs < 6 || nrhs > 9)
 	{
-        mexErrMsgTxt("Error. 6 parameters required => Train , Ko , Co, Normalize (1: YES, 0:NO), MexPrintf Outputs (1:YES, 0: NO), Linear kernel (1: YES, 0:NO)");
+        mexErrMsgTxt("Error. 6 to 9 parameters required => Train , Ko , Co, Normalize (1: YES, 0:NO), MexPrintf Outputs (1:YES, 0: NO), Linear kernel (1: YES, 0:NO), [Threads (default 1)], [Initial alphas, samples x 2 (default zeros)], [Training projection (1: YES, 0:NO, default 0)]");
 	}
  
    def_Settings * defsetting = NULL ;
@@ -43,19 +72,20 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 	FILE * log ; 
 	double * guess ;*/
 
-   double ** matBien = NULL;
-   double ** matTrain = NULL;
-   double ** matTest = NULL;
+   double * matTrain = NULL;
    double * data1 = NULL;
 	double * data6 =NULL;
 	
 	//struct estructura * ptr = NULL;	
 	struct estructura e1;
 
-   int aux,aux2;
-   int m,n,contador,i,j;
+   int m,n,i,j;
 	int nFil=0,nFil2=0,nCol=0,nCol2=0;
    double Ko=0, Co=0, Normalizar=0, salidasMexPrintf=0, kPolinomico=0;
+   double nThreads=0, projection=0;
+   mxArray * stats = NULL ;
+   double * alpha0 = NULL;
+   size_t mAlpha0 = 0, nAlpha0 = 0;
 
 	for (i = 0; i < nrhs; i++) /*nrhs: matrices de la parte derecha*/
 	{
@@ -69,59 +99,11 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
             m = mxGetM(prhs[i]);/*numero filas*/ 
             n = mxGetN(prhs[i]);/*numero columnas*/
         				
-            /*Reservo la matriz dinamica MatBien*/  
-            matBien=(double **)calloc(m,sizeof(double *));
-	
-            for(aux=0; aux<m; aux++)
-            {
-                matBien[aux]=(double *)calloc(n,sizeof(double));
-            }
-             		
-           	/* Retrieve the input data */
-    			data1 = mxGetPr(prhs[i]); /*Pointer to the first element of the real data*/
-
-     	   	        
-            /*Recolocacion de la matriz*/
-            contador=0;
-            for(aux=0; aux< n; aux++)
-            {
-                for(aux2=0; aux2 < m; aux2++)
-                {
-                    matBien[aux2][aux]=data1[contador];
-                    contador++;
-                }
-         
-            }
-               
-            if(i==0)/*parametro cero: Matriz train*/
-            {
-
-				nFil=m;
-				nCol=n;
-
+            /* the training matrix is read in place, column-major, by smo_LoadMatrix*/
+            matTrain = mxGetPr(prhs[i]);
+            nFil=m;
+            nCol=n;
 
-                /*Reservo la matriz dinamica MatTrain*/  
-                matTrain=(double **)calloc(m,sizeof(double *));
-	
-                for(aux=0; aux<m; aux++)
-                {
-                    matTrain[aux]=(double *)calloc(n,sizeof(double));
-                } 
-                
-            
-                /*ASIGNACION TRAIN Y COMPROBACION*/
-                
-                for(aux=0; aux<m; aux++)
-                {
-                    for(aux2=0; aux2<n; aux2++)			
-                    {
-                        matTrain[aux][aux2]=matBien[aux][aux2];
-                        /*mexPrintf ("matTrain[%d][%d]=%lf\n",aux,aux2,matTrain[aux][aux2]);*/
-                    }
-                }
-            
-            }
-            
             /*TEST REMOVED if(i==1)*parametro uno: Matriz test
             {
 
@@ -189,18 +171,34 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 
 		 }
 
+		 /* optional: number of threads*/
+        if(i==6)
+		 {
+				data1 = mxGetPr(prhs[i]);
+            nThreads=data1[0]; 
+		 }
+
+		 /* optional: initial alpha_up and alpha_dw per sample, e.g. the fifth output of a previous call scaled by C/C_previous*/
+        if(i==7 && !mxIsEmpty(prhs[i]))
+		 {
+				alpha0 = mxGetPr(prhs[i]);
+            mAlpha0 = mxGetM(prhs[i]); 
+            nAlpha0 = mxGetN(prhs[i]); 
+		 }
+
+		 /* optional: return the projection of the training samples as the third output, empty otherwise*/
+        if(i==8)
+		 {
+				data1 = mxGetPr(prhs[i]);
+            projection=data1[0]; 
+		 }
+
 
 	}
 	
-	/* TEST REMOVED Hack*/
+	/* TEST REMOVED Hack: the first two rows of the training matrix*/
 	nFil2=2;
 	nCol2=nCol;
-     matTest=(double **)calloc(nFil2,sizeof(double *));
-	for(aux=0; aux<nFil2; aux++)
-        matTest[aux]=(double *)calloc(nCol2,sizeof(double));
-     for(aux=0; aux<nFil2; aux++)
-        for(aux2=0; aux2<nCol2; aux2++)
-           matTest[aux][aux2]=matTrain[aux][aux2];
 	/* End Hack*/
 	
 	/* compruebo que las dos matrices tenga el mismo numero de filas y columnas, sino paro */
@@ -251,6 +249,13 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 	if(salidasMexPrintf == 1) //Hemos activados los mexPrintf
 		mexPrintf("  - C at %f.\n", Co) ;       
 
+	if(nThreads >= 1)
+	{
+		defsetting->threads = (unsigned int) nThreads ;
+		if(salidasMexPrintf == 1)
+			mexPrintf("  - %u threads.\n", defsetting->threads) ;
+	}
+
 	if(Normalizar == 1) //Hemos activado la normalización
 	{
 		defsetting->normalized_input = TRUE ;	
@@ -276,19 +281,36 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 	defsetting->training.dimen = defsetting->pairs.dimen ;
 	defsetting->training.featuretype = defsetting->pairs.featuretype ;
 	defsetting->training.datatype = defsetting->pairs.datatype ;
+	/* the matrix is packed and normalized once from the points read in place*/
+	defsetting->training.ld = defsetting->pairs.ld ;
+	defsetting->training.normalized_input = defsetting->pairs.normalized_input ;
+	defsetting->training.x_mean = defsetting->pairs.x_mean ;
+	defsetting->training.x_devi = defsetting->pairs.x_devi ;
 		
 	/* create smosettings*/
          	
 	smosetting = Create_smo_Settings(defsetting) ; 
 	smosetting->pairs = &defsetting->pairs ;  		
+	/* start SMO from the initial alphas if they are given*/
+	if(NULL != alpha0)
+	{
+		if(mAlpha0 == smosetting->pairs->count && nAlpha0 == 2)
+			Assign_Alphas(smosetting->alpha, alpha0, smosetting) ;
+		else
+			mexWarnMsgTxt("The size of initial alphas does not match the training data, SMO starts from zero.") ;
+	}
 	defsetting->training.count = 0 ;		
 	defsetting->training.front = NULL ;		
 	defsetting->training.rear = NULL ;
 	defsetting->training.featuretype = NULL ;
+	defsetting->training.ld = 0 ;
+	defsetting->training.x_mean = NULL ;
+	defsetting->training.x_devi = NULL ;
 		
+	e1.alphas = NULL ;
 	/* load test data*/
 //	if ( FALSE == smo_LoadMatrix(&(defsetting->testdata), defsetting->testfile, defsetting->pairs.dimen, nFil,nCol, matTest) )
-	if ( FALSE == smo_LoadMatrix(&(defsetting->testdata), defsetting->testfile, defsetting->pairs.dimen, nFil2,nCol2, matTest) )
+	if ( FALSE == smo_LoadMatrix(&(defsetting->testdata), defsetting->testfile, defsetting->pairs.dimen, nFil2,nCol2, matTrain,nFil) )
 	{
 		mexPrintf ("No testing data found in the file %s.\n", defsetting->testfile ) ;
 		/*svm_saveresults (&defsetting->pairs, smosetting) ;*/		
@@ -305,7 +327,9 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 		svm_predict (&defsetting->testdata, smosetting) ;		
 		/*TEST REMOVED */
 		/*testTime= (clock()-start)/((double)CLOCKS_PER_SEC);*/
-		e1=svm_saveresults_Matlab (&defsetting->testdata, smosetting) ;
+		e1=svm_saveresults_Matlab (&defsetting->testdata, smosetting, (projection == 1)?TRUE:FALSE) ;
+		if (nlhs > 5)
+			stats = Stats_Struct (smosetting) ;
 
 		if(salidasMexPrintf == 1) //Hemos activados los mexPrintf
 		{
@@ -486,7 +510,30 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
 
 		}
 
+		if(i==4)
+		{
+			/* alpha_up and alpha_dw per sample, to seed a later call*/
+   		plhs[i] = mxCreateDoubleMatrix(e1.dim3, 2, mxREAL);
+   		data6 = mxGetPr(plhs[i]);
+
+			for(j=0; j< 2*e1.dim3; j++)
+			{
+				data6[j] = e1.alphas[j];	
+			}
+		}
+
+		if(i==5)
+		{
+			/* counters and wall times of the solver*/
+			plhs[i] = (NULL != stats) ? stats : mxCreateDoubleMatrix(0, 0, mxREAL);
+		}
+
 	}
+	free(e1.data2);
+	free(e1.data3);
+	free(e1.data4);
+	free(e1.data5);
+	free(e1.alphas);
 
 	/*return 0;*/
 }
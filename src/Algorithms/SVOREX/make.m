@@ -11,14 +11,17 @@ if nargin < 1
         else
           setenv('CFLAGS','-O3 -fstack-protector-strong -Wformat -Werror=format-security')
         end
-        mex -O3 mainSvorex.c alphas.c cachelist.c datalist.c def_settings.c kcv.c loadfile.c ordinal_takestep.c setandfi.c smo_kernel.c smo_routine.c smo_settings.c smo_timer.c svc_predict.c -output svorex
+        mex -O3 -lpthread mainSvorex.c alphas.c cachelist.c datalist.c def_settings.c kcv.c loadfile.c ordinal_takestep.c setandfi.c smo_approx.c smo_kernel.c smo_routine.c smo_settings.c smo_thread.c smo_timer.c svc_predict.c -output svorex
+        mex -O3 -lpthread mainSvorexPredict.c datalist.c smo_approx.c smo_kernel.c smo_thread.c smo_timer.c svc_predict.c -output svorexpredict
         delete *.o
       % This part is for MATLAB
       else
           if ispc
-            mex COMPFLAGS="\$COMPFLAGS -std=c99 -O3" -largeArrayDims mainSvorex.c alphas.c cachelist.c datalist.c def_settings.c kcv.c loadfile.c ordinal_takestep.c setandfi.c smo_kernel.c smo_routine.c smo_settings.c smo_timer.c svc_predict.c -output svorex
+            mex COMPFLAGS="\$COMPFLAGS -std=c99 -O3" -largeArrayDims mainSvorex.c alphas.c cachelist.c datalist.c def_settings.c kcv.c loadfile.c ordinal_takestep.c setandfi.c smo_approx.c smo_kernel.c smo_routine.c smo_settings.c smo_thread.c smo_timer.c svc_predict.c -output svorex
+            mex COMPFLAGS="\$COMPFLAGS -std=c99 -O3" -largeArrayDims mainSvorexPredict.c datalist.c smo_approx.c smo_kernel.c smo_thread.c smo_timer.c svc_predict.c -output svorexpredict
           else
-            mex CFLAGS="\$CFLAGS -std=c99 -O3" -largeArrayDims mainSvorex.c alphas.c cachelist.c datalist.c def_settings.c kcv.c loadfile.c ordinal_takestep.c setandfi.c smo_kernel.c smo_routine.c smo_settings.c smo_timer.c svc_predict.c -output svorex
+            mex CFLAGS="\$CFLAGS -std=c99 -O3" -largeArrayDims -lpthread mainSvorex.c alphas.c cachelist.c datalist.c def_settings.c kcv.c loadfile.c ordinal_takestep.c setandfi.c smo_approx.c smo_kernel.c smo_routine.c smo_settings.c smo_thread.c smo_timer.c svc_predict.c -output svorex
+            mex CFLAGS="\$CFLAGS -std=c99 -O3" -largeArrayDims -lpthread mainSvorexPredict.c datalist.c smo_approx.c smo_kernel.c smo_thread.c smo_timer.c svc_predict.c -output svorexpredict
           end
       end
     catch err
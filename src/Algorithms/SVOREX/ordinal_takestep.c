@@ -78,7 +78,6 @@ BOOL ordinal_cross_identical ( Alphas * alpha1, Alphas * alpha2, unsigned int th
 	double H = 0, L = 0 ;
 	Set_Name name1_up, name1_dw, name2_up, name2_dw ;
 	Alphas * alpha3 = NULL ;
-	Cache_Node * cache = NULL ;
 
 	long unsigned int i1 = 0 ;
 	long unsigned int i2 = 0 ; 
@@ -139,6 +138,9 @@ BOOL ordinal_cross_identical ( Alphas * alpha1, Alphas * alpha2, unsigned int th
 	F1 = alpha1->f_cache ;	
 	F2 = alpha2->f_cache ;		/*/ must update Io & I_LOW & I_UP every accepted step*/
 
+	/*/ bring both rows into the kernel cache before the updates*/
+	Get_Kernel_Row( alpha1, settings ) ;
+	Get_Kernel_Row( alpha2, settings ) ;
 	K11 = Calc_Kernel( alpha1, alpha1, settings ) ; 
 	K12 = Calc_Kernel( alpha1, alpha2, settings ) ;
 	K22 = Calc_Kernel( alpha2, alpha2, settings ) ; 
@@ -209,7 +211,9 @@ BOOL ordinal_cross_identical ( Alphas * alpha1, Alphas * alpha2, unsigned int th
 		alpha1->alpha_dw = n1a ;
 		alpha2->alpha_up = n2 ;
 		alpha2->alpha_dw = n2a ;
+		Update_Weight( alpha1, - alpha1->alpha_up + alpha1->alpha_dw - alpha1->alpha, settings ) ;
 		alpha1->alpha = - alpha1->alpha_up + alpha1->alpha_dw ;		
+		Update_Weight( alpha2, - alpha2->alpha_up + alpha2->alpha_dw - alpha2->alpha, settings ) ;
 		alpha2->alpha = - alpha2->alpha_up + alpha2->alpha_dw ;
 
 		/*/ update mu*/
@@ -348,63 +352,13 @@ BOOL ordinal_cross_identical ( Alphas * alpha1, Alphas * alpha2, unsigned int th
 		}
 
 		/*/ update Fi in Io_Cache and vote B_LOW & B_UP if possible*/
-		cache = Io_CACHE.front ;
-		while ( NULL != cache )
-		{	
-			alpha3 = cache->alpha ;	
-			if ( 0==index[alpha3-ALPHA])
-			{
-				alpha3->f_cache = alpha3->f_cache 
-					- ((alpha2->alpha_up - alpha2->alpha_dw) - (a2 - a2a)) 
-					* Calc_Kernel( alpha2, alpha3, settings ) ;
-				index[alpha3-ALPHA] = 1 ;
-			}
-			
-			if (alpha3->pair->target > 1 )
-			{
-				loop = alpha3->pair->target - 2 ;
-				/*/lower*/
-				if (alpha3->setname_dw==Io_b || alpha3->setname_dw==I_One)
-				{
-					if (alpha3->f_cache-1<settings->bj_up[loop])
-					{
-						settings->bj_up[loop] = alpha3->f_cache-1 ;
-						settings->ij_up[loop] = alpha3 - ALPHA + 1 ;
-					}
-				}
-				if (alpha3->setname_dw==Io_b || alpha3->setname_dw==I_Fou)
-				{
-					if (alpha3->f_cache-1>settings->bj_low[loop])
-					{
-						settings->bj_low[loop] = alpha3->f_cache-1 ;
-						settings->ij_low[loop] = alpha3 - ALPHA + 1 ;
-					}
-				}
-			}
-			if ( alpha3->pair->target < settings->pairs->classes )
-			{
-				loop = alpha3->pair->target - 1 ;
-				/*/upper*/
-				if (alpha3->setname_up==Io_a || alpha3->setname_up==I_Thr)
-				{
-					if (alpha3->f_cache+1<settings->bj_up[loop])
-					{
-						settings->bj_up[loop] = alpha3->f_cache+1 ;
-						settings->ij_up[loop] = alpha3 - ALPHA + 1 ;
-					}
-				}
-				if (alpha3->setname_up==Io_a || alpha3->setname_up==I_Two)
-				{
-					if (alpha3->f_cache+1>settings->bj_low[loop])
-					{
-						settings->bj_low[loop] = alpha3->f_cache+1 ;
-						settings->ij_low[loop] = alpha3 - ALPHA + 1 ;
-					}
-				}
-			}
-			cache = cache->next ;				
-		} /*/ end of while*/
+		Update_Io_Cache( alpha1, 0, 
+			alpha2, - ((alpha2->alpha_up - alpha2->alpha_dw) - (a2 - a2a)), index, settings ) ;
 		
+		/*/ keep f_cache of the other samples up to date as well*/
+		if ( TRUE == settings->fcacheall )
+			Update_Ordinal_Fi( alpha1, 0, alpha2, 
+				- ((alpha2->alpha_up - alpha2->alpha_dw) - (a2 - a2a)), index, settings ) ;
 		free(index) ;
 
 
@@ -565,7 +519,7 @@ BOOL ordinal_cross_takestep ( Alphas * alpha4, Alphas * alpha5, unsigned int thr
 	}
 	if (t2==t1)
 	{
-		if (((double)rand()/(double)RAND_MAX)>0.5)
+		if (urand(&(settings->seed))>0.5)
 	{
 			alpha1 = alpha5 ;
 			alpha2 = alpha4 ;
@@ -908,7 +862,9 @@ BOOL ordinal_cross_takestep ( Alphas * alpha4, Alphas * alpha5, unsigned int thr
 		alpha1->alpha_dw = n1a ;
 		alpha2->alpha_up = n2 ;
 		alpha2->alpha_dw = n2a ;
+		Update_Weight( alpha1, - alpha1->alpha_up + alpha1->alpha_dw - alpha1->alpha, settings ) ;
 		alpha1->alpha = - alpha1->alpha_up + alpha1->alpha_dw ;		
+		Update_Weight( alpha2, - alpha2->alpha_up + alpha2->alpha_dw - alpha2->alpha, settings ) ;
 		alpha2->alpha = - alpha2->alpha_up + alpha2->alpha_dw ;
 
 		// update mu
@@ -1300,7 +1256,6 @@ BOOL ordinal_takestep ( Alphas * alpha1, Alphas * alpha2, unsigned int threshold
 	double ObjH = 0, ObjL = 0 ;
 	Set_Name name1_up, name1_dw, name2_up, name2_dw ;
 	Alphas * alpha3 = NULL ;
-	Cache_Node * cache = NULL ;
 
 	long unsigned int i1 = 0 ;
 	long unsigned int i2 = 0 ; 
@@ -1361,6 +1316,9 @@ BOOL ordinal_takestep ( Alphas * alpha1, Alphas * alpha2, unsigned int threshold
 	F1 = alpha1->f_cache ;	
 	F2 = alpha2->f_cache ;		/*/ must update Io & I_LOW & I_UP every accepted step*/
 
+	/*/ bring both rows into the kernel cache before the updates*/
+	Get_Kernel_Row( alpha1, settings ) ;
+	Get_Kernel_Row( alpha2, settings ) ;
 	K11 = Calc_Kernel( alpha1, alpha1, settings ) ; 
 	K12 = Calc_Kernel( alpha1, alpha2, settings ) ;
 	K22 = Calc_Kernel( alpha2, alpha2, settings ) ; 
@@ -1553,7 +1511,9 @@ BOOL ordinal_takestep ( Alphas * alpha1, Alphas * alpha2, unsigned int threshold
 		alpha1->alpha_dw = n1a ;
 		alpha2->alpha_up = n2 ;
 		alpha2->alpha_dw = n2a ;
+		Update_Weight( alpha1, - alpha1->alpha_up + alpha1->alpha_dw - alpha1->alpha, settings ) ;
 		alpha1->alpha = - alpha1->alpha_up + alpha1->alpha_dw ;		
+		Update_Weight( alpha2, - alpha2->alpha_up + alpha2->alpha_dw - alpha2->alpha, settings ) ;
 		alpha2->alpha = - alpha2->alpha_up + alpha2->alpha_dw ;
 
 		/*/ update Set & Cache_List  */
@@ -1776,66 +1736,13 @@ if (settings->ij_low[loop-1]!=0)
 		}
 				
 		/*/ update Fi in Io_Cache and vote B_LOW & B_UP if possible*/
-		cache = Io_CACHE.front ;
-		while ( NULL != cache )
-		{	
-			alpha3 = cache->alpha ;
-
-			if ( 0==index[alpha3-ALPHA])
-			{
-				alpha3->f_cache = alpha3->f_cache - ((alpha1->alpha_up - alpha1->alpha_dw) - (a1 - a1a)) 
-				* Calc_Kernel( alpha1, alpha3, settings ) 
-				- ((alpha2->alpha_up - alpha2->alpha_dw) - (a2 - a2a)) 
-				* Calc_Kernel( alpha2, alpha3, settings ) ;
-				index[alpha3-ALPHA]=1 ;
-			}			
-			
-			if (alpha3->pair->target > 1 )
-			{
-				loop = alpha3->pair->target - 2 ;
-				
-				if (alpha3->setname_dw==Io_b || alpha3->setname_dw==I_One)
-				{
-					if (alpha3->f_cache-1<settings->bj_up[loop])
-					{
-						settings->bj_up[loop] = alpha3->f_cache-1 ;
-						settings->ij_up[loop] = alpha3 - ALPHA + 1 ;
-					}
-				}
-				if (alpha3->setname_dw==Io_b || alpha3->setname_dw==I_Fou)
-				{
-					if (alpha3->f_cache-1>settings->bj_low[loop])
-					{
-						settings->bj_low[loop] = alpha3->f_cache-1 ;
-						settings->ij_low[loop] = alpha3 - ALPHA + 1 ;
-					}
-				}
-			}
-
-			if ( alpha3->pair->target < settings->pairs->classes )
-			{
-				loop = alpha3->pair->target - 1 ;
-
-				if (alpha3->setname_up==Io_a || alpha3->setname_up==I_Thr)
-				{
-					if (alpha3->f_cache+1<settings->bj_up[loop])
-					{
-						settings->bj_up[loop] = alpha3->f_cache+1 ;
-						settings->ij_up[loop] = alpha3 - ALPHA + 1 ;
-					}
-				}
-				if (alpha3->setname_up==Io_a || alpha3->setname_up==I_Two)
-				{
-					if (alpha3->f_cache+1>settings->bj_low[loop])
-					{
-						settings->bj_low[loop] = alpha3->f_cache+1 ;
-						settings->ij_low[loop] = alpha3 - ALPHA + 1 ;
-					}
-				}
-			}
-			cache = cache->next ;				
-		} /*/ end of while*/
+		Update_Io_Cache( alpha1, - ((alpha1->alpha_up - alpha1->alpha_dw) - (a1 - a1a)), 
+			alpha2, - ((alpha2->alpha_up - alpha2->alpha_dw) - (a2 - a2a)), index, settings ) ;
 		
+		/*/ keep f_cache of the other samples up to date as well*/
+		if ( TRUE == settings->fcacheall )
+			Update_Ordinal_Fi( alpha1, - ((alpha1->alpha_up - alpha1->alpha_dw) - (a1 - a1a)), 
+				alpha2, - ((alpha2->alpha_up - alpha2->alpha_dw) - (a2 - a2a)), index, settings ) ;
 		free(index) ;
 
 		for (loop = 1 ; loop < settings->pairs->classes ; loop ++)
@@ -1939,7 +1846,6 @@ BOOL ordinal_cross_takestep ( Alphas * Bup, unsigned int b1, Alphas * Blow, unsi
 	Alphas * alpha1 = NULL ;
 	Alphas * alpha2 = NULL ;
 	Alphas * alpha3 = NULL ;
-	Cache_Node * cache = NULL ;
 
 	long unsigned int i1 = 0 ;
 	long unsigned int i2 = 0 ; 
@@ -2087,6 +1993,9 @@ BOOL ordinal_cross_takestep ( Alphas * Bup, unsigned int b1, Alphas * Blow, unsi
 	F1 = alpha1->f_cache ;	
 	F2 = alpha2->f_cache ;		/*/ must update Io & I_LOW & I_UP every accepted step*/
 
+	/*/ bring both rows into the kernel cache before the updates*/
+	Get_Kernel_Row( alpha1, settings ) ;
+	Get_Kernel_Row( alpha2, settings ) ;
 	K11 = Calc_Kernel( alpha1, alpha1, settings ) ; 
 	K12 = Calc_Kernel( alpha1, alpha2, settings ) ;
 	K22 = Calc_Kernel( alpha2, alpha2, settings ) ; 
@@ -2311,7 +2220,9 @@ BOOL ordinal_cross_takestep ( Alphas * Bup, unsigned int b1, Alphas * Blow, unsi
 		alpha1->alpha_dw = n1a ;
 		alpha2->alpha_up = n2 ;
 		alpha2->alpha_dw = n2a ;
+		Update_Weight( alpha1, - alpha1->alpha_up + alpha1->alpha_dw - alpha1->alpha, settings ) ;
 		alpha1->alpha = - alpha1->alpha_up + alpha1->alpha_dw ;		
+		Update_Weight( alpha2, - alpha2->alpha_up + alpha2->alpha_dw - alpha2->alpha, settings ) ;
 		alpha2->alpha = - alpha2->alpha_up + alpha2->alpha_dw ;
 
 		/*/ update mu*/
@@ -2534,64 +2445,13 @@ BOOL ordinal_cross_takestep ( Alphas * Bup, unsigned int b1, Alphas * Blow, unsi
 		}			
 
 		/*/ update Fi in Io_Cache and vote B_LOW & B_UP if possible*/
-		cache = Io_CACHE.front ;
-		while ( NULL != cache )
-		{	
-			alpha3 = cache->alpha ;	
-			if ( 0==index[alpha3-ALPHA])
-			{
-				alpha3->f_cache = alpha3->f_cache - ((alpha1->alpha_up - alpha1->alpha_dw) - (a1 - a1a)) 
-				* Calc_Kernel( alpha1, alpha3, settings ) 
-				- ((alpha2->alpha_up - alpha2->alpha_dw) - (a2 - a2a)) 
-				* Calc_Kernel( alpha2, alpha3, settings ) ;
-				index[alpha3-ALPHA] = 1 ;
-			}
-			
-			if (alpha3->pair->target > 1 )
-			{
-				loop = alpha3->pair->target - 2 ;
-
-				if (alpha3->setname_dw==Io_b || alpha3->setname_dw==I_One)
-				{
-					if (alpha3->f_cache-1<settings->bj_up[loop])
-					{
-						settings->bj_up[loop] = alpha3->f_cache-1 ;
-						settings->ij_up[loop] = alpha3 - ALPHA + 1 ;
-					}
-				}
-				if (alpha3->setname_dw==Io_b || alpha3->setname_dw==I_Fou)
-				{
-					if (alpha3->f_cache-1>settings->bj_low[loop])
-					{
-						settings->bj_low[loop] = alpha3->f_cache-1 ;
-						settings->ij_low[loop] = alpha3 - ALPHA + 1 ;
-					}
-				}
-			}
-			if ( alpha3->pair->target < settings->pairs->classes )
-			{
-				loop = alpha3->pair->target - 1 ;
-			
-				if (alpha3->setname_up==Io_a || alpha3->setname_up==I_Thr)
-				{
-					if (alpha3->f_cache+1<settings->bj_up[loop])
-					{
-						settings->bj_up[loop] = alpha3->f_cache+1 ;
-						settings->ij_up[loop] = alpha3 - ALPHA + 1 ;
-					}
-				}
-				if (alpha3->setname_up==Io_a || alpha3->setname_up==I_Two)
-				{
-					if (alpha3->f_cache+1>settings->bj_low[loop])
-					{
-						settings->bj_low[loop] = alpha3->f_cache+1 ;
-						settings->ij_low[loop] = alpha3 - ALPHA + 1 ;
-					}
-				}
-			}
-			cache = cache->next ;				
-		} /*/ end of while*/
+		Update_Io_Cache( alpha1, - ((alpha1->alpha_up - alpha1->alpha_dw) - (a1 - a1a)), 
+			alpha2, - ((alpha2->alpha_up - alpha2->alpha_dw) - (a2 - a2a)), index, settings ) ;
 		
+		/*/ keep f_cache of the other samples up to date as well*/
+		if ( TRUE == settings->fcacheall )
+			Update_Ordinal_Fi( alpha1, - ((alpha1->alpha_up - alpha1->alpha_dw) - (a1 - a1a)), 
+				alpha2, - ((alpha2->alpha_up - alpha2->alpha_dw) - (a2 - a2a)), index, settings ) ;
 		free(index) ;
 
 
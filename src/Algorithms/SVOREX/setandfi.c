@@ -26,6 +26,250 @@
 
 #define PI				(3.141592654)
 
+typedef struct _Fi_Task
+{
+	smo_Settings * settings ;
+	Alphas * ai ;
+	BOOL ordinal ;
+	double * partial ;              /*/ one partial sum per block*/
+
+} Fi_Task ;
+
+/*/ serial sum of the kernel expansion at ai over the samples [begin,end)*/
+static double Sum_Fi ( Alphas * ai, unsigned long int begin, unsigned long int end, BOOL ordinal, smo_Settings * settings )
+{
+	Alphas * aj ;
+	double Fi = 0 ;
+	unsigned long int j ;
+
+	for ( j = begin ; j < end ; j ++ )
+	{		
+		aj = ALPHA + j ;
+		if ( aj->alpha != 0 )
+		{
+			if ( TRUE == ordinal )
+				Fi = Fi + (-aj->alpha_up+aj->alpha_dw) * Calc_Kernel( aj, ai, settings ) ;
+			else
+				Fi = Fi + (aj->alpha) * Calc_Kernel( aj, ai, settings ) ;
+		}
+	}
+	return Fi ;
+}
+
+static void Task_Fi ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	Fi_Task * task = (Fi_Task *) arg ;
+	task->partial[block] = Sum_Fi( task->ai, begin, end, task->ordinal, task->settings ) ;
+}
+
+/*******************************************************************************\
+
+	double Linear_Fi ( Alphas * ai, smo_Settings * settings )
+	
+	Fi of ai for the linear kernel in primal form, i.e. the product of the 
+	weight vector with the packed input of ai. the jitter of 0.001 on the 
+	diagonal of the kernel only adds the own term of ai.
+	input:  the pointer to alpha and the pointer to smo_Settings 
+	output: the value of Fi
+
+\*******************************************************************************/
+
+double Linear_Fi ( Alphas * ai, smo_Settings * settings )
+{
+	return Matrix_Kernel( &(MATRIX), LINEAR, P, settings->weight, MATRIX.x + (ai-ALPHA)*MATRIX.stride ) 
+		+ 0.001 * ai->alpha ;
+}
+
+/*******************************************************************************\
+
+	void Update_Weight ( Alphas * alpha, double d, smo_Settings * settings )
+	
+	add d times the packed input of alpha to the weight vector, if the linear 
+	kernel is kept in primal form. it is called whenever alpha->alpha changes 
+	by d, so that the weight vector follows the alphas in O(dimen).
+	input:  the pointer to alpha, the change of its coefficient and the pointer to smo_Settings 
+	output: none
+
+\*******************************************************************************/
+
+void Update_Weight ( Alphas * alpha, double d, smo_Settings * settings )
+{
+	double * x ;
+	unsigned int k ;
+
+	if ( NULL == settings->weight || 0 == d )
+		return ;
+	x = MATRIX.x + (alpha-ALPHA)*MATRIX.stride ;
+	for ( k = 0 ; k < MATRIX.cont ; k ++ )
+		settings->weight[k] = settings->weight[k] + d * x[k] ;
+}
+
+/*/ Fi of ai from scratch, by the weight vector if the kernel is linear*/
+static double Ordinal_Fi ( Alphas * ai, smo_Settings * settings )
+{
+	if ( NULL != settings->weight )
+		return Linear_Fi( ai, settings ) ;
+	return Sum_Fi( ai, 0, MATRIX.count, TRUE, settings ) ;
+}
+
+static void Task_Refresh_Fi ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	smo_Settings * settings = (smo_Settings *) arg ;
+	unsigned long int i ;
+
+	for ( i = begin ; i < end ; i ++ )
+		(ALPHA + i)->f_cache = Ordinal_Fi( ALPHA + i, settings ) ;
+}
+
+/*/ sum over all samples, split into one fixed block per thread if it pays off.
+	the blocks are added up in order, so the result does not depend on timing*/
+static double Parallel_Sum_Fi ( Alphas * ai, BOOL ordinal, smo_Settings * settings )
+{
+	Fi_Task task ;
+	unsigned long int chunk, b ;
+	unsigned int threads = Thread_Pool_Size( POOL ) ;
+	double Fi = 0 ;
+
+	if ( threads <= 1 || MATRIX.count < MINPARALLEL )
+		return Sum_Fi( ai, 0, MATRIX.count, ordinal, settings ) ;
+
+	chunk = (MATRIX.count + threads - 1) / threads ;
+	task.settings = settings ;
+	task.ai = ai ;
+	task.ordinal = ordinal ;
+	task.partial = (double *) calloc(threads, sizeof(double)) ;
+	if ( NULL == task.partial )
+		return Sum_Fi( ai, 0, MATRIX.count, ordinal, settings ) ;
+	Run_Thread_Pool( POOL, MATRIX.count, chunk, Task_Fi, &task ) ;
+	for ( b = 0 ; b < threads ; b ++ )
+		Fi = Fi + task.partial[b] ;
+	free( task.partial ) ;
+	return Fi ;
+}
+
+/*******************************************************************************
+	void Refresh_Ordinal_Fi ( smo_Settings * settings )
+	
+	recalculate f_cache of all samples from the current alphas, in parallel 
+	over the samples if a thread pool is available. the weight vector of the 
+	linear kernel is rebuilt from the alphas first.
+	input:  the pointer to smo_Settings 
+	output: none
+
+\*******************************************************************************/
+
+void Refresh_Ordinal_Fi ( smo_Settings * settings )
+{
+	unsigned int threads = Thread_Pool_Size( POOL ) ;
+	unsigned long int i ;
+
+	if ( NULL != settings->weight )
+	{
+		memset( settings->weight, 0, MATRIX.cont*sizeof(double) ) ;
+		for ( i = 0 ; i < MATRIX.count ; i ++ )
+			Update_Weight( ALPHA + i, (ALPHA + i)->alpha, settings ) ;
+	}
+	Run_Thread_Pool( POOL, MATRIX.count, max(1, MATRIX.count/(8*threads)), Task_Refresh_Fi, settings ) ;
+}
+
+typedef struct _Update_Task
+{
+	smo_Settings * settings ;
+	Alphas * alpha1 ;
+	Alphas * alpha2 ;
+	double d1 ;
+	double d2 ;
+	int * index ;
+} Update_Task ;
+
+static void Task_Update_Fi ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	Update_Task * task = (Update_Task *) arg ;
+	smo_Settings * settings = task->settings ;
+	Alphas * aj ;
+	unsigned long int j ;
+
+	for ( j = begin ; j < end ; j ++ )
+	{
+		if ( NULL != task->index && 0 != task->index[j] )
+			continue ;
+		aj = ALPHA + j ;
+		if ( TRUE == aj->shrunk )
+			continue ;
+		if ( 0 != task->d1 )
+			aj->f_cache = aj->f_cache + task->d1 * Calc_Kernel( task->alpha1, aj, settings ) ;
+		if ( 0 != task->d2 )
+			aj->f_cache = aj->f_cache + task->d2 * Calc_Kernel( task->alpha2, aj, settings ) ;
+	}
+}
+
+/*******************************************************************************\
+
+	void Update_Ordinal_Fi ( Alphas * alpha1, double d1, Alphas * alpha2, double d2, int * index, smo_Settings * settings )
+	
+	add d1*K(x1,x)+d2*K(x2,x) to f_cache of every sample whose index is 0, i.e. 
+	the samples that the takestep did not update itself. with fcacheall the 
+	takesteps call it so that f_cache is valid for all samples, as libsvm 
+	keeps its gradient, and examine_example needs no Calculate_Ordinal_Fi.
+	the kernel rows of alpha1 and alpha2 are fetched by the takestep already.
+	input:  the two updated alphas and the changes of their coefficients, 
+	        the flags of updated samples (or NULL), and the pointer to smo_Settings 
+	output: none
+
+\*******************************************************************************/
+
+void Update_Ordinal_Fi ( Alphas * alpha1, double d1, Alphas * alpha2, double d2, int * index, smo_Settings * settings )
+{
+	Update_Task task ;
+	unsigned int threads = Thread_Pool_Size( POOL ) ;
+
+	task.settings = settings ;
+	task.alpha1 = alpha1 ;
+	task.alpha2 = alpha2 ;
+	task.d1 = d1 ;
+	task.d2 = d2 ;
+	task.index = index ;
+	if ( threads <= 1 || MATRIX.count < MINPARALLEL )
+		Task_Update_Fi( &task, 0, MATRIX.count, 0 ) ;
+	else
+		Run_Thread_Pool( POOL, MATRIX.count, (MATRIX.count + threads - 1)/threads, Task_Update_Fi, &task ) ;
+}
+
+static void Task_Unshrink_Fi ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	smo_Settings * settings = (smo_Settings *) arg ;
+	unsigned long int i ;
+
+	for ( i = begin ; i < end ; i ++ )
+	{
+		if ( TRUE == (ALPHA + i)->shrunk )
+			(ALPHA + i)->f_cache = Ordinal_Fi( ALPHA + i, settings ) ;
+	}
+}
+
+/*******************************************************************************\
+
+	void Unshrink_Alphas ( smo_Settings * settings )
+	
+	bring the shrunk samples back into the sweeps. with fcacheall their 
+	f_cache has not been updated while they were shrunk, so that it is 
+	recalculated from the current alphas first, in parallel over the samples.
+	input:  the pointer to smo_Settings 
+	output: none
+
+\*******************************************************************************/
+
+void Unshrink_Alphas ( smo_Settings * settings )
+{
+	unsigned int threads = Thread_Pool_Size( POOL ) ;
+	unsigned long int i ;
+
+	if ( TRUE == settings->fcacheall )
+		Run_Thread_Pool( POOL, MATRIX.count, max(1, MATRIX.count/(8*threads)), Task_Unshrink_Fi, settings ) ;
+	for ( i = 0 ; i < MATRIX.count ; i ++ )
+		(ALPHA + i)->shrunk = FALSE ;
+}
+
 /*******************************************************************************\
 
 	double Calculate_Fi ( long unsigned int i, smo_Settings * settings )
@@ -39,11 +283,7 @@
 double Calculate_Fi ( long unsigned int i, smo_Settings * settings )/*/ i is index here*/
 {
 	Alphas * ai ;
-	Alphas * aj ;
-	Data_Node * Pi ;
-	Data_Node * Pj ;
     double Fi = 0 ;
-	long unsigned int j = 0 ;	
 
 	
 	if ( NULL == settings || i <= 0 )
@@ -59,26 +299,11 @@ double Calculate_Fi ( long unsigned int i, smo_Settings * settings )/*/ i is ind
 	}
 
 	ai = ALPHA + i - 1 ;
-	Pi = ai->pair ;
-	Pj = settings->pairs->front ;
-	
-	while ( Pj != NULL )
-	{		
-		aj = ALPHA + j ;
-		if ( aj->alpha != 0 )
-			Fi = Fi + (aj->alpha) * Calc_Kernel( aj, ai, settings ) ;
-		Pj = Pj->next ;
-		j++ ;
-	}
+	Fi = Parallel_Sum_Fi( ai, FALSE, settings ) ;
 
 	/*/ai->pair->guess = Fi ;*/
 
-#ifdef SMO_DEBUG
-	if ( j != settings->pairs->count ) 
-		printf ( "Error in Calculate Fi \n" ) ;
-#endif
-
-	Fi = Pi->target - Fi ;
+	Fi = MATRIX.target[i-1] - Fi ;
 
 	return Fi ;
 
@@ -88,11 +313,7 @@ double Calculate_Fi ( long unsigned int i, smo_Settings * settings )/*/ i is ind
 double Calculate_Ordinal_Fi ( long unsigned int i, smo_Settings * settings )/*/ i is index here*/
 {
 	Alphas * ai ;
-	Alphas * aj ;
-	Data_Node * Pi ;
-	Data_Node * Pj ;
     double Fi = 0 ;
-	long unsigned int j = 0 ;	
 
 	if ( NULL == settings || i <= 0 )
 	{
@@ -107,22 +328,10 @@ double Calculate_Ordinal_Fi ( long unsigned int i, smo_Settings * settings )/*/
 	}
 
 	ai = ALPHA + i - 1 ;
-	Pi = ai->pair ;
-	Pj = settings->pairs->front ;
-	
-	while ( Pj != NULL )
-	{		
-		aj = ALPHA + j ;
-		if ( aj->alpha != 0 )
-			Fi = Fi + (-aj->alpha_up+aj->alpha_dw) * Calc_Kernel( aj, ai, settings ) ;
-		Pj = Pj->next ;
-		j++ ;
-	}
-
-#ifdef _ORDINAL_DEBUG
-	if ( j != settings->pairs->count ) 
-		printf ( "Error in Calculate Fi \n" ) ;
-#endif
+	if ( NULL != settings->weight )
+		Fi = Linear_Fi( ai, settings ) ;
+	else
+		Fi = Parallel_Sum_Fi( ai, TRUE, settings ) ;
 	return Fi ;
 
 } /*/ end of Caculate_Ordinal_Fi*/
@@ -37,6 +37,16 @@ typedef enum _BOOL
 
 #define MINNUM          (2)			/* at least two*/
 #define LENGTH          (307200)		/* maximum value of line length in data file */
+#define LOADCHUNK       (1<<22)		/* bytes of data file parsed by one thread */
+#define ROWALIGN        (8)			/* blocks of Data_Matrix rows are padded to this many doubles */
+#define PROGRESS        (1000)		/* takesteps between two calls of the progress callback */
+
+/* add n to a counter that the worker threads may share, see smo_thread.c*/
+#ifdef _WIN32
+#define COUNT_ADD(counter, n)  ((counter) += (n))	/* the thread pool runs serially*/
+#else
+#define COUNT_ADD(counter, n)  __atomic_fetch_add( &(counter), (n), __ATOMIC_RELAXED )
+#endif
 
 struct estructura
 {
@@ -46,6 +56,7 @@ struct estructura
 	double * data3;
 	double * data4;
 	double * data5;
+	double * alphas;
 
 };
 
@@ -86,6 +97,14 @@ typedef enum _Kernel_Name
 
 } Kernel_Name ;
 
+typedef enum _Approx_Name
+{
+	EXACT = 0 ,	
+	NYSTROM = 1 ,
+	FOURIER = 2 ,
+
+} Approx_Name ;
+
 typedef enum _Training_Method
 {
 	BAYESIAN = 1 ,
@@ -128,26 +147,139 @@ typedef struct _Data_List
 	double * x_devi ;				/*/ standard deviation of input*/
 	Data_Node * front ;             /*/ point to first node in the list*/
 	Data_Node * rear ;              /*/ point to last node in the list*/
+	double * block ;                /*/ one block holding the points of all nodes, or NULL if each node owns its point*/
+	unsigned long int ld ;          /*/ if not 0, the points are read in place from a column-major matrix whose columns are ld apart*/
 
 } Data_List ;
 
-typedef struct _Cache_Node
+typedef struct _Data_Matrix 
 {
-	double new_Fi ;
-	struct _Alphas * alpha ;
-	struct _Cache_Node * previous ;
-	struct _Cache_Node * next ;
+	unsigned long int count ;       /*/ number of rows, i.e. samples*/
+	unsigned int dimen ;            /*/ dimension of input vector*/
+	unsigned int stride ;           /*/ row length of x in doubles, cont+cat*/
+	unsigned int numeric ;          /*/ number of continuous inputs*/
+	unsigned int cont ;             /*/ padded length of the continuous block, first in a row*/
+	unsigned int cat ;              /*/ padded length of the categorical block, after it*/
+	unsigned int * column ;         /*/ input column of each packed column, numeric ones first*/
+	double * scale ;                /*/ factor applied to each continuous column*/
+	double * weight ;               /*/ kernel weight of each categorical column, 0 on padding*/
+	double sumweight ;              /*/ sum of weight*/
+	BOOL scaled ;                   /*/ TRUE once scale and weight hold the kernel factors*/
+	double * x ;                    /*/ aligned row-major block of count*stride inputs*/
+	unsigned int * target ;         /*/ targets, parallel to the rows of x*/
+	int * fold ;                    /*/ folds, parallel to the rows of x*/
+
+} Data_Matrix ;
+
+/*/ kernel evaluations instantiated for one kernel type and order, with or 
+/ without categorical inputs, see Get_Kernel_Ops*/
+typedef struct _Kernel_Ops
+{
+	double (* pair) ( Data_Matrix * matrix, unsigned int p, double * pi, double * pj ) ;
+	void (* row) ( Data_Matrix * matrix, unsigned int p, double * pi, unsigned long int begin, unsigned long int end, double * row ) ;
+	double (* sum) ( Data_Matrix * matrix, unsigned int p, double * pi, double * coef, unsigned long int begin, unsigned long int end, double sum ) ;
+
+} Kernel_Ops ;
 
-} Cache_Node ;
+/*/ low-rank feature map approximating the kernel, see smo_approx.c*/
+typedef struct _Feature_Map
+{
+	Approx_Name approx ;            /*/ NYSTROM or FOURIER*/
+	unsigned int rank ;             /*/ number of features*/
+	Data_Matrix input ;             /*/ layout of the packed inputs, rows are the landmarks or the frequencies*/
+	unsigned int p ;                /*/ order of the polynomial kernel*/
+	const Kernel_Ops * kops ;       /*/ of the kernel for NYSTROM, of the linear one for FOURIER*/
+	double * factor ;               /*/ NYSTROM: rank x rank Cholesky factor of the landmark kernel*/
+	double * phase ;                /*/ FOURIER: rank phases*/
+
+} Feature_Map ;
+
+typedef struct _Svor_Model 
+{
+	Data_Matrix matrix ;            /*/ packed and scaled inputs of the support vectors only*/
+	double * coef ;                 /*/ alpha_up-alpha_dw of each support vector*/
+	double * biasj ;                /*/ the classes-1 thresholds*/
+	unsigned int classes ;
+	Kernel_Name kernel ;
+	unsigned int p ;
+	double kappa ;
+	double * ard ;                  /*/ ARD weights, already folded into matrix.scale and matrix.weight*/
+	double * x_mean ;               /*/ mean of the training inputs, NULL if they were not normalized*/
+	double * x_devi ;               /*/ deviation of the training inputs*/
+	void * map ;                    /*/ model file holding all the arrays above, NULL if they are allocated*/
+	unsigned long int mapsize ;
+
+} Svor_Model ;
+
+/*/ sections of a binary model file, each one starting at a multiple of MODELALIGN*/
+typedef enum _Model_Section 
+{
+	MODEL_COLUMN = 0,               /*/ dimen unsigned int, see Data_Matrix.column*/
+	MODEL_SCALE ,                   /*/ cont doubles*/
+	MODEL_WEIGHT ,                  /*/ cat doubles*/
+	MODEL_ARD ,                     /*/ dimen doubles*/
+	MODEL_MEAN ,                    /*/ dimen doubles if normalized*/
+	MODEL_DEVI ,                    /*/ dimen doubles if normalized*/
+	MODEL_BIASJ ,                   /*/ classes-1 doubles*/
+	MODEL_COEF ,                    /*/ count doubles*/
+	MODEL_X ,                       /*/ count*stride doubles, packed and scaled*/
+	MODEL_SECTIONS ,
+
+} Model_Section ;
+
+/*/ header at the start of a binary model file, written in the native byte order*/
+typedef struct _Model_Header 
+{
+	char magic[8] ;                 /*/ MODEL_MAGIC*/
+	unsigned int version ;          /*/ MODEL_VERSION of the writer*/
+	unsigned int order ;            /*/ MODEL_ORDER, to detect another byte order*/
+	unsigned int kernel ;
+	unsigned int p ;
+	unsigned int classes ;
+	unsigned int dimen ;
+	unsigned int numeric ;
+	unsigned int cont ;
+	unsigned int cat ;
+	unsigned int stride ;
+	unsigned int normalized ;      /*/ 1 if MODEL_MEAN and MODEL_DEVI are present*/
+	unsigned int reserved ;
+	double kappa ;
+	double sumweight ;
+	unsigned long long count ;      /*/ number of support vectors*/
+	unsigned long long size ;       /*/ size of the file in bytes*/
+	unsigned long long offset[MODEL_SECTIONS] ;
+
+} Model_Header ;
 
 typedef struct _Cache_List 
 {
 	long unsigned int count ;
-	Cache_Node * front ;
-	Cache_Node * rear ;
+	long unsigned int size ;        /*/ allocated length of member*/
+	struct _Alphas ** member ;      /*/ the alphas in Io packed, the latest one at the end*/
 	
 } Cache_List ;
 
+typedef struct _Kernel_Cache
+{
+	unsigned long int count ;       /*/ length of one kernel row, i.e. samples*/
+	unsigned long int size ;        /*/ maximum number of rows kept in the cache*/
+	unsigned long int used ;        /*/ number of rows allocated so far*/
+	double ** row ;                 /*/ row[i] is the i-th kernel row or NULL if not cached*/
+	long int * prev ;               /*/ LRU links among the cached rows */
+	long int * next ;               
+	long int head ;                 /*/ most recently used row*/
+	long int tail ;                 /*/ least recently used row, evicted first*/
+
+} Kernel_Cache ;
+
+typedef struct _Thread_Pool Thread_Pool ;	/*/ opaque, see smo_thread.c*/
+typedef struct _Smo_Timer
+{
+	double start ;                  /*/ CPU time of the calling thread at tstart*/
+	double end ;                    /*/ CPU time of the calling thread at tend*/
+} Smo_Timer ;
+typedef void (* Thread_Task) ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block ) ;
+
 typedef struct _Alphas
 {
 	double alpha ;
@@ -159,13 +291,38 @@ typedef struct _Alphas
 	/*/unsigned int cache_offset ;     // the offset in kernel cache matrix*/
 	/*/unsigned long int update_count ;// the count for entering the takestep*/
 	Data_Node * pair ;              /*/ point to the corresponding pair */
-	Cache_Node * cache ;            /*/ point to the Node in Cache List */
+	long unsigned int cache ;       /*/ position in Cache List plus 1, 0 if not in Io */
 	/*/Set_Name setname ;				// Set Name */
 	Set_Name setname_up ;           /*/ Set Name for ORDINAL*/ 
 	Set_Name setname_dw ;              
+	BOOL shrunk ;                   /*/ left out of the sweeps by shrinking*/
 
 } Alphas ;
 
+typedef struct _Smo_Stats
+{
+	unsigned long int precomputed ; /*/ kernel evaluations before SMO, for cacheall or secondorder*/
+	unsigned long int kernels ;     /*/ kernel evaluations in the last SMO*/
+	unsigned long int hits ;        /*/ kernel rows found in the bounded cache*/
+	unsigned long int misses ;      /*/ kernel rows computed for the bounded cache*/
+	unsigned long int accepted ;    /*/ takesteps that updated a pair*/
+	unsigned long int rejected ;    /*/ takesteps that failed*/
+	unsigned long int sweeps ;      /*/ examineAll sweeps*/
+	unsigned long int io_peak ;     /*/ the largest size of Io*/
+	unsigned long int io_count ;    /*/ number of samples in io*/
+	unsigned long int io_size ;     /*/ allocated length of io*/
+	unsigned long int * io ;        /*/ size of Io at every sweep and every PROGRESS steps*/
+	double precompute ;             /*/ wall time of the feature map and the kernel precompute*/
+	double optimise ;               /*/ wall time of the last SMO*/
+	double predict ;                /*/ wall time of the last svm_predict*/
+	double memory ;                 /*/ peak resident memory of the process in MB, 0 if unknown*/
+
+} Smo_Stats ;
+
+/*/ called in SMO after every sweep and every PROGRESS steps, SMO stops if it returns FALSE*/
+struct _smo_Settings ;
+typedef BOOL (* Smo_Progress) ( struct _smo_Settings * settings, void * arg ) ;
+
 
 typedef struct _smo_Settings
 {
@@ -185,10 +342,24 @@ typedef struct _smo_Settings
 	Kernel_Name kernel ;            /*/ Kernel Type*/
 	unsigned int p ;                /*/ Polynomial Power*/
 	double kappa ;					/*/ Sigma square is Gaussian kernel	*/
+	const Kernel_Ops * kops ;       /*/ kernel evaluations of kernel and p on matrix*/
 
 	struct _Alphas * alpha ;		/*/ Pointers to Alphas matrix */
 	struct _Cache_List io_cache ;	/*/ Head of Cache List*/
 	struct _Data_List * pairs ;		/*/ this is a reference from def_Settings*/
+	struct _Data_Matrix matrix ;	/*/ packed copy of pairs indexed by alpha*/
+	struct _Kernel_Cache kcache ;	/*/ bounded cache of kernel rows if not cacheall*/
+	double * weight ;				/*/ sum of alpha*x over MATRIX for the linear kernel, otherwise NULL*/
+	BOOL primal ;					/*/ no kernel cache, f_cache is recalculated from weight*/
+	struct _Thread_Pool * pool ;	/*/ worker threads, NULL if serial*/
+	unsigned int threads ;			/*/ size of the thread pool*/
+	struct _Feature_Map * fmap ;	/*/ map of the inputs packed in MATRIX for an approximate kernel, otherwise NULL*/
+	double map_timing ;				/*/ CPU time of the map, charged to the next smo_timing*/
+	BOOL secondorder ;				/*/ choose the partner of a working pair by the second-order gain*/
+	double * diag ;					/*/ kernel diagonal with the jitter if secondorder, otherwise NULL*/
+	Smo_Stats stats ;				/*/ counters and wall times of the solver, see Save_Smo_Stats*/
+	Smo_Progress progress ;			/*/ progress callback, or NULL*/
+	void * progress_arg ;			/*/ the argument passed to progress*/
 	
 	Method_Name method ;            /*/ Heuristic Methods */
 
@@ -215,8 +386,14 @@ typedef struct _smo_Settings
 	char * inputfile ;				/*/ the name of input data file */
 	char * dumpingfile ;			/*/ the name of dumping file */
 
-	unsigned long int cache_size ;  /*/ the size of kernel cache*/ 
+	unsigned long int cache_size ;  /*/ the size of kernel cache in rows*/
 	BOOL cacheall ;
+	BOOL fcacheall ;                /*/ keep f_cache of all samples, not only Io, up to date*/
+	BOOL warm ;                     /*/ start SMO from the alphas in place, see Seed_Alphas*/
+	BOOL shrinking ;                /*/ leave the samples at bound out of the sweeps*/
+	long unsigned int shrunk ;      /*/ the most samples shrunk at once in the last SMO*/
+	Smo_Timer timer ;               /*/ timer of this solver only*/
+	unsigned int seed ;             /*/ random number stream of this solver, see urand*/
 	BOOL ardon ;
 	/*/double ** kernel_cache ;*/
 	/*/unsigned long int cur_cache ;*/
@@ -259,7 +436,14 @@ typedef struct _def_Settings
 	unsigned int seeds ;
 	unsigned int kfold ;       /*/ k-fold cross validation*/
 	unsigned int repeat ;      /*/ repeating times  */
-	unsigned long int cache_size ;  /*/ the size of kernel cache*/ 
+	unsigned long int cache_size ;  /*/ the size of kernel cache in rows*/
+	unsigned int threads ;          /*/ number of threads in SMO*/
+	BOOL fcacheall ;                /*/ update f of all samples after every step*/
+	BOOL seeding ;                  /*/ seed alphas from the previous C in cross validation*/
+	BOOL shrinking ;                /*/ use the shrinking heuristic in SMO*/
+	Approx_Name approx ;            /*/ approximate the kernel by a feature map of rank features*/
+	unsigned int rank ;
+	BOOL secondorder ;              /*/ second-order working pair selection in SMO*/
 
 	double lnC_start ;
 	double lnC_end ;
@@ -314,6 +498,7 @@ typedef struct _kcv_Settings
 	Data_Node ** nodelist ;
 	Data_Node *** pointernode ;
 	unsigned int ** cvfold ;
+	unsigned int seed ;           /*/ random number stream for the folds, see urand*/
 	
 	double * cv_error ;           /*/ validation error with size C_steps*K_steps	*/
 	double * cv_mean ;            /*/ validation error mean with size C_steps*K_steps*/
@@ -361,6 +546,10 @@ typedef struct _kcv_Settings
 #define DURATION       (settings->duration) 
 #define Io_CACHE       (settings->io_cache) 
 #define ALPHA          (settings->alpha)
+#define MATRIX         (settings->matrix)
+#define KCACHE         (settings->kcache)
+#define POOL           (settings->pool)
+#define KOPS           (settings->kops)
 #define INPUTFILE      (settings->inputfile) 
 #define TESTFILE       (settings->testfile) 
 #define DUMPINGFILE    (settings->dumpingfile)
@@ -391,6 +580,21 @@ typedef struct _kcv_Settings
 #define DEF_COARSESTEP   (0.5)
 #define DEF_REFINESTEP   (0.1)
 #define DEF_CACHE        (5000)
+#define DEF_THREADS      (1)
+#define DEF_FCACHEALL    (FALSE)
+#define DEF_SEEDING      (FALSE)
+#define DEF_SHRINKING    (FALSE)
+#define DEF_APPROX       (EXACT)
+#define DEF_RANK         (0)
+#define DEF_SECONDORDER  (FALSE)
+#define TAU              (1e-12)	/*/ least eta of a working pair in the second-order selection*/
+#define MINPARALLEL      (2048)	/*/ fewer samples are summed serially*/
+#define PREDICTBLOCK     (64)	/*/ test points scored together by Predict_Svor_Model*/
+#define SVBLOCK          (512)	/*/ support vectors swept over a block of test points at a time*/
+#define MODEL_MAGIC      "SVORMDL"	/*/ 8 bytes with the terminating zero*/
+#define MODEL_VERSION    (1)		/*/ increased whenever the layout of the model file changes*/
+#define MODEL_ORDER      (0x01020304)
+#define MODELALIGN       (64)		/*/ alignment of the sections in bytes*/
 #define DEF_ZOOMIN       (5)
 #define DEF_REPEAT       (1) 
 #define DEF_LOOP         (2)
@@ -403,7 +607,7 @@ def_Settings * Create_def_SettingsMatlab ( void );
 void Clear_def_Settings( def_Settings * settings ) ;
 
 //BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol, double ** train,double ** test );
-BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol, double ** train);
+BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol, double * train);
 BOOL Update_def_Settings( def_Settings * defsetting );
 
 BOOL Create_Data_List ( Data_List * list ) ;
@@ -412,34 +616,64 @@ BOOL Clear_Data_List ( Data_List * list ) ;
 BOOL Add_Data_List ( Data_List * list, Data_Node * node ) ;
 Data_Node * Create_Data_Node ( long unsigned int index, double * point, unsigned int y ) ;
 BOOL Clear_Label_Data_List ( Data_List * list ) ;
+BOOL Init_Data_Matrix ( Data_Matrix * matrix, unsigned long int count, unsigned int dimen, int * featuretype ) ;
+BOOL Create_Data_Matrix ( Data_Matrix * matrix, Data_List * list ) ;
+BOOL Clear_Data_Matrix ( Data_Matrix * matrix ) ;
+BOOL Pack_Data_Point ( Data_Matrix * matrix, double * point, double * x ) ;
 
 /*	load data file settings->inputfile, and create the data list Pairs */
-BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim );  
-BOOL smo_LoadMatrix ( Data_List * pairs, char * inputfilename, int inputdim, int nFil, int nCol, double ** matrix);
+BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim, unsigned int threads );  
+BOOL smo_LoadMatrix ( Data_List * pairs, char * inputfilename, int inputdim, int nFil, int nCol, double * matrix, int ld);
 
 
 /*create and initialize the smo_Settings structure from def_Settings*/
 smo_Settings * Create_smo_Settings ( def_Settings * settings ) ;
 void Clear_smo_Settings( smo_Settings * settings ) ;
 
-/*/ cache, a doubly linked list*/
+/*/ cache of Set Io, a packed array*/
 BOOL Create_Cache_List( Cache_List * ) ;
 BOOL Clear_Cache_List( Cache_List * ) ;
 BOOL Is_Cache_Empty( Cache_List * ) ;
 BOOL Add_Cache_Node( Cache_List *, Alphas * ) ;
-BOOL Sort_Cache_Node( Cache_List *, Alphas * ) ;
 BOOL Del_Cache_Node( Cache_List *, Alphas * ) ; 
+void Update_Io_Cache ( Alphas * alpha1, double d1, Alphas * alpha2, double d2, int * index, smo_Settings * settings ) ;
 
 /*/ create Alpha Matrix*/
 Alphas * Create_Alphas( smo_Settings * ) ;
 BOOL Clean_Alphas ( Alphas *, smo_Settings * ) ;
 BOOL Check_Alphas ( Alphas *, smo_Settings * ) ;
+BOOL Seed_Alphas ( Alphas *, double, smo_Settings * ) ;
+BOOL Assign_Alphas ( Alphas *, double *, smo_Settings * ) ;
 BOOL Clear_Alphas ( smo_Settings * ) ;
 
 /*/ calculate kerenl*/
 double Calc_Kernel( Alphas * , Alphas * , smo_Settings * ) ;
 double Calculate_Kernel( double * , double * , smo_Settings * ) ;
-double Calculate_Ordinal_Fi ( long unsigned int i, smo_Settings * settings ) ;/*/ i is index here*/
+double Matrix_Kernel( Data_Matrix * , Kernel_Name , unsigned int , double * , double * ) ;
+const Kernel_Ops * Get_Kernel_Ops( Data_Matrix * , Kernel_Name , unsigned int ) ;
+BOOL Scale_Data_Matrix ( smo_Settings * ) ;
+BOOL Create_Kernel_Cache ( Kernel_Cache * , unsigned long int count, unsigned long int size ) ;
+BOOL Clear_Kernel_Cache ( Kernel_Cache * ) ;
+double * Get_Kernel_Row ( Alphas * , smo_Settings * ) ;
+
+/*/ thread pool*/
+Thread_Pool * Create_Thread_Pool ( unsigned int threads ) ;
+void Clear_Thread_Pool ( Thread_Pool * pool ) ;
+unsigned int Thread_Pool_Size ( Thread_Pool * pool ) ;
+void Run_Thread_Pool ( Thread_Pool * pool, unsigned long int count, unsigned long int chunk, Thread_Task task, void * arg ) ;
+
+/*/ approximate kernel*/
+Feature_Map * Create_Feature_Map ( smo_Settings * settings, Approx_Name approx, unsigned int rank, unsigned int seed ) ;
+BOOL Map_Data_Point ( Feature_Map * fmap, double * x, double * z ) ;
+BOOL Map_Data_Matrix ( smo_Settings * settings ) ;
+BOOL Clear_Feature_Map ( Feature_Map * fmap ) ;
+
+double Calculate_Ordinal_Fi ( long unsigned int i, smo_Settings * settings ) ;/*/ i is index here*/
+void Refresh_Ordinal_Fi ( smo_Settings * settings ) ;
+void Update_Ordinal_Fi ( Alphas * alpha1, double d1, Alphas * alpha2, double d2, int * index, smo_Settings * settings ) ;
+void Unshrink_Alphas ( smo_Settings * settings ) ;
+double Linear_Fi ( Alphas * ai, smo_Settings * settings ) ;
+void Update_Weight ( Alphas * alpha, double d, smo_Settings * settings ) ;
 
 /*/ get label*/
 Set_Name Get_Label ( Alphas * , smo_Settings * settings) ;
@@ -453,6 +687,15 @@ double Calculate_Fi( long unsigned int, smo_Settings * ) ;
 
 BOOL smo_routine ( smo_Settings * settings ) ;
 BOOL svm_predict ( Data_List * test, smo_Settings * settings ) ;
+BOOL Create_Svor_Model ( Svor_Model * model, double * sv, double * coef, unsigned long int count, unsigned int dimen, 
+	double * biasj, unsigned int classes, Kernel_Name kernel, double kappa, unsigned int p ) ;
+BOOL Predict_Svor_Model ( Svor_Model * model, double * test, unsigned long int count, double * fx, double * guess, Thread_Pool * pool ) ;
+void Clear_Svor_Model ( Svor_Model * model ) ;
+BOOL Settings_Svor_Model ( Svor_Model * model, smo_Settings * settings ) ;
+BOOL Save_Svor_Model ( Svor_Model * model, char * filename ) ;
+BOOL Load_Svor_Model ( Svor_Model * model, char * filename ) ;
+BOOL svm_predict_model ( Data_List * testlist, Svor_Model * model, Thread_Pool * pool, double * testerror, double * testrate ) ;
+BOOL svm_saveguess ( Data_List * testlist, char * inputfile ) ;
 
 kcv_Settings * Create_Kcv ( def_Settings * settings ) ;
 BOOL Init_Kcv ( kcv_Settings * settings, def_Settings * defsetting ) ;
@@ -460,7 +703,8 @@ BOOL Clear_Kcv ( kcv_Settings * settings) ;
 
 BOOL svm_saveresults ( Data_List * testlist, smo_Settings * settings );
 //struct estructura* svm_saveresults_Matlab(Data_List * testlist, smo_Settings * settings,int nElem);
-struct estructura svm_saveresults_Matlab(Data_List * testlist, smo_Settings * settings);
+struct estructura svm_saveresults_Matlab(Data_List * testlist, smo_Settings * settings, BOOL projection);
+BOOL Save_Smo_Stats ( smo_Settings * settings, char * filename ) ;
 
 BOOL Rehearsal_Kcv ( kcv_Settings * kcvsetting, def_Settings * defsetting ) ;
 
@@ -469,9 +713,13 @@ BOOL ordinal_cross_takestep ( Alphas * alpha4, unsigned int, Alphas * alpha5, un
 BOOL ordinal_cross_identical ( Alphas * alpha1, Alphas * alpha2, unsigned int threshold, smo_Settings * settings ) ;
 
 /*/timing routines*/
-void tstart(void) ;
-void tend(void) ;
-double tval() ;
+void tstart(Smo_Timer * timer) ;
+void tend(Smo_Timer * timer) ;
+double tval(Smo_Timer * timer) ;
+double tcpu(void) ;
+double twall(void) ;
+double tmemory(void) ;
+double urand(unsigned int * seed) ;
 
 #endif
 
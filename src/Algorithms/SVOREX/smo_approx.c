@@ -0,0 +1,265 @@
+/*******************************************************************************\
+
+	smo_approx.c in Sequential Minimal Optimization ver2.0
+
+	approximates the kernel by a low-rank feature map, so that SMO runs on the
+	mapped inputs with the linear kernel in primal form: Nystrom with rank
+	landmarks drawn from the training inputs, for any kernel, or random
+	Fourier features for the Gaussian kernel on continuous inputs.
+
+\*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "smo.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*/ a standard normal number from the stream in seed, by Box-Muller*/
+static double nrand ( unsigned int * seed )
+{
+	double u = 1.0 - urand( seed ) ;
+
+	return sqrt( -2.0*log( u ) ) * cos( 2.0*M_PI*urand( seed ) ) ;
+}
+
+/*******************************************************************************\
+
+	Feature_Map * Create_Feature_Map ( smo_Settings * settings, Approx_Name approx, unsigned int rank, unsigned int seed )
+
+	draw the landmarks or the frequencies of the feature map from MATRIX,
+	which has been scaled already. Nystrom keeps the Cholesky factor L of the
+	kernel matrix of the landmarks, with the jitter of 0.001 on its diagonal,
+	so that the map z(x) = inv(L)*k(x) gives z(x)'*z(y) = k(x)'*inv(K)*k(y).
+	Fourier features are sqrt(2/rank)*cos(w'*x + b) with w drawn from the
+	spectrum of exp(-dimen*|x-y|^2) and b uniform in [0, 2pi).
+	input:  the pointer to smo_Settings, the approximation, the number of
+	        features and the seed of the random stream
+	output: the pointer to Feature_Map, or NULL
+
+\*******************************************************************************/
+
+Feature_Map * Create_Feature_Map ( smo_Settings * settings, Approx_Name approx, unsigned int rank, unsigned int seed )
+{
+	Feature_Map * fmap = NULL ;
+	unsigned long int * pick = NULL ;
+	unsigned long int i, t ;
+	unsigned int r, s, k ;
+	double * row ;
+	double sum ;
+
+	if ( NULL == settings || EXACT == approx || 0 == rank || 0 == MATRIX.count || FALSE == MATRIX.scaled )
+		return NULL ;
+	if ( FOURIER == approx && ( GAUSSIAN != KERNEL || MATRIX.cat > 0 ) )
+	{
+		printf("Warning : Fourier features need the Gaussian kernel on continuous inputs, Nystrom is used.\n") ;
+		approx = NYSTROM ;
+	}
+	if ( NYSTROM == approx && rank > MATRIX.count )
+		rank = (unsigned int) MATRIX.count ;
+
+	if ( NULL == (fmap = (Feature_Map *) calloc(1, sizeof(Feature_Map))) )
+	{
+		printf("Fatal Error : fail to malloc memory.\n") ;
+		return NULL ;
+	}
+	fmap->approx = approx ;
+	fmap->rank = rank ;
+	fmap->p = P ;
+	/* the rows of input are packed like those of MATRIX*/
+	if ( FALSE == Init_Data_Matrix( &(fmap->input), rank, MATRIX.dimen, settings->pairs->featuretype ) )
+	{
+		free( fmap ) ;
+		return NULL ;
+	}
+	memcpy( fmap->input.scale, MATRIX.scale, (MATRIX.cont+1)*sizeof(double) ) ;
+	memcpy( fmap->input.weight, MATRIX.weight, (MATRIX.cat+1)*sizeof(double) ) ;
+	fmap->input.sumweight = MATRIX.sumweight ;
+	fmap->input.scaled = TRUE ;
+	for ( i = 0 ; i < rank ; i ++ )
+	{
+		fmap->input.target[i] = 0 ;
+		fmap->input.fold[i] = 0 ;
+	}
+	if ( 0 == seed )
+		seed = 1 ;
+
+	if ( FOURIER == approx )
+	{
+		fmap->kops = Get_Kernel_Ops( &(fmap->input), LINEAR, 1 ) ;
+		fmap->phase = (double *) malloc(rank*sizeof(double)) ;
+		if ( NULL == fmap->phase )
+		{
+			printf("Fatal Error : fail to malloc memory.\n") ;
+			Clear_Feature_Map( fmap ) ;
+			return NULL ;
+		}
+		for ( r = 0 ; r < rank ; r ++ )
+		{
+			row = fmap->input.x + r*fmap->input.stride ;
+			for ( k = 0 ; k < fmap->input.stride ; k ++ )
+				row[k] = ( k < fmap->input.numeric ) ? sqrt( 2.0*MATRIX.dimen ) * nrand( &seed ) : 0 ;
+			fmap->phase[r] = 2.0*M_PI*urand( &seed ) ;
+		}
+		return fmap ;
+	}
+
+	/* landmarks without replacement by a partial Fisher-Yates shuffle*/
+	fmap->kops = KOPS ;
+	pick = (unsigned long int *) malloc(MATRIX.count*sizeof(unsigned long int)) ;
+	fmap->factor = (double *) calloc((unsigned long int)rank*rank, sizeof(double)) ;
+	if ( NULL == pick || NULL == fmap->factor )
+	{
+		printf("Fatal Error : fail to malloc memory.\n") ;
+		if ( NULL != pick )
+			free( pick ) ;
+		Clear_Feature_Map( fmap ) ;
+		return NULL ;
+	}
+	for ( i = 0 ; i < MATRIX.count ; i ++ )
+		pick[i] = i ;
+	for ( r = 0 ; r < rank ; r ++ )
+	{
+		i = r + (unsigned long int)( urand( &seed ) * (MATRIX.count - r) ) ;
+		if ( i >= MATRIX.count )
+			i = MATRIX.count - 1 ;
+		t = pick[r] ; pick[r] = pick[i] ; pick[i] = t ;
+		memcpy( fmap->input.x + r*fmap->input.stride, MATRIX.x + pick[r]*MATRIX.stride, MATRIX.stride*sizeof(double) ) ;
+	}
+	free( pick ) ;
+
+	/* K + 0.001*I of the landmarks into its lower Cholesky factor, in place*/
+	for ( r = 0 ; r < rank ; r ++ )
+	{
+		row = fmap->factor + (unsigned long int)r*rank ;
+		fmap->kops->row( &(fmap->input), fmap->p, fmap->input.x + r*fmap->input.stride, 0, r+1, row ) ;
+		row[r] += 0.001 ;
+		for ( s = 0 ; s <= r ; s ++ )
+		{
+			sum = row[s] ;
+			for ( k = 0 ; k < s ; k ++ )
+				sum -= row[k] * fmap->factor[(unsigned long int)s*rank + k] ;
+			if ( s < r )
+				row[s] = sum / fmap->factor[(unsigned long int)s*rank + s] ;
+			else if ( sum > 0 )
+				row[s] = sqrt( sum ) ;
+			else
+			{
+				printf("Warning : the kernel of the landmarks is not positive definite.\n") ;
+				Clear_Feature_Map( fmap ) ;
+				return NULL ;
+			}
+		}
+	}
+	return fmap ;
+}
+
+/*******************************************************************************\
+
+	BOOL Map_Data_Point ( Feature_Map * fmap, double * x, double * z )
+
+	map an input packed in the layout of fmap->input into the features z,
+	which are padded with zeros to a multiple of ROWALIGN.
+	input:  the pointer to Feature_Map, the packed input and the output
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Map_Data_Point ( Feature_Map * fmap, double * x, double * z )
+{
+	unsigned int r, k, padded ;
+	double sum, norm ;
+
+	if ( NULL == fmap || NULL == x || NULL == z )
+		return FALSE ;
+	padded = ((fmap->rank + ROWALIGN - 1)/ROWALIGN)*ROWALIGN ;
+	fmap->kops->row( &(fmap->input), fmap->p, x, 0, fmap->rank, z ) ;
+	if ( NYSTROM == fmap->approx )
+	{
+		/* forward substitution with the Cholesky factor*/
+		for ( r = 0 ; r < fmap->rank ; r ++ )
+		{
+			sum = z[r] ;
+			for ( k = 0 ; k < r ; k ++ )
+				sum -= fmap->factor[(unsigned long int)r*fmap->rank + k] * z[k] ;
+			z[r] = sum / fmap->factor[(unsigned long int)r*fmap->rank + r] ;
+		}
+	}
+	else
+	{
+		norm = sqrt( 2.0/fmap->rank ) ;
+		for ( r = 0 ; r < fmap->rank ; r ++ )
+			z[r] = norm * cos( z[r] + fmap->phase[r] ) ;
+	}
+	for ( r = fmap->rank ; r < padded ; r ++ )
+		z[r] = 0 ;
+	return TRUE ;
+}
+
+typedef struct _Map_Task
+{
+	Feature_Map * fmap ;
+	Data_Matrix * matrix ;          /* packed inputs*/
+	Data_Matrix * mapped ;          /* features of the same rows*/
+} Map_Task ;
+
+static void Task_Map_Rows ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	Map_Task * task = (Map_Task *) arg ;
+	unsigned long int i ;
+
+	for ( i = begin ; i < end ; i ++ )
+		Map_Data_Point( task->fmap, task->matrix->x + i*task->matrix->stride, task->mapped->x + i*task->mapped->stride ) ;
+}
+
+/*******************************************************************************\
+
+	BOOL Map_Data_Matrix ( smo_Settings * settings )
+
+	replace the packed inputs in MATRIX by their features under settings->fmap,
+	row by row in parallel on the thread pool if any. the targets and the
+	folds are kept, and the features are marked scaled, as they need no ARD.
+	input:  the pointer to smo_Settings
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Map_Data_Matrix ( smo_Settings * settings )
+{
+	Data_Matrix mapped ;
+	Map_Task task ;
+
+	if ( NULL == settings || NULL == settings->fmap )
+		return FALSE ;
+	if ( FALSE == Init_Data_Matrix( &mapped, MATRIX.count, settings->fmap->rank, NULL ) )
+		return FALSE ;
+	memcpy( mapped.target, MATRIX.target, MATRIX.count*sizeof(unsigned int) ) ;
+	memcpy( mapped.fold, MATRIX.fold, MATRIX.count*sizeof(int) ) ;
+	task.fmap = settings->fmap ;
+	task.matrix = &(MATRIX) ;
+	task.mapped = &mapped ;
+	Run_Thread_Pool( POOL, MATRIX.count, 64, Task_Map_Rows, &task ) ;
+	mapped.scaled = TRUE ;
+	Clear_Data_Matrix( &(MATRIX) ) ;
+	MATRIX = mapped ;
+	return TRUE ;
+}
+
+BOOL Clear_Feature_Map ( Feature_Map * fmap )
+{
+	if ( NULL == fmap )
+		return FALSE ;
+	Clear_Data_Matrix( &(fmap->input) ) ;
+	if ( NULL != fmap->factor )
+		free( fmap->factor ) ;
+	if ( NULL != fmap->phase )
+		free( fmap->phase ) ;
+	free( fmap ) ;
+	return TRUE ;
+}
+
+/* the end of smo_approx.c */
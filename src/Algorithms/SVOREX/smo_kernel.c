@@ -21,118 +21,360 @@
 #include <sys/types.h> 
 #include <sys/timeb.h>
 #include "smo.h"
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 
-double Calculate_Kernel( double * pi, double * pj, smo_Settings * settings )
+/* the inner loops of the kernel on the packed blocks of Data_Matrix, whose 
+   lengths are multiples of ROWALIGN. AVX-512 or AVX2 is used if the compiler 
+   targets it, e.g. with -march=native, otherwise the plain loops below.*/
+
+#if defined(__AVX512F__)
+
+#if (ROWALIGN % 8)
+#error "ROWALIGN must be a multiple of 8 for AVX-512"
+#endif
+
+static double Dot_Block ( const double * a, const double * b, unsigned int n )
 {
-	long unsigned int dimen = 0 ;
-	long unsigned int dimension = 0 ;
-	double kernel = 0 ;	
+	__m512d acc = _mm512_setzero_pd() ;
+	unsigned int k ;
 
-	if ( NULL == pi || NULL == pj || NULL == settings )
-		return kernel ;
-	
-	if (settings->pairs->dimen<1)
+	for ( k = 0 ; k < n ; k += 8 )
+		acc = _mm512_fmadd_pd( _mm512_loadu_pd(a+k), _mm512_loadu_pd(b+k), acc ) ;
+	return _mm512_reduce_add_pd( acc ) ;
+}
+
+static double Distance_Block ( const double * a, const double * b, unsigned int n )
+{
+	__m512d acc = _mm512_setzero_pd() ;
+	__m512d d ;
+	unsigned int k ;
+
+	for ( k = 0 ; k < n ; k += 8 )
 	{
-		printf("Warning : dimension is less than 1.\n") ;
-		return kernel ;
+		d = _mm512_sub_pd( _mm512_loadu_pd(a+k), _mm512_loadu_pd(b+k) ) ;
+		acc = _mm512_fmadd_pd( d, d, acc ) ;
 	}
-	if (NULL == settings->ard)
+	return _mm512_reduce_add_pd( acc ) ;
+}
+
+static double Mismatch_Block ( const double * a, const double * b, const double * w, unsigned int n )
+{
+	__m512d acc = _mm512_setzero_pd() ;
+	__mmask8 m ;
+	unsigned int k ;
+
+	for ( k = 0 ; k < n ; k += 8 )
 	{
-		printf("Warning : ard is NULL.\n") ;
-		return kernel ;
+		m = _mm512_cmp_pd_mask( _mm512_loadu_pd(a+k), _mm512_loadu_pd(b+k), _CMP_NEQ_UQ ) ;
+		acc = _mm512_mask_add_pd( acc, m, acc, _mm512_loadu_pd(w+k) ) ;
 	}
+	return _mm512_reduce_add_pd( acc ) ;
+}
+
+#elif defined(__AVX2__)
 
-	dimension = settings->pairs->dimen ;
-	if ( POLYNOMIAL == KERNEL )	
+#if (ROWALIGN % 4)
+#error "ROWALIGN must be a multiple of 4 for AVX2"
+#endif
+
+#ifdef __FMA__
+#define FMADD_PD(a,b,c) _mm256_fmadd_pd(a,b,c)
+#else
+#define FMADD_PD(a,b,c) _mm256_add_pd(_mm256_mul_pd(a,b),c)
+#endif
+
+static double Sum_Pd ( __m256d v )
+{
+	__m128d s = _mm_add_pd( _mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1) ) ;
+	return _mm_cvtsd_f64(s) + _mm_cvtsd_f64(_mm_unpackhi_pd(s, s)) ;
+}
+
+static double Dot_Block ( const double * a, const double * b, unsigned int n )
+{
+	__m256d acc = _mm256_setzero_pd() ;
+	unsigned int k ;
+
+	for ( k = 0 ; k < n ; k += 4 )
+		acc = FMADD_PD( _mm256_loadu_pd(a+k), _mm256_loadu_pd(b+k), acc ) ;
+	return Sum_Pd( acc ) ;
+}
+
+static double Distance_Block ( const double * a, const double * b, unsigned int n )
+{
+	__m256d acc = _mm256_setzero_pd() ;
+	__m256d d ;
+	unsigned int k ;
+
+	for ( k = 0 ; k < n ; k += 4 )
 	{
-		for ( dimen = 0; dimen < dimension; dimen ++ )
-		{		
-			if ( 0 == settings->pairs->featuretype[dimen] )
-			{
-				if ( pi[dimen]!=0 && pj[dimen]!=0 )
-					kernel = kernel + settings->ard[dimen] * pi[dimen] * pj[dimen] ;
-			}
-			else
-			{
-				if ( pi[dimen]!=pj[dimen] )
-					kernel = kernel - settings->ard[dimen] ;
-				else
-					kernel = kernel + settings->ard[dimen] ;
-			}
-		}
-		if ((double) P > 1.0)
-			kernel = pow( (kernel + 1.0), (double) P ) ;
+		d = _mm256_sub_pd( _mm256_loadu_pd(a+k), _mm256_loadu_pd(b+k) ) ;
+		acc = FMADD_PD( d, d, acc ) ;
 	}
-	else if ( GAUSSIAN == KERNEL )
+	return Sum_Pd( acc ) ;
+}
+
+static double Mismatch_Block ( const double * a, const double * b, const double * w, unsigned int n )
+{
+	__m256d acc = _mm256_setzero_pd() ;
+	__m256d m ;
+	unsigned int k ;
+
+	for ( k = 0 ; k < n ; k += 4 )
 	{
-		for ( dimen = 0; dimen < dimension; dimen ++ )
-		{
-			if ( 0 == settings->pairs->featuretype[dimen] )
-			{
-				if ( pi[dimen]!=pj[dimen] )
-					kernel = kernel + KAPPA * settings->ard[dimen] * ( pi[dimen] - pj[dimen] ) * ( pi[dimen] - pj[dimen] ) ;
-			}
-			else
-			{
-				if ( pi[dimen]!=pj[dimen] )
-					kernel = kernel + KAPPA * settings->ard[dimen] ;
-			}
-				//printf("%f( %f - %f)^2\n", kernel, pi[dimen], pj[dimen]);
-		}
-		//printf("%f %d \n", kernel, dimension);
-		//kernel = exp ( -  kernel / 2.0 * dimension ) ; 
-		kernel = exp ( -  kernel * dimension ) ; 
+		m = _mm256_cmp_pd( _mm256_loadu_pd(a+k), _mm256_loadu_pd(b+k), _CMP_NEQ_UQ ) ;
+		acc = _mm256_add_pd( acc, _mm256_and_pd( m, _mm256_loadu_pd(w+k) ) ) ;
 	}
-	else 
+	return Sum_Pd( acc ) ;
+}
+
+#else
+
+static double Dot_Block ( const double * a, const double * b, unsigned int n )
+{
+	double s = 0 ;
+	unsigned int k ;
+
+	for ( k = 0 ; k < n ; k ++ )
+		s = s + a[k] * b[k] ;
+	return s ;
+}
+
+static double Distance_Block ( const double * a, const double * b, unsigned int n )
+{
+	double s = 0 ;
+	unsigned int k ;
+
+	for ( k = 0 ; k < n ; k ++ )
+		s = s + ( a[k] - b[k] ) * ( a[k] - b[k] ) ;
+	return s ;
+}
+
+static double Mismatch_Block ( const double * a, const double * b, const double * w, unsigned int n )
+{
+	double s = 0 ;
+	unsigned int k ;
+
+	for ( k = 0 ; k < n ; k ++ )
 	{
-		for ( dimen = 0; dimen < dimension; dimen ++ )
-		{
-			if ( 0 == settings->pairs->featuretype[dimen] )
-			{
-				if ( pi[dimen]!=0 && pj[dimen]!=0 )
-					kernel = kernel + settings->ard[dimen] * pi[dimen] * pj[dimen] ;
-			}
-			else
-			{
-				if ( pi[dimen]!=pj[dimen] )
-					kernel = kernel - settings->ard[dimen] ;
-				else
-					kernel = kernel + settings->ard[dimen] ;
-			}
-		}
-	}       
-	if (pi==pj){
-	//printf("%f\n", kernel+ 0.001);
-		return kernel + 0.001 ;
-	}else{
-	//printf("%f\n", kernel);
-        return kernel ; 
+		if ( a[k] != b[k] )
+			s = s + w[k] ;
 	}
+	return s ;
 }
 
-double Calc_Kernel( struct _Alphas * ai, struct _Alphas * aj, smo_Settings * settings )
+#endif
+
+/*/ the kernel with its type, order and the presence of categorical inputs as 
+/ constants, which the compiler folds in every instantiation of KERNEL_FORM*/
+static double Fixed_Kernel ( Data_Matrix * matrix, Kernel_Name kernel, unsigned int p, BOOL cat, double * pi, double * pj )
+{
+	double value ;
+
+	if ( GAUSSIAN == kernel )
+	{
+		value = Distance_Block( pi, pj, matrix->cont ) ;
+		if ( TRUE == cat )
+			value = value + Mismatch_Block( pi + matrix->cont, pj + matrix->cont, matrix->weight, matrix->cat ) ;
+		return exp ( -  value * matrix->dimen ) ; 
+	}
+	/* a categorical match adds its weight and a mismatch subtracts it*/
+	value = Dot_Block( pi, pj, matrix->cont ) ;
+	if ( TRUE == cat )
+		value = value + matrix->sumweight 
+			- 2.0 * Mismatch_Block( pi + matrix->cont, pj + matrix->cont, matrix->weight, matrix->cat ) ;
+	if ( POLYNOMIAL == kernel && 2 == p )
+		return ( value + 1.0 ) * ( value + 1.0 ) ;
+	if ( POLYNOMIAL == kernel && p > 1 )
+		return pow( (value + 1.0), (double) p ) ;
+	return value ;
+}
+
+/*/ one kernel pair, a row against the rows [begin,end) of matrix, and the 
+/ sum of coef*kernel over them, starting from sum and skipping zero coef, 
+/ all for one kernel form. q is the order of the polynomial kernel, which 
+/ is only read by the general polynomial form.*/
+#define KERNEL_FORM(form, kernel, p, cat) \
+static double form##_Pair ( Data_Matrix * matrix, unsigned int q, double * pi, double * pj ) \
+{ \
+	return Fixed_Kernel( matrix, kernel, p, cat, pi, pj ) ; \
+} \
+static void form##_Row ( Data_Matrix * matrix, unsigned int q, double * pi, unsigned long int begin, unsigned long int end, double * row ) \
+{ \
+	unsigned long int j ; \
+	for ( j = begin ; j < end ; j ++ ) \
+		row[j] = Fixed_Kernel( matrix, kernel, p, cat, pi, matrix->x + j*matrix->stride ) ; \
+} \
+static double form##_Sum ( Data_Matrix * matrix, unsigned int q, double * pi, double * coef, unsigned long int begin, unsigned long int end, double sum ) \
+{ \
+	unsigned long int j ; \
+	for ( j = begin ; j < end ; j ++ ) \
+	{ \
+		if ( 0 != coef[j] ) \
+			sum = sum + coef[j] * Fixed_Kernel( matrix, kernel, p, cat, pi, matrix->x + j*matrix->stride ) ; \
+	} \
+	return sum ; \
+} \
+static const Kernel_Ops form = { form##_Pair, form##_Row, form##_Sum } ;
+
+KERNEL_FORM( Gaussian_Ops, GAUSSIAN, 0, FALSE )
+KERNEL_FORM( Gaussian_Cat_Ops, GAUSSIAN, 0, TRUE )
+KERNEL_FORM( Linear_Ops, LINEAR, 1, FALSE )
+KERNEL_FORM( Linear_Cat_Ops, LINEAR, 1, TRUE )
+KERNEL_FORM( Quadratic_Ops, POLYNOMIAL, 2, FALSE )
+KERNEL_FORM( Quadratic_Cat_Ops, POLYNOMIAL, 2, TRUE )
+KERNEL_FORM( Polynomial_Ops, POLYNOMIAL, q, FALSE )
+KERNEL_FORM( Polynomial_Cat_Ops, POLYNOMIAL, q, TRUE )
+
+/*******************************************************************************\
+
+	const Kernel_Ops * Get_Kernel_Ops( Data_Matrix * matrix, Kernel_Name kernel, unsigned int p )
+	
+	pick the instantiation of the kernel evaluations for kernel and p on the 
+	inputs of matrix, once per solve or model, so that the loops over the 
+	samples branch neither on the kernel nor on the categorical inputs.
+	input:  the pointer to Data_Matrix, the kernel type and order
+	output: the kernel evaluations
+
+\*******************************************************************************/
+
+const Kernel_Ops * Get_Kernel_Ops( Data_Matrix * matrix, Kernel_Name kernel, unsigned int p )
+{
+	BOOL cat = ( matrix->cat > 0 ) ? TRUE : FALSE ;
+
+	if ( GAUSSIAN == kernel )
+		return TRUE == cat ? &Gaussian_Cat_Ops : &Gaussian_Ops ;
+	if ( LINEAR == kernel || p <= 1 )
+		return TRUE == cat ? &Linear_Cat_Ops : &Linear_Ops ;
+	if ( 2 == p )
+		return TRUE == cat ? &Quadratic_Cat_Ops : &Quadratic_Ops ;
+	return TRUE == cat ? &Polynomial_Cat_Ops : &Polynomial_Ops ;
+}
+
+/*******************************************************************************\
+
+	double Calculate_Kernel( double * pi, double * pj, smo_Settings * settings )
+	
+	calculate the kernel of two inputs in the layout of Data_Matrix, i.e. rows 
+	of MATRIX or vectors written by Pack_Data_Point. the ARD weights and kappa 
+	are folded into the data by Scale_Data_Matrix, so that a continuous column 
+	is a plain product or difference and a categorical one a weighted match.
+	input:  the two packed inputs and the pointer to smo_Settings 
+	output: the kernel value, plus a jitter of 0.001 if pi and pj are the same
+
+\*******************************************************************************/
+
+double Calculate_Kernel( double * pi, double * pj, smo_Settings * settings )
 {
-	long unsigned int dimension = 0 ;
 	double kernel = 0 ;
-	double * pi ;
-	double * pj ;
-	int i, j ;
 
-	if ( NULL == ai || NULL == aj || NULL == settings )
+	if ( NULL == pi || NULL == pj || NULL == settings )
 		return kernel ;
-
-	if (settings->pairs->dimen<1)
+	
+	if (MATRIX.dimen<1)
 	{
 		printf("Warning : dimension is less than 1.\n") ;
 		return kernel ;
 	}
+
+	kernel = KOPS->pair( &(MATRIX), P, pi, pj ) ;
+	if (pi==pj)
+		return kernel + 0.001 ;
+	else
+		return kernel ;
+}
+
+/*******************************************************************************\
+
+	double Matrix_Kernel( Data_Matrix * matrix, Kernel_Name kernel, unsigned int p, double * pi, double * pj )
+	
+	the kernel of two inputs in the layout of matrix, without the jitter, for 
+	the callers that have a packed matrix but no smo_Settings, e.g. Svor_Model.
+	input:  the pointer to Data_Matrix, the kernel type and order, and the two 
+	        packed inputs
+	output: the kernel value
+
+\*******************************************************************************/
+
+double Matrix_Kernel( Data_Matrix * matrix, Kernel_Name kernel, unsigned int p, double * pi, double * pj )
+{
+	return Get_Kernel_Ops( matrix, kernel, p )->pair( matrix, p, pi, pj ) ;
+}
+
+/*******************************************************************************\
+
+	BOOL Scale_Data_Matrix ( smo_Settings * settings )
+	
+	fold the ARD weights, and kappa for the Gaussian kernel, into MATRIX once: 
+	the continuous columns are multiplied by sqrt(ard*kappa), or sqrt(ard), 
+	and the categorical columns get the weight ard*kappa, or ard. test inputs 
+	are scaled the same way by Pack_Data_Point.
+	input:  the pointer to smo_Settings 
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Scale_Data_Matrix ( smo_Settings * settings )
+{
+	Data_Matrix * matrix ;
+	double * row ;
+	double ard ;
+	unsigned long int i ;
+	unsigned int k ;
+
+	if ( NULL == settings )
+		return FALSE ;
+	matrix = &(MATRIX) ;
+	if ( NULL == matrix->x || NULL == matrix->column )
+		return FALSE ;
 	if (NULL == settings->ard)
 	{
 		printf("Warning : ard is NULL.\n") ;
-		return kernel ;
+		return FALSE ;
+	}
+	if ( TRUE == matrix->scaled )
+	{
+		printf("Warning : Data_Matrix is scaled already.\n") ;
+		return FALSE ;
 	}
 
+	matrix->sumweight = 0 ;
+	for ( k = 0 ; k < matrix->dimen ; k ++ )
+	{
+		ard = settings->ard[matrix->column[k]] ;
+		if ( ard < 0 )
+		{
+			printf("Warning : negative ARD weight %f is taken as 0.\n", ard) ;
+			ard = 0 ;
+		}
+		if ( GAUSSIAN == KERNEL )
+			ard = ard * KAPPA ;
+		if ( k < matrix->numeric )
+			matrix->scale[k] = sqrt( ard ) ;
+		else
+		{
+			matrix->weight[k - matrix->numeric] = ard ;
+			matrix->sumweight += ard ;
+		}
+	}
+	for ( i = 0 ; i < matrix->count ; i ++ )
+	{
+		row = matrix->x + i*matrix->stride ;
+		for ( k = 0 ; k < matrix->numeric ; k ++ )
+			row[k] = matrix->scale[k] * row[k] ;
+	}
+	matrix->scaled = TRUE ;
+	return TRUE ;
+}
+
+double Calc_Kernel( struct _Alphas * ai, struct _Alphas * aj, smo_Settings * settings )
+{
+	int i, j ;
+
+	/* the inputs are checked once by Create_smo_Settings, this is called 
+	   for every kernel value that is not computed by the row loops*/
 	if (TRUE == settings->cacheall)
 	{
 		/* retrieve kernel values*/
@@ -143,10 +385,202 @@ double Calc_Kernel( struct _Alphas * ai, struct _Alphas * aj, smo_Settings * set
 		else if ( i < j )
 			return aj->kernel[i] ;
 	}
+	else if (NULL != KCACHE.row)
+	{
+		/* look up the bounded row cache, either row will do*/
+		i = ai - ALPHA ;
+		j = aj - ALPHA ;
+		if (NULL != KCACHE.row[i])
+			return KCACHE.row[i][j] ;
+		if (NULL != KCACHE.row[j])
+			return KCACHE.row[j][i] ;
+	}
+
+	COUNT_ADD( settings->stats.kernels, 1 ) ;
+	if (ai == aj)
+		return KOPS->pair( &(MATRIX), P, MATRIX.x + (ai - ALPHA)*MATRIX.stride, MATRIX.x + (aj - ALPHA)*MATRIX.stride ) + 0.001 ;
+	return KOPS->pair( &(MATRIX), P, MATRIX.x + (ai - ALPHA)*MATRIX.stride, MATRIX.x + (aj - ALPHA)*MATRIX.stride ) ;
+}
+
+/*******************************************************************************\
+
+	BOOL Create_Kernel_Cache ( Kernel_Cache * cache, unsigned long int count, unsigned long int size )
+	
+	initialize an empty cache keeping at most size kernel rows of length count.
+	rows are computed lazily by Get_Kernel_Row and the least recently used 
+	row is recycled once the cache is full.
+	input:  the pointer to Kernel_Cache, the number of samples and the cache size
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Create_Kernel_Cache ( Kernel_Cache * cache, unsigned long int count, unsigned long int size )
+{
+	if ( NULL == cache )
+		return FALSE ;
+	cache->count = count ;
+	cache->size = max(size, 2) ;
+	cache->used = 0 ;
+	cache->head = -1 ;
+	cache->tail = -1 ;
+	cache->row = (double **) calloc(count, sizeof(double *)) ;
+	cache->prev = (long int *) malloc(count*sizeof(long int)) ;
+	cache->next = (long int *) malloc(count*sizeof(long int)) ;
+	if ( NULL == cache->row || NULL == cache->prev || NULL == cache->next )
+	{
+		printf("\nFATAL ERROR : fail to malloc kernel cache.\n") ;
+		Clear_Kernel_Cache( cache ) ;
+		return FALSE ;
+	}
+	return TRUE ;
+}
+
+BOOL Clear_Kernel_Cache ( Kernel_Cache * cache )
+{
+	unsigned long int i ;
+
+	if ( NULL == cache )
+		return FALSE ;
+	if ( NULL != cache->row )
+	{
+		for ( i = 0 ; i < cache->count ; i ++ )
+		{
+			if ( NULL != cache->row[i] )
+				free( cache->row[i] ) ;
+		}
+		free( cache->row ) ;
+	}
+	if ( NULL != cache->prev )
+		free( cache->prev ) ;
+	if ( NULL != cache->next )
+		free( cache->next ) ;
+	cache->row = NULL ;
+	cache->prev = NULL ;
+	cache->next = NULL ;
+	cache->used = 0 ;
+	cache->head = -1 ;
+	cache->tail = -1 ;
+	return TRUE ;
+}
+
+typedef struct _Row_Task
+{
+	smo_Settings * settings ;
+	double * row ;
+	double * pi ;
+	long int i ;
+} Row_Task ;
+
+/* fill the entries [begin,end) of the row of sample i, the kernel is
+   symmetric, so the cached rows are reused*/
+static void Task_Kernel_Row ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	Row_Task * task = (Row_Task *) arg ;
+	smo_Settings * settings = task->settings ;
+	unsigned long int j, run, count = 0 ;
+
+	/* the runs of rows not in the cache are computed in one go*/
+	for ( j = begin ; j < end ; j = run )
+	{
+		if ( NULL != KCACHE.row[j] )
+		{
+			task->row[j] = KCACHE.row[j][task->i] ;
+			run = j + 1 ;
+			continue ;
+		}
+		for ( run = j + 1 ; run < end && NULL == KCACHE.row[run] ; run ++ )
+			;
+		KOPS->row( &(MATRIX), P, task->pi, j, run, task->row ) ;
+		count += run - j ;
+	}
+	if ( (unsigned long int) task->i >= begin && (unsigned long int) task->i < end )
+		task->row[task->i] += 0.001 ;
+	COUNT_ADD( settings->stats.kernels, count ) ;
+}
+
+/*******************************************************************************\
+
+	double * Get_Kernel_Row ( Alphas * ai, smo_Settings * settings )
+	
+	return the kernel row of ai, computing it if it is not in the cache, and 
+	mark it as the most recently used one. the returned row stays valid until 
+	the cache has to make room for more than KCACHE.size-1 other rows.
+	input:  the pointer to alpha and the pointer to smo_Settings
+	output: the pointer to the row, or NULL if no bounded cache is in use
+
+\*******************************************************************************/
+
+double * Get_Kernel_Row ( Alphas * ai, smo_Settings * settings )
+{
+	Kernel_Cache * cache ;
+	double * row ;
+	Row_Task task ;
+	long int i, k ;
+
+	if ( NULL == ai || NULL == settings || TRUE == settings->cacheall )
+		return NULL ;
+	cache = &(KCACHE) ;
+	if ( NULL == cache->row )
+		return NULL ;
+
+	i = ai - ALPHA ;
+	row = cache->row[i] ;
+	if ( NULL != row )
+	{
+		/* hit, move it to the head*/
+		settings->stats.hits += 1 ;
+		if ( cache->head != i )
+		{
+			cache->next[cache->prev[i]] = cache->next[i] ;
+			if ( cache->tail == i )
+				cache->tail = cache->prev[i] ;
+			else
+				cache->prev[cache->next[i]] = cache->prev[i] ;
+			cache->prev[i] = -1 ;
+			cache->next[i] = cache->head ;
+			cache->prev[cache->head] = i ;
+			cache->head = i ;
+		}
+		return row ;
+	}
+
+	settings->stats.misses += 1 ;
+	if ( cache->used < cache->size )
+	{
+		row = (double *) malloc(cache->count*sizeof(double)) ;
+		if ( NULL == row )
+		{
+			printf("\nFATAL ERROR : fail to malloc kernel row.\n") ;
+			exit(1) ;
+		}
+		cache->used += 1 ;
+	}
+	else
+	{
+		/* recycle the least recently used row*/
+		k = cache->tail ;
+		row = cache->row[k] ;
+		cache->row[k] = NULL ;
+		cache->tail = cache->prev[k] ;
+		if ( cache->tail >= 0 )
+			cache->next[cache->tail] = -1 ;
+		else
+			cache->head = -1 ;
+	}
 
-	dimension = settings->pairs->dimen ;
-	pi = ai->pair->point ;
-	pj = aj->pair->point ;
-	return Calculate_Kernel(pi, pj, settings) ;
+	task.settings = settings ;
+	task.row = row ;
+	task.pi = MATRIX.x + i*MATRIX.stride ;
+	task.i = i ;
+	Run_Thread_Pool( POOL, cache->count, 512, Task_Kernel_Row, &task ) ;
+	cache->row[i] = row ;
+	cache->prev[i] = -1 ;
+	cache->next[i] = cache->head ;
+	if ( cache->head >= 0 )
+		cache->prev[cache->head] = i ;
+	else
+		cache->tail = i ;
+	cache->head = i ;
+	return row ;
 }
 /* the end of smo_kernel.c */
@@ -54,6 +54,76 @@ unsigned int active_cross_threshold (smo_Settings * settings)
 }
 
 
+/*/ the value of alpha at threshold, F+1 on its upper side or F-1 on its 
+/ lower side, and TRUE if it is in the low set of the threshold if low, or 
+/ in the up set otherwise*/
+static BOOL ordinal_threshold_side ( Alphas * alpha, unsigned int threshold, BOOL low, double * value )
+{
+	if ( alpha->pair->target == threshold )
+	{
+		*value = alpha->f_cache + 1 ;
+		if ( TRUE == low )
+			return ( Io_a == alpha->setname_up || I_Two == alpha->setname_up ) ? TRUE : FALSE ;
+		return ( Io_a == alpha->setname_up || I_Thr == alpha->setname_up ) ? TRUE : FALSE ;
+	}
+	if ( alpha->pair->target == threshold + 1 )
+	{
+		*value = alpha->f_cache - 1 ;
+		if ( TRUE == low )
+			return ( Io_b == alpha->setname_dw || I_Fou == alpha->setname_dw ) ? TRUE : FALSE ;
+		return ( Io_b == alpha->setname_dw || I_One == alpha->setname_dw ) ? TRUE : FALSE ;
+	}
+	return FALSE ;
+}
+
+/*******************************************************************************\
+
+	long unsigned int ordinal_second_order ( Alphas * alpha, unsigned int threshold, BOOL low, long unsigned int extreme, smo_Settings * settings )
+	
+	choose the partner of alpha at threshold by the second-order rule of the 
+	working set selection in libsvm: among the samples in the low set if low, 
+	or in the up set otherwise, that violate the condition with alpha by more 
+	than TOL, take the one of the largest gap*gap/eta, i.e. the decrease of 
+	the objective by an unclipped step, where eta=K11+K22-2K12 comes from the 
+	kernel diagonal and the row of alpha. the candidates are the samples in 
+	Io and the first-order extreme, whose Fi are up to date.
+	input:  the alpha, the threshold, the set of the partner, the index of 
+	        the first-order partner and the pointer to smo_Settings
+	output: the index of the partner, extreme if none does better
+
+\*******************************************************************************/
+
+static long unsigned int ordinal_second_order ( Alphas * alpha, unsigned int threshold, BOOL low, long unsigned int extreme, smo_Settings * settings )
+{
+	Alphas * cand ;
+	long unsigned int i, best = extreme ;
+	double F = 0, value = 0, gap, eta, gain, most = 0 ;
+
+	ordinal_threshold_side( alpha, threshold, low, &F ) ;
+	Get_Kernel_Row( alpha, settings ) ;
+	for ( i = 0 ; i <= Io_CACHE.count ; i ++ )
+	{
+		/* the members of Io, then the extreme*/
+		cand = ( i < Io_CACHE.count ) ? Io_CACHE.member[i] : ALPHA + extreme - 1 ;
+		if ( cand == alpha || FALSE == ordinal_threshold_side( cand, threshold, low, &value ) )
+			continue ;
+		gap = ( TRUE == low ) ? value - F : F - value ;
+		if ( gap <= TOL )
+			continue ;
+		eta = settings->diag[cand - ALPHA] + settings->diag[alpha - ALPHA] - 2.0*Calc_Kernel( cand, alpha, settings ) ;
+		if ( eta <= 0 )
+			eta = TAU ;
+		gain = gap*gap/eta ;
+		if ( gain > most )
+		{
+			most = gain ;
+			best = cand - ALPHA + 1 ;
+		}
+	}
+	return best ;
+}
+
+
 BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 {
 	double F2 = 0 ;
@@ -91,7 +161,11 @@ BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 		F2 = alpha->f_cache ;
 	else
 	{
-		F2 = Calculate_Ordinal_Fi(i2, settings) ;
+		/*/ f_cache is valid for all samples if fcacheall*/
+		if ( TRUE == settings->fcacheall )
+			F2 = alpha->f_cache ;
+		else
+			F2 = Calculate_Ordinal_Fi(i2, settings) ;
 		alpha->f_cache = F2 ;		
 		if (y2<settings->pairs->classes)
 		{
@@ -222,22 +296,31 @@ BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 			{
 				if (TRUE == ordinal_cross_identical( ALPHA + i1 - 1, ALPHA + i3 - 1, y2, settings) )
 					return TRUE ;
-				else 
+				else
+				{
+					settings->stats.rejected += 1 ;
 					printf("%lu and %lu failed in identical takestep.\n",i1,i3) ;
+				}
 			}
 			if (b1==b2)
 			{			
 				if (TRUE ==  ordinal_takestep( ALPHA + i1 - 1, ALPHA + i3 - 1, y2 , settings) )
 					return TRUE ;
-				else 
+				else
+				{
+					settings->stats.rejected += 1 ;
 					printf("%lu and %lu failed in takestep.\n",i1,i3) ;
+				}
 			}
 			else
 			{			
 				if (TRUE ==  ordinal_cross_takestep( ALPHA + i1 - 1,b1, ALPHA + i3 - 1, b2 , settings) )
 					return TRUE ;
-				else 
+				else
+				{
+					settings->stats.rejected += 1 ;
 					printf("%lu and %lu failed in cross takestep.\n",i1,i3) ;
+				}
 			}
 		}
 		/*else //y2!=settings->pairs->classes
@@ -329,22 +412,31 @@ BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 			{
 				if (TRUE == ordinal_cross_identical( ALPHA + i1 - 1, ALPHA + i3 - 1, y2-1, settings) )
 					return TRUE ;
-				else 
+				else
+				{
+					settings->stats.rejected += 1 ;
 					printf("%lu and %lu failed in identical takestep.\n",i1,i3) ;
+				}
 			}
 			else if (b1==b2)
 			{	
 				if (TRUE == ordinal_takestep( ALPHA + i1 - 1, ALPHA + i3 - 1, y2-1, settings) )
 					return TRUE ;
-				else 
+				else
+				{
+					settings->stats.rejected += 1 ;
 					printf("%lu and %lu failed in takestep.\n",i1,i3) ;
+				}
 			}
 			else
 			{	
 				if (TRUE == ordinal_cross_takestep( ALPHA + i1 - 1, b1, ALPHA + i3 - 1, b2, settings) )
 					return TRUE ;
-				else 
+				else
+				{
+					settings->stats.rejected += 1 ;
 					printf("%lu and %lu failed in cross takestep.\n",i1,i3) ;
+				}
 			}
 		}
 		/*else //y2!=1
@@ -390,13 +482,97 @@ BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 }
 
 
+/*******************************************************************************\
+
+	BOOL ordinal_shrinkable ( Alphas * alpha, smo_Settings * settings )
+
+	a sample at bound can be left out of the sweeps if it does not violate KKT
+	and its Fi lies beyond the current b_low and b_up of its thresholds, as 
+	libsvm shrinks the variables whose gradient is beyond m(a) and M(a). 
+	the samples in Io and the current extremes of the bounds are never shrunk.
+	input:  the alpha just examined, and the pointer to smo_Settings
+	output: TRUE if alpha can be shrunk
+
+\*******************************************************************************/
+
+static BOOL ordinal_shrinkable ( Alphas * alpha, smo_Settings * settings )
+{
+	double F = alpha->f_cache ;
+	unsigned int y = alpha->pair->target ;
+	long unsigned int i = alpha - ALPHA + 1 ;
+
+	if ( Io_a == alpha->setname_up || Io_b == alpha->setname_dw )
+		return FALSE ;
+	if ( y < settings->pairs->classes )
+	{
+		if ( i == settings->ij_up[y-1] || i == settings->ij_low[y-1] )
+			return FALSE ;
+		if ( I_Thr == alpha->setname_up && F + 1 <= settings->bmu_low[y-1] )
+			return FALSE ;
+		if ( I_Two == alpha->setname_up && F + 1 >= settings->bmu_up[y-1] )
+			return FALSE ;
+	}
+	if ( y > 1 )
+	{
+		if ( i == settings->ij_up[y-2] || i == settings->ij_low[y-2] )
+			return FALSE ;
+		if ( I_One == alpha->setname_dw && F - 1 <= settings->bmu_low[y-2] )
+			return FALSE ;
+		if ( I_Fou == alpha->setname_dw && F - 1 >= settings->bmu_up[y-2] )
+			return FALSE ;
+	}
+	return TRUE ;
+}
+
+
+/*******************************************************************************\
+
+	BOOL ordinal_progress ( smo_Settings * settings )
+
+	record the size of Io in the trace of settings->stats and call the 
+	progress callback if any, after every sweep and every PROGRESS steps. 
+	a callback returning FALSE sets settings->abort, e.g. on a time budget.
+	input:  the pointer to smo_Settings
+	output: FALSE if SMO has to stop
+
+\*******************************************************************************/
+
+static BOOL ordinal_progress ( smo_Settings * settings )
+{
+	Smo_Stats * stats = &(settings->stats) ;
+	unsigned long int * io ;
+
+	if ( stats->io_count >= stats->io_size )
+	{
+		io = (unsigned long int *) realloc( stats->io, (2*stats->io_size + 64)*sizeof(unsigned long int) ) ;
+		if ( NULL != io )
+		{
+			stats->io = io ;
+			stats->io_size = 2*stats->io_size + 64 ;
+		}
+	}
+	if ( stats->io_count < stats->io_size )
+		stats->io[stats->io_count++] = Io_CACHE.count ;
+	if ( Io_CACHE.count > stats->io_peak )
+		stats->io_peak = Io_CACHE.count ;
+	if ( NULL != settings->progress && FALSE == settings->progress( settings, settings->progress_arg ) )
+		settings->abort = TRUE ;
+	return ( TRUE == settings->abort ) ? FALSE : TRUE ;
+}
+
+
 BOOL smo_ordinal (smo_Settings * settings)
 {
 	BOOL examineAll = TRUE ;
+	BOOL verify = FALSE ;
 	long unsigned int numChanged = 0 ;
+	long unsigned int shrunk = 0 ;
 	Alphas * alpha = NULL ;   
 	long unsigned int loop = 0 ;
+	long unsigned int next = PROGRESS ;
+	long unsigned int i ;
 	unsigned int j ;
+	double start = twall() ;
 	
 	if (NULL == settings)
 		return FALSE ;
@@ -407,7 +583,19 @@ BOOL smo_ordinal (smo_Settings * settings)
 		return FALSE ;
 	SMO_WORKING = TRUE ;
 	
-	Clean_Alphas( ALPHA, settings ) ;
+	/*/ start from the seeded alphas if any, otherwise from zero*/
+	if ( FALSE == settings->warm )
+		Clean_Alphas( ALPHA, settings ) ;
+	settings->warm = FALSE ;
+	settings->shrunk = 0 ;
+	settings->stats.kernels = 0 ;
+	settings->stats.hits = 0 ;
+	settings->stats.misses = 0 ;
+	settings->stats.accepted = 0 ;
+	settings->stats.rejected = 0 ;
+	settings->stats.sweeps = 0 ;
+	settings->stats.io_peak = 0 ;
+	settings->stats.io_count = 0 ;
 	Check_Alphas ( ALPHA, settings ) ;
 
 	if ( TRUE == SMO_DISPLAY )
@@ -420,7 +608,7 @@ BOOL smo_ordinal (smo_Settings * settings)
 		printf("\n") ;
 	}
 
-	tstart() ; /* switch on timer*/
+	tstart( &(settings->timer) ) ; /* switch on timer*/
 
 /*do*/
 {
@@ -433,8 +621,33 @@ BOOL smo_ordinal (smo_Settings * settings)
 			numChanged = 0 ;
 			for ( loop = 1; loop <= settings->pairs->count; loop ++ )
 			{
-				numChanged += ordinal_examine_example( ALPHA + loop - 1, settings ) ; 
+				alpha = ALPHA + loop - 1 ;
+				if ( TRUE == alpha->shrunk )
+					continue ;
+				if ( TRUE == ordinal_examine_example( alpha, settings ) )
+				{
+					numChanged += 1 ;
+					settings->stats.accepted += 1 ;
+					if ( settings->stats.accepted >= next )
+					{
+						next = settings->stats.accepted + PROGRESS ;
+						if ( FALSE == ordinal_progress( settings ) )
+							break ;
+					}
+				}
+				else if ( TRUE == settings->shrinking && FALSE == verify 
+					&& TRUE == ordinal_shrinkable( alpha, settings ) )
+				{
+					/*/ leave it out until the final check*/
+					alpha->shrunk = TRUE ;
+					shrunk += 1 ;
+				}
 			}			
+			if ( shrunk > settings->shrunk )
+				settings->shrunk = shrunk ;
+			settings->stats.sweeps += 1 ;
+			if ( TRUE == settings->abort || FALSE == ordinal_progress( settings ) )
+				break ;
 			if (TRUE == SMO_DISPLAY)
 			{
 				for (loop=1;loop<settings->pairs->classes;loop++)
@@ -451,10 +664,35 @@ BOOL smo_ordinal (smo_Settings * settings)
 			loop = active_cross_threshold (settings) ;
 			while ( loop>0 && numChanged>0 )
 			{
+				if ( settings->stats.accepted >= next )
+				{
+					next = settings->stats.accepted + PROGRESS ;
+					if ( FALSE == ordinal_progress( settings ) )
+						break ;
+				}
+				/*/ within one threshold, the extreme up with its best partner by the 
+				/ second-order gain, or the most violating pair if that fails*/
+				j = settings->imu_up[loop-1] ;
+				if ( TRUE == settings->secondorder && j == settings->imu_low[loop-1] )
+				{
+					i = ordinal_second_order( ALPHA + settings->ij_up[j-1] - 1, j, TRUE, settings->ij_low[j-1], settings ) ;
+					if ( i != settings->ij_low[j-1] && i != settings->ij_up[j-1] )
+					{
+						if ( TRUE == ordinal_takestep( ALPHA + settings->ij_up[j-1] - 1, ALPHA + i - 1, j, settings ) )
+						{
+							numChanged += 1 ;
+							settings->stats.accepted += 1 ;
+							loop = active_cross_threshold (settings) ;
+							continue ;
+						}
+						settings->stats.rejected += 1 ;
+					}
+				}
 				if (TRUE == ordinal_cross_takestep (ALPHA + settings->ij_up[settings->imu_up[loop-1]-1] - 1,settings->imu_up[loop-1],
                                 ALPHA + settings->ij_low[settings->imu_low[loop-1]-1] - 1,settings->imu_low[loop-1], settings) )
 				{
 					numChanged += 1 ;
+					settings->stats.accepted += 1 ;
 					loop = active_cross_threshold (settings) ;
 				}
 				else
@@ -465,16 +703,25 @@ BOOL smo_ordinal (smo_Settings * settings)
 				}
 			}
 			numChanged = 0 ;
+			/*/ stopped, e.g. by the progress callback, the thresholds are still set below*/
 			if ( TRUE == settings->abort )
-			{
-				SMO_WORKING = FALSE ;
-				return FALSE ;
-			}
+				break ;
 		} /* end of if-else*/
 
 		if ( TRUE == examineAll )
 		{
-			examineAll = FALSE ;
+			if ( 0 == numChanged && shrunk > 0 )
+			{
+				/*/ reconstruct Fi of the shrunk samples and sweep over all of them again*/
+				Unshrink_Alphas( settings ) ;
+				shrunk = 0 ;
+				verify = TRUE ;
+			}
+			else
+			{
+				examineAll = FALSE ;
+				verify = FALSE ;
+			}
 		}
 		else if ( 0 == numChanged )
 		{
@@ -613,9 +860,14 @@ BOOL smo_ordinal (smo_Settings * settings)
 /*while (numChanged>0) ;
  outer loop*/ 
 
-	tend() ; /* switch off timer*/ 
-	settings->smo_timing = tval() ;
+	tend( &(settings->timer) ) ; /* switch off timer*/ 
+	settings->smo_timing = tval( &(settings->timer) ) ;
+	/* the first solve on a feature map pays for the map too*/
+	settings->smo_timing += settings->map_timing ;
+	settings->map_timing = 0 ;
 	DURATION += settings->smo_timing ;
+	settings->stats.optimise = twall() - start ;
+	settings->stats.memory = tmemory() ;
 	if (TRUE == SMO_DISPLAY)
 	{
 		j = 0 ;
@@ -633,7 +885,7 @@ BOOL smo_ordinal (smo_Settings * settings)
 				exit(1) ; 
 			}
 		}
-		printf("SMO is done using CPU time %f seconds with %u off-bound SVs.\r\n", settings->smo_timing, j) ;
+		printf("SMO is done using CPU time %f seconds in %lu steps with %u off-bound SVs.\r\n", settings->smo_timing, settings->stats.accepted, j) ;
 	}
 	for (loop=1;loop<settings->pairs->classes;loop++)
 	{
@@ -643,7 +895,7 @@ BOOL smo_ordinal (smo_Settings * settings)
 				settings->imu_up[loop-1], settings->bmu_low[loop-1],settings->imu_low[loop-1], settings->mu[loop-1]) ;			
 		}
 #endif
-		if (settings->bmu_low[loop-1] - settings->bmu_up[loop-1]>TOL)
+		if (FALSE == settings->abort && settings->bmu_low[loop-1] - settings->bmu_up[loop-1]>TOL)
 		{
 			printf("Warning: KKT conditions are violated on bias!!! %f with C=%.3f K=%.3f\r\n",
 				settings->bmu_low[loop-1] + settings->bmu_up[loop-1], VC, KAPPA) ;
@@ -654,7 +906,7 @@ BOOL smo_ordinal (smo_Settings * settings)
 
 		if (loop > 1)
 		{
-			if (settings->biasj[loop-1]+TOL<settings->biasj[loop-2])
+			if (FALSE == settings->abort && settings->biasj[loop-1]+TOL<settings->biasj[loop-2])
 			{
 				printf("Warning: thresholds %lu : %f < thresholds %lu : %f.\n",loop, settings->biasj[loop-1], loop-1, settings->biasj[loop-2]) ;
 				exit(1) ;
@@ -666,7 +918,7 @@ BOOL smo_ordinal (smo_Settings * settings)
 	}
 
 	SMO_WORKING = FALSE ;
-	return TRUE ; 
+	return ( TRUE == settings->abort ) ? FALSE : TRUE ; 
 }
 
 
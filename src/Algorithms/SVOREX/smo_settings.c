@@ -40,6 +40,7 @@ smo_Settings * Create_smo_Settings ( def_Settings * settings )
 	long unsigned int dim = 0 ;
 	long unsigned int i, sz ;
 	double temp = 0 ;
+	double start ;
 	char buf[LENGTH] ;
 	FILE * fid ;
 	
@@ -59,6 +60,7 @@ smo_Settings * Create_smo_Settings ( def_Settings * settings )
 		psetting->p = P ;
 		psetting->method = METHOD ;
 		psetting->kernel = KERNEL ;
+		psetting->kops = NULL ;
 		psetting->testerror = 0 ;
 		psetting->testrate = 0 ;
 		
@@ -163,9 +165,37 @@ smo_Settings * Create_smo_Settings ( def_Settings * settings )
 		psetting->inputfile = NULL ;
 
 		Create_Cache_List( &(psetting->io_cache) ) ;
+		psetting->kcache.row = NULL ;
+		psetting->kcache.prev = NULL ;
+		psetting->kcache.next = NULL ;
+		psetting->pool = NULL ;
+		psetting->weight = NULL ;
+		psetting->primal = FALSE ;
+		psetting->fmap = NULL ;
+		psetting->map_timing = 0 ;
+		psetting->secondorder = settings->secondorder ;
+		psetting->diag = NULL ;
+		memset( &(psetting->stats), 0, sizeof(Smo_Stats) ) ;
+		psetting->progress = NULL ;
+		psetting->progress_arg = NULL ;
+		psetting->threads = settings->threads ;
 		psetting->pairs = &(settings->training) ;
-		psetting->cache_size = psetting->pairs->count ;
+		/* pack the training inputs so that the kernel rows are contiguous */
+		if ( FALSE == Create_Data_Matrix( &(psetting->matrix), psetting->pairs ) )
+		{
+			printf( "Data_Matrix can not be created.\n" );
+			psetting->alpha = NULL ;
+			psetting->inputfile = NULL ;
+			Clear_smo_Settings( psetting ) ;
+			return NULL ;
+		}
+		psetting->cache_size = settings->cache_size ;
 		psetting->cacheall = FALSE ;		
+		psetting->fcacheall = settings->fcacheall ;
+		psetting->warm = FALSE ;
+		psetting->shrinking = settings->shrinking ;
+		psetting->shrunk = 0 ;
+		psetting->seed = 1 ;
 		psetting->ardon = settings->ardon ;
 
 		psetting->epsilon = EPSILON;
@@ -187,6 +217,73 @@ smo_Settings * Create_smo_Settings ( def_Settings * settings )
 			Clear_smo_Settings( psetting ) ;
 			return NULL ;
 		}
+		/* worker threads for the kernel rows and Fi, none if threads <= 1 */
+		/* fold ard and kappa into the packed inputs */
+		if ( FALSE == Scale_Data_Matrix( psetting ) )
+		{
+			printf( "Data_Matrix can not be scaled.\n" );
+			Clear_smo_Settings( psetting ) ;
+			return NULL ;
+		}
+		/* choose the kernel loops once for the whole solve */
+		psetting->kops = Get_Kernel_Ops( &(psetting->matrix), psetting->kernel, psetting->p ) ;
+		psetting->pool = Create_Thread_Pool( psetting->threads ) ;
+		start = twall() ;
+		/* an approximate kernel replaces the inputs by their features, which 
+		   are then trained with the linear kernel in primal form */
+		if ( EXACT != settings->approx )
+		{
+			if ( (POLYNOMIAL == psetting->kernel && psetting->p <= 1) || LINEAR == psetting->kernel )
+				printf( "Warning : the linear kernel is not approximated.\n" ) ;
+			else
+			{
+				tstart( &(psetting->timer) ) ;
+				psetting->fmap = Create_Feature_Map( psetting, settings->approx, settings->rank, 
+					(settings->seeds > 0) ? settings->seeds : 1 ) ;
+				if ( NULL == psetting->fmap || FALSE == Map_Data_Matrix( psetting ) )
+				{
+					printf( "Feature map can not be created.\n" );
+					Clear_smo_Settings( psetting ) ;
+					return NULL ;
+				}
+				psetting->kops = Get_Kernel_Ops( &(psetting->matrix), LINEAR, 1 ) ;
+				if ( NYSTROM == psetting->fmap->approx )
+					psetting->stats.kernels += psetting->fmap->rank*(psetting->fmap->rank+1)/2 
+						+ psetting->matrix.count*psetting->fmap->rank ;
+				tend( &(psetting->timer) ) ;
+				psetting->map_timing = tval( &(psetting->timer) ) ;
+			}
+		}
+		/* the linear kernel, or the features of an approximate one, is kept in 
+		   primal form, as a weight vector over the packed inputs, unless 
+		   categorical inputs make it no product of them */
+		if ( (NULL != psetting->fmap || (POLYNOMIAL == psetting->kernel && psetting->p <= 1) || LINEAR == psetting->kernel) 
+			&& 0 == psetting->matrix.cat )
+		{
+			if ( NULL == (psetting->weight = (double *) calloc(psetting->matrix.cont, sizeof(double))) )
+			{
+				printf( "Weight vector can not be created.\n" );
+				Clear_smo_Settings( psetting ) ;
+				return NULL ;
+			}
+		}
+		/* the kernel diagonal for the second-order selection of working pairs */
+		if ( TRUE == psetting->secondorder )
+		{
+			if ( NULL == (psetting->diag = (double *) malloc(psetting->matrix.count*sizeof(double))) )
+			{
+				printf( "Kernel diagonal can not be created.\n" );
+				Clear_smo_Settings( psetting ) ;
+				return NULL ;
+			}
+			for ( i = 0 ; i < psetting->matrix.count ; i ++ )
+				psetting->diag[i] = psetting->kops->pair( &(psetting->matrix), psetting->p, 
+					psetting->matrix.x + i*psetting->matrix.stride, psetting->matrix.x + i*psetting->matrix.stride ) + 0.001 ;
+			psetting->stats.kernels += psetting->matrix.count ;
+		}
+		/* keep the whole triangle for small problems */
+		if ( psetting->pairs->count <= psetting->cache_size )
+			psetting->cacheall = TRUE ;
 		/* init Alpha Matrix which is hybrid hashing table */
 		if ( NULL == (psetting->alpha = Create_Alphas(psetting) ) )
 		{
@@ -194,7 +291,21 @@ smo_Settings * Create_smo_Settings ( def_Settings * settings )
 			Clear_smo_Settings( psetting ) ;
 			return NULL ;
 		}
-		psetting->cacheall = TRUE ;
+		psetting->stats.precomputed = psetting->stats.kernels ;
+		psetting->stats.kernels = 0 ;
+		psetting->stats.precompute = twall() - start ;
+		/* otherwise a bounded LRU row cache, but none for the linear kernel, 
+		   whose Fi is one product with the weight vector, unless fcacheall 
+		   updates all the samples at every step */
+		if ( FALSE == psetting->cacheall && NULL != psetting->weight && FALSE == psetting->fcacheall )
+			psetting->primal = TRUE ;
+		else if ( FALSE == psetting->cacheall 
+			&& FALSE == Create_Kernel_Cache( &(psetting->kcache), psetting->pairs->count, psetting->cache_size ) )
+		{
+			printf( "Kernel cache can not be created.\n" );
+			Clear_smo_Settings( psetting ) ;
+			return NULL ;
+		}
 		if (TRUE == psetting->smo_display)
 			printf("\r\nsmo_Settings is ready.\r\n") ;
 	}
@@ -242,6 +353,17 @@ void Clear_smo_Settings( smo_Settings * settings )
 		}
 		Clear_Cache_List( &(Io_CACHE) ) ;
 		Clear_Alphas( settings ) ;
+		Clear_Kernel_Cache( &(KCACHE) ) ;
+		Clear_Thread_Pool( POOL ) ;
+		if ( NULL != settings->weight )
+			free( settings->weight ) ;
+		Clear_Data_Matrix( &(MATRIX) ) ;
+		if ( NULL != settings->fmap )
+			Clear_Feature_Map( settings->fmap ) ;
+		if ( NULL != settings->diag )
+			free( settings->diag ) ;
+		if ( NULL != settings->stats.io )
+			free( settings->stats.io ) ;
 		if ( NULL != INPUTFILE )
 			free( INPUTFILE ) ;
 		free ( settings ) ;
@@ -0,0 +1,226 @@
+/*******************************************************************************\
+
+	smo_thread.c in Sequential Minimal Optimization ver2.0
+
+	implements a small pool of worker threads for the parallel loops of SMO,
+	i.e. kernel rows and Fi sweeps. without pthreads the loops run serially.
+
+\*******************************************************************************/
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#include "smo.h"
+
+struct _Thread_Pool
+{
+	unsigned int threads ;          /* number of workers including the caller*/
+#ifndef _WIN32
+	pthread_t * workers ;
+	pthread_mutex_t lock ;
+	pthread_cond_t start ;
+	pthread_cond_t done ;
+#endif
+	unsigned long int generation ;  /* incremented for every job*/
+	unsigned int running ;          /* workers still busy with the job*/
+	BOOL quit ;
+
+	Thread_Task task ;              /* the current job*/
+	void * arg ;
+	unsigned long int count ;
+	unsigned long int chunk ;
+	unsigned long int next ;        /* first index not handed out yet*/
+} ;
+
+
+#ifndef _WIN32
+/* take chunks of the current job until it is exhausted*/
+static void Work_Thread_Pool ( Thread_Pool * pool )
+{
+	unsigned long int begin, end ;
+
+	while ( 1 )
+	{
+		pthread_mutex_lock( &pool->lock ) ;
+		begin = pool->next ;
+		if ( begin < pool->count )
+			pool->next = min(begin + pool->chunk, pool->count) ;
+		end = pool->next ;
+		pthread_mutex_unlock( &pool->lock ) ;
+		if ( begin >= end )
+			return ;
+		pool->task( pool->arg, begin, end, (unsigned int)(begin/pool->chunk) ) ;
+	}
+}
+
+static void * Loop_Thread_Pool ( void * ptr )
+{
+	Thread_Pool * pool = (Thread_Pool *) ptr ;
+	unsigned long int generation = 0 ;
+
+	pthread_mutex_lock( &pool->lock ) ;
+	while ( 1 )
+	{
+		while ( FALSE == pool->quit && generation == pool->generation )
+			pthread_cond_wait( &pool->start, &pool->lock ) ;
+		if ( TRUE == pool->quit )
+			break ;
+		generation = pool->generation ;
+		pthread_mutex_unlock( &pool->lock ) ;
+
+		Work_Thread_Pool( pool ) ;
+
+		pthread_mutex_lock( &pool->lock ) ;
+		pool->running -= 1 ;
+		if ( 0 == pool->running )
+			pthread_cond_signal( &pool->done ) ;
+	}
+	pthread_mutex_unlock( &pool->lock ) ;
+	return NULL ;
+}
+#endif
+
+
+/*******************************************************************************\
+
+	Thread_Pool * Create_Thread_Pool ( unsigned int threads )
+
+	start threads-1 workers, the caller of Run_Thread_Pool being the last one
+	input:  the number of threads
+	output: the pointer to Thread_Pool, or NULL if threads <= 1 or on failure
+
+\*******************************************************************************/
+
+Thread_Pool * Create_Thread_Pool ( unsigned int threads )
+{
+	Thread_Pool * pool = NULL ;
+#ifndef _WIN32
+	unsigned int i ;
+#endif
+
+	if ( threads <= 1 )
+		return NULL ;
+#ifdef _WIN32
+	printf("Warning : threads are not supported, running serially.\n") ;
+	return NULL ;
+#else
+	if ( NULL == (pool = (Thread_Pool *) calloc(1, sizeof(Thread_Pool))) )
+	{
+		printf("Warning : fail to malloc thread pool, running serially.\n") ;
+		return NULL ;
+	}
+	pool->workers = (pthread_t *) malloc((threads-1)*sizeof(pthread_t)) ;
+	if ( NULL == pool->workers )
+	{
+		printf("Warning : fail to malloc thread pool, running serially.\n") ;
+		free( pool ) ;
+		return NULL ;
+	}
+	pthread_mutex_init( &pool->lock, NULL ) ;
+	pthread_cond_init( &pool->start, NULL ) ;
+	pthread_cond_init( &pool->done, NULL ) ;
+	pool->quit = FALSE ;
+	pool->threads = 1 ;
+	for ( i = 0 ; i < threads - 1 ; i ++ )
+	{
+		if ( 0 != pthread_create( pool->workers + i, NULL, Loop_Thread_Pool, pool ) )
+		{
+			printf("Warning : only %u threads are started.\n", pool->threads) ;
+			break ;
+		}
+		pool->threads += 1 ;
+	}
+	if ( pool->threads <= 1 )
+	{
+		Clear_Thread_Pool( pool ) ;
+		return NULL ;
+	}
+	return pool ;
+#endif
+}
+
+void Clear_Thread_Pool ( Thread_Pool * pool )
+{
+#ifndef _WIN32
+	unsigned int i ;
+
+	if ( NULL == pool )
+		return ;
+	pthread_mutex_lock( &pool->lock ) ;
+	pool->quit = TRUE ;
+	pthread_cond_broadcast( &pool->start ) ;
+	pthread_mutex_unlock( &pool->lock ) ;
+	for ( i = 0 ; i + 1 < pool->threads ; i ++ )
+		pthread_join( pool->workers[i], NULL ) ;
+	pthread_mutex_destroy( &pool->lock ) ;
+	pthread_cond_destroy( &pool->start ) ;
+	pthread_cond_destroy( &pool->done ) ;
+	free( pool->workers ) ;
+	free( pool ) ;
+#endif
+}
+
+unsigned int Thread_Pool_Size ( Thread_Pool * pool )
+{
+	if ( NULL == pool )
+		return 1 ;
+	return pool->threads ;
+}
+
+/*******************************************************************************\
+
+	void Run_Thread_Pool ( Thread_Pool * pool, unsigned long int count,
+		unsigned long int chunk, Thread_Task task, void * arg )
+
+	call task(arg, begin, end, block) on the consecutive blocks [begin, end) of
+	[0, count) with at most chunk indices each, in parallel, and wait for all
+	of them. block = begin/chunk, so that a caller may keep partial results
+	per block and combine them in a fixed order. runs serially if pool is NULL.
+	input:  the pool, the range, the block size, the task and its argument
+	output: none
+
+\*******************************************************************************/
+
+void Run_Thread_Pool ( Thread_Pool * pool, unsigned long int count,
+	unsigned long int chunk, Thread_Task task, void * arg )
+{
+	unsigned long int begin ;
+
+	if ( 0 == count || NULL == task )
+		return ;
+	if ( 0 == chunk )
+		chunk = count ;
+	if ( NULL == pool || chunk >= count )
+	{
+		for ( begin = 0 ; begin < count ; begin += chunk )
+			task( arg, begin, min(begin + chunk, count), (unsigned int)(begin/chunk) ) ;
+		return ;
+	}
+#ifndef _WIN32
+	pthread_mutex_lock( &pool->lock ) ;
+	pool->task = task ;
+	pool->arg = arg ;
+	pool->count = count ;
+	pool->chunk = chunk ;
+	pool->next = 0 ;
+	pool->running = pool->threads - 1 ;
+	pool->generation += 1 ;
+	pthread_cond_broadcast( &pool->start ) ;
+	pthread_mutex_unlock( &pool->lock ) ;
+
+	Work_Thread_Pool( pool ) ;
+
+	pthread_mutex_lock( &pool->lock ) ;
+	while ( pool->running > 0 )
+		pthread_cond_wait( &pool->done, &pool->lock ) ;
+	pthread_mutex_unlock( &pool->lock ) ;
+#endif
+}
+
+/* the end of smo_thread.c */
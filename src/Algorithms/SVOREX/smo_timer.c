@@ -1,9 +1,16 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* for RUSAGE_THREAD */
+#endif
 #include <stdio.h>
 #include <string.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
+#include "smo.h"
+
+/* every solver keeps its own Smo_Timer in smo_Settings and the timers count
+   the CPU time of the calling thread only, so that solvers may run concurrently */
 
 
 #ifdef _WIN32
@@ -11,7 +18,6 @@
 __int64 FileTimeToQuadWord (PFILETIME pft) {
    return(Int64ShllMod32(Int64ShllMod32(pft->dwHighDateTime, 16),16) | pft->dwLowDateTime);
 }
-static double _tstart, _tend;
 
 /* Subroutine */ 
 void bmr_timer(double *ttime)
@@ -36,47 +42,114 @@ void bmr_timer(double *ttime)
 }
 
 
-void tstart(void)
+void tstart(Smo_Timer * timer)
+{
+bmr_timer(&(timer->start)) ;
+}
+void tend(Smo_Timer * timer)
+{
+bmr_timer(&(timer->end)) ;
+}
+
+/* CPU time of the whole process, for timing parallel work */
+double tcpu(void)
 {
-bmr_timer(&_tstart) ;
+	FILETIME ftKernelTime, ftUserTime, ftDummy ;
+
+	GetProcessTimes(GetCurrentProcess(), &ftDummy, &ftDummy, &ftKernelTime, &ftUserTime) ;
+	return (double)(FileTimeToQuadWord(&ftKernelTime) + FileTimeToQuadWord(&ftUserTime))*(1.0E-7) ;
 }
-void tend(void)
+
+/* wall clock time in seconds, for the phases of the solver */
+double twall(void)
 {
-bmr_timer(&_tend) ;
+	LARGE_INTEGER count, frequency ;
+
+	QueryPerformanceCounter(&count) ;
+	QueryPerformanceFrequency(&frequency) ;
+	return (double)count.QuadPart/(double)frequency.QuadPart ;
 }
 
-double tval()
+/* peak resident memory in MB, not available here */
+double tmemory(void)
 {
-	return (_tend - _tstart) ;
+	return 0 ;
 }
 #else
 #include <sys/resource.h>
 #include <sys/time.h>
 #include <unistd.h>
-static struct rusage _tstart, _tend;
+#ifndef RUSAGE_THREAD
+#define RUSAGE_THREAD RUSAGE_SELF
+#endif
+
+static double bmr_timer(int who)
+{
+	struct rusage usage ;
+
+	getrusage(who,&usage) ;
+	return (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec/(1000*1000)
+		+ (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec/(1000*1000) ;
+}
 
-void tstart(void)
+void tstart(Smo_Timer * timer)
 {
-	/*gettimeofday(&_tstart, &tz);*/
-	getrusage(RUSAGE_SELF,&_tstart) ;
+	timer->start = bmr_timer(RUSAGE_THREAD) ;
 }
-void tend(void)
+void tend(Smo_Timer * timer)
 {
-	/*gettimeofday(&_tend,&tz);*/
-	getrusage(RUSAGE_SELF,&_tend) ;
+	timer->end = bmr_timer(RUSAGE_THREAD) ;
 }
 
-double tval()
+/* CPU time of the whole process, for timing parallel work */
+double tcpu(void)
 {
-	double t1, t2;
+	return bmr_timer(RUSAGE_SELF) ;
+}
 
-	t1 =  (double)_tstart.ru_utime.tv_sec + (double)_tstart.ru_utime.tv_usec/(1000*1000);
-	t1 +=  (double)_tstart.ru_stime.tv_sec + (double)_tstart.ru_stime.tv_usec/(1000*1000);
-	t2 =  (double)_tend.ru_utime.tv_sec + (double)_tend.ru_utime.tv_usec/(1000*1000);
-	t2 +=  (double)_tend.ru_stime.tv_sec + (double)_tend.ru_stime.tv_usec/(1000*1000);
-	return t2-t1;
+/* wall clock time in seconds, for the phases of the solver */
+double twall(void)
+{
+	struct timeval now ;
+
+	gettimeofday(&now, NULL) ;
+	return (double)now.tv_sec + (double)now.tv_usec/(1000*1000) ;
+}
+
+/* peak resident memory of the process in MB */
+double tmemory(void)
+{
+	struct rusage usage ;
+
+	getrusage(RUSAGE_SELF,&usage) ;
+#ifdef __APPLE__
+	return (double)usage.ru_maxrss/(1024*1024) ;
+#else
+	return (double)usage.ru_maxrss/1024 ;
+#endif
 }
 #endif
+
+double tval(Smo_Timer * timer)
+{
+	return (timer->end - timer->start) ;
+}
+
+/* a uniform random number in [0,1) from the stream in seed, by xorshift32,
+   so that every solver or cross validation draws from a stream of its own
+   instead of the shared one of rand() */
+double urand(unsigned int * seed)
+{
+	unsigned long int x = *seed & 0xFFFFFFFFUL ;
+
+	if (0 == x)
+		x = 2463534242UL ;
+	x ^= (x << 13) & 0xFFFFFFFFUL ;
+	x ^= x >> 17 ;
+	x ^= (x << 5) & 0xFFFFFFFFUL ;
+	*seed = (unsigned int) x ;
+	return (double)x/4294967296.0 ;
+}
 #ifdef _WIN32
 #include <windows.h>
 #define SLASHC		'\\'
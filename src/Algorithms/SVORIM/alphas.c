@@ -18,6 +18,35 @@
 #include "smo.h"
 
 
+typedef struct _Kernel_Task
+{
+	Alphas * alphas ;
+	smo_Settings * settings ;
+} Kernel_Task ;
+
+/* fill the rows [begin,end) of the kernel triangle from the packed inputs*/
+static void Task_Kernel_Rows ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	Kernel_Task * task = (Kernel_Task *) arg ;
+	smo_Settings * settings = task->settings ;
+	Alphas * alpha ;
+	double * xi ;
+	unsigned long int i, count = 0 ;
+
+	for ( i = begin ; i < end ; i ++ )
+	{
+		alpha = task->alphas + i ;
+		if ( NULL == alpha->kernel )
+			continue ;
+		xi = MATRIX.x + i*MATRIX.stride ;
+		KOPS->row( &(MATRIX), P, xi, 0, i+1, alpha->kernel ) ;
+		alpha->kernel[i] += 0.001 ;
+		count += i + 1 ;
+	}
+	COUNT_ADD( settings->stats.kernels, count ) ;
+}
+
+
 /*******************************************************************************\
 
 	Alphas * Create_Alphas ( smo_Settings * settings )
@@ -35,6 +64,7 @@ Alphas * Create_Alphas ( smo_Settings * settings )
 	Alphas * alphas = NULL ;
 	Data_List * pairs = NULL ;
 	unsigned int  i = 0, j ;
+	Kernel_Task task ;
 	
 	if ( NULL == settings )
 	{
@@ -60,25 +90,30 @@ Alphas * Create_Alphas ( smo_Settings * settings )
 		exit(1) ;		
 	}
 
+	if ( MATRIX.count != pairs->count || NULL == MATRIX.x )
+	{ 
+		printf( "\nFATAL ERROR : Data_Matrix have not be initialized.\n") ;
+		free( alphas ) ;
+		return  NULL ;
+	}
+
 	pair = pairs->front ;
-	while ( pair != NULL )
+	for ( i = 0 ; i < MATRIX.count ; i ++ )
 	{		
 		alpha = alphas + i ;
-		i += 1 ;	
 		alpha->f_cache = 0 ;
 		alpha->pair = pair ;
 		alpha->kernel = NULL ;
-		alpha->kernel = (double *) malloc(i*sizeof(double)) ;
-		if ( NULL == alpha->kernel )
+		/* keep the whole triangle only if it fits into the cache, otherwise
+		   the rows are computed on demand by Get_Kernel_Row*/
+		if ( TRUE == settings->cacheall )
 		{
-			printf("Fatal Error : fail to malloc kernel cache.\n") ;
-			exit(1) ;
-		}
-		else
-		{
-			/* initial the kernel matrix cache*/
-			for (j=0 ; j<i ; j++)
-				alpha->kernel[j] = Calc_Kernel(alpha, alphas+j, settings) ;	
+			alpha->kernel = (double *) malloc((i+1)*sizeof(double)) ;
+			if ( NULL == alpha->kernel )
+			{
+				printf("Fatal Error : fail to malloc kernel cache.\n") ;
+				exit(1) ;
+			}
 		}
 		alpha->alpha = (double *) calloc(settings->pairs->classes-1,sizeof(double)) ;
 		alpha->setname = (Set_Name * ) malloc((settings->pairs->classes-1)*sizeof(Set_Name)) ;	
@@ -89,9 +124,17 @@ Alphas * Create_Alphas ( smo_Settings * settings )
 		}
 		for (j=0;j<settings->pairs->classes-1;j++)
 			alpha->setname[j] = Get_Ordinal_Label (alpha, j+1, settings) ;
-		alpha->cache = NULL ;
+		alpha->cache = 0 ;
+		alpha->shrunk = FALSE ;
 		pair = pair->next ;
 	}
+	/* initial the kernel matrix cache, a few rows per thread at a time*/
+	if ( TRUE == settings->cacheall )
+	{
+		task.alphas = alphas ;
+		task.settings = settings ;
+		Run_Thread_Pool( POOL, MATRIX.count, 16, Task_Kernel_Rows, &task ) ;
+	}
 	return alphas ;
 } /* end of Create_Alphas*/
 
@@ -124,6 +167,9 @@ BOOL Clear_Alphas ( smo_Settings * settings )
 		return FALSE ;
 	}
 
+	if ( NULL == ALPHA )
+		return FALSE ;
+
 	for (i=0;i<settings->pairs->count;i++)
 	{
 		alpha = ALPHA + i ;
@@ -167,6 +213,8 @@ BOOL Clean_Alphas ( Alphas * alphas, smo_Settings * settings )
 		printf("\nFATAL ERROR : input is NULL in Create_Alphas.\n") ;
 		return FALSE ;
 	}
+	if ( NULL != settings->weight )
+		memset( settings->weight, 0, MATRIX.cont*sizeof(double) ) ;
 	
 	node = pairs->front ;
 	while (NULL != node)
@@ -179,7 +227,8 @@ BOOL Clean_Alphas ( Alphas * alphas, smo_Settings * settings )
 			alpha->alpha[j] = 0 ;	
 			alpha->setname[j] = Get_Ordinal_Label (alpha, j+1, settings) ;
 		}
-		alpha->cache = NULL ; 
+		alpha->cache = 0 ; 
+		alpha->shrunk = FALSE ;
 		alpha->pair = node ;			
 		node = node->next ;
 	}
@@ -187,6 +236,108 @@ BOOL Clean_Alphas ( Alphas * alphas, smo_Settings * settings )
 
 } /* end of Clean_Alphas*/
 
+/*******************************************************************************\
+
+	BOOL Seed_Alphas ( Alphas * alphas, double vc, smo_Settings * settings )
+	
+	scale the solution found at the regularization factor vc to the current VC,
+	so that the next smo_ordinal starts from it rather than from zero 
+	input:  the pointer to the head of Alphas matrix, the former C and the pointer to smo_Settings 
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Seed_Alphas ( Alphas * alphas, double vc, smo_Settings * settings )
+{
+	Alphas * alpha ;
+	long unsigned int i ;
+	unsigned int j ;
+	double ratio ;
+
+	if ( NULL == alphas || NULL == settings || vc <= 0 )
+	{
+		printf("\nFATAL ERROR : input is wrong in Seed_Alphas.\n") ;
+		return FALSE ;
+	}
+
+	ratio = VC / vc ;
+	for ( i = 0 ; i < settings->pairs->count ; i ++ )
+	{
+		alpha = alphas + i ;
+		for ( j = 0 ; j < settings->pairs->classes-1 ; j ++ )
+		{
+			/* keep the bounded alphas exactly on the new bound */
+			if ( fabs(alpha->alpha[j] - vc) < EPS*EPS*EPS )
+				alpha->alpha[j] = VC ;
+			else
+				alpha->alpha[j] = alpha->alpha[j] * ratio ;
+		}
+	}
+	settings->warm = TRUE ;
+	return TRUE ;
+} /* end of Seed_Alphas*/
+
+/*******************************************************************************\
+
+	BOOL Assign_Alphas ( Alphas * alphas, double * init, smo_Settings * settings )
+	
+	take the alphas of every sample at every threshold from init, a column major
+	matrix of count rows and classes-1 columns, as the initial point of the next 
+	smo_ordinal. the seed is refused if it is out of the box, or if the alphas 
+	on both sides of any threshold do not balance. 
+	input:  the pointer to the head of Alphas matrix, the initial alphas and the pointer to smo_Settings 
+	output: TRUE if the alphas are seeded, otherwise FALSE and they are cleaned
+
+\*******************************************************************************/
+
+BOOL Assign_Alphas ( Alphas * alphas, double * init, smo_Settings * settings )
+{
+	Alphas * alpha ;
+	long unsigned int i ;
+	unsigned int j ;
+	double lower, upper ;
+	BOOL feasible = TRUE ;
+
+	if ( NULL == alphas || NULL == init || NULL == settings )
+	{
+		printf("\nFATAL ERROR : input is NULL in Assign_Alphas.\n") ;
+		return FALSE ;
+	}
+
+	for ( j = 0 ; j < settings->pairs->classes-1 && TRUE == feasible ; j ++ )
+	{
+		lower = 0 ;
+		upper = 0 ;
+		for ( i = 0 ; i < settings->pairs->count ; i ++ )
+		{
+			alpha = alphas + i ;
+			alpha->alpha[j] = init[i + j*settings->pairs->count] ;
+			if ( alpha->alpha[j] > VC + EPS || alpha->alpha[j] < -EPS )
+				feasible = FALSE ;
+			if ( alpha->alpha[j] > VC )
+				alpha->alpha[j] = VC ;
+			else if ( alpha->alpha[j] < 0 )
+				alpha->alpha[j] = 0 ;
+			if ( alpha->pair->target > j+1 )
+				lower += alpha->alpha[j] ;
+			else
+				upper += alpha->alpha[j] ;
+		}
+		if ( fabs(lower - upper) > EPS )
+			feasible = FALSE ;
+	}
+	if ( FALSE == feasible )
+	{
+		printf("Warning : the initial alphas are not feasible, SMO starts from zero.\n") ;
+		Clean_Alphas( alphas, settings ) ;
+		settings->warm = FALSE ;
+		return FALSE ;
+	}
+	settings->warm = TRUE ;
+	return TRUE ;
+} /* end of Assign_Alphas*/
+
+
 /*******************************************************************************\
 
 	BOOL Check_Alphas ( Alphas *, smo_Settings * settings )
@@ -232,13 +383,15 @@ BOOL Check_Alphas ( Alphas * alphas, smo_Settings * settings )
 				alpha->alpha[j] = 0 ;
 			alpha->setname[j] = Get_Ordinal_Label (alpha, j+1, settings) ; 
 		}
-		alpha->f_cache = Calculate_Ordinal_Fi(i+1,settings) ;
-		alpha->cache = NULL ; /* clear the reference to Io_Cache here */
+		alpha->cache = 0 ; /* clear the reference to Io_Cache here */
+		alpha->shrunk = FALSE ;
 		if (alpha->pair != node)
 			printf("error in alpha or data list.\n") ;			
 		node = node->next ;	
 		i += 1 ;
 	}
+	/* Fi from the clipped alphas*/
+	Refresh_Ordinal_Fi( settings ) ;
 	
 	/* initial b_up b_low*/		
 	for (loop = 1 ; loop < settings->pairs->classes ; loop ++)
@@ -10,9 +10,16 @@
 
 \*******************************************************************************/
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef _WIN32
+    #include <malloc.h>
+#endif
 #include "smo.h"
 
 
@@ -48,6 +55,8 @@ BOOL Create_Data_List ( Data_List * list )
 	list -> x_mean = NULL ;
 	list -> front = NULL ;
 	list -> rear = NULL ;
+	list -> block = NULL ;
+	list -> ld = 0 ;
 	list -> classes = 0 ;
 	list -> filename = NULL ;
 	list -> labelnum = NULL ;
@@ -251,7 +260,8 @@ BOOL Clear_Data_List ( Data_List * list )
 			printf ("%f\n\n", temp->target) ;
 #endif
 			list->count -- ;
-			free (temp->point) ;
+			if (NULL == list->block && 0 == list->ld)
+				free (temp->point) ;
 			free (temp) ;
 		}
 		else 
@@ -282,6 +292,12 @@ BOOL Clear_Data_List ( Data_List * list )
 		list -> deviation = 0 ;		
 		list -> front = NULL ;
 		list -> rear = NULL ;
+		if ( NULL != list->block )
+		{
+			free ( list->block ) ;
+			list->block = NULL ;
+		}
+		list->ld = 0 ;
 		if ( NULL != list->x_mean )
 		{
 			free ( list->x_mean ) ;
@@ -408,4 +424,217 @@ BOOL Clear_Label_Data_List ( Data_List * list )
 	return TRUE ;
 }
 
+/*******************************************************************************\
+
+	BOOL Init_Data_Matrix ( Data_Matrix * matrix, unsigned long int count, unsigned int dimen, int * featuretype ) 
+	
+	allocate the block of count packed rows and the column layout for inputs 
+	of dimen entries, with the continuous inputs of a row first and the 
+	categorical ones after them, each block padded to a multiple of ROWALIGN 
+	doubles, so that the kernel can sweep both blocks without looking at 
+	featuretype. the rows are left to be filled by Pack_Data_Point.
+	input:  the pointer to Data_Matrix, the number of rows, the dimension and 
+	        the feature types, NULL if all inputs are continuous
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Init_Data_Matrix ( Data_Matrix * matrix, unsigned long int count, unsigned int dimen, int * featuretype )
+{
+	unsigned int k, n ;
+
+	if ( NULL == matrix )
+	{
+		printf("\r\nFATAL ERROR : input pointer is NULL.\r\n") ;
+		return FALSE ;
+	}
+	matrix->count = count ;
+	matrix->dimen = dimen ;
+	matrix->numeric = 0 ;
+	for ( k = 0 ; k < matrix->dimen ; k ++ )
+	{
+		if ( NULL == featuretype || 0 == featuretype[k] )
+			matrix->numeric += 1 ;
+	}
+	matrix->cont = ((matrix->numeric + ROWALIGN - 1)/ROWALIGN)*ROWALIGN ;
+	matrix->cat = ((matrix->dimen - matrix->numeric + ROWALIGN - 1)/ROWALIGN)*ROWALIGN ;
+	matrix->stride = matrix->cont + matrix->cat ;
+	matrix->sumweight = matrix->dimen - matrix->numeric ;
+	matrix->scaled = FALSE ;
+	matrix->x = NULL ;
+	matrix->target = NULL ;
+	matrix->fold = NULL ;
+	matrix->column = NULL ;
+	matrix->scale = NULL ;
+	matrix->weight = NULL ;
+	if ( 0 == matrix->count || 0 == matrix->stride )
+		return FALSE ;
+
+#ifdef _WIN32
+	matrix->x = (double *) _aligned_malloc(matrix->count*matrix->stride*sizeof(double), ROWALIGN*sizeof(double)) ;
+#else
+	if ( 0 != posix_memalign((void **)&matrix->x, ROWALIGN*sizeof(double), matrix->count*matrix->stride*sizeof(double)) )
+		matrix->x = NULL ;
+#endif
+	matrix->target = (unsigned int *) malloc(matrix->count*sizeof(unsigned int)) ;
+	matrix->fold = (int *) malloc(matrix->count*sizeof(int)) ;
+	matrix->column = (unsigned int *) malloc(matrix->dimen*sizeof(unsigned int)) ;
+	matrix->scale = (double *) malloc((matrix->cont+1)*sizeof(double)) ;
+	matrix->weight = (double *) malloc((matrix->cat+1)*sizeof(double)) ;
+	if ( NULL == matrix->x || NULL == matrix->target || NULL == matrix->fold 
+		|| NULL == matrix->column || NULL == matrix->scale || NULL == matrix->weight )
+	{
+		printf("\r\nFATAL ERROR : fail to malloc Data_Matrix.\r\n") ;
+		Clear_Data_Matrix( matrix ) ;
+		return FALSE ;
+	}
+
+	/* continuous columns first, then the categorical ones, in input order*/
+	n = 0 ;
+	for ( k = 0 ; k < matrix->dimen ; k ++ )
+	{
+		if ( NULL == featuretype || 0 == featuretype[k] )
+			matrix->column[n++] = k ;
+	}
+	for ( k = 0 ; k < matrix->dimen ; k ++ )
+	{
+		if ( NULL != featuretype && 0 != featuretype[k] )
+			matrix->column[n++] = k ;
+	}
+	for ( k = 0 ; k < matrix->cont ; k ++ )
+		matrix->scale[k] = (k < matrix->numeric) ? 1.0 : 0.0 ;
+	for ( k = 0 ; k < matrix->cat ; k ++ )
+		matrix->weight[k] = (k < matrix->dimen - matrix->numeric) ? 1.0 : 0.0 ;
+	return TRUE ;
+}
+
+/*******************************************************************************\
+
+	BOOL Create_Data_Matrix ( Data_Matrix * matrix, Data_List * list ) 
+	
+	pack the inputs of Data_List into one aligned row-major block, and the 
+	targets and folds into parallel arrays, in the order of the list. 
+	the points read in place with ld apart are gathered row by row, and 
+	normalized here if normalized_input is set, so that they are copied once.
+	the inputs are not scaled until Scale_Data_Matrix is called.
+	input:  the pointer to Data_Matrix and the pointer to the head of Data_List
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Create_Data_Matrix ( Data_Matrix * matrix, Data_List * list )
+{
+	Data_Node * node = NULL ;
+	double * row = NULL ;
+	unsigned long int i = 0 ;
+	unsigned int k ;
+
+	if ( NULL == matrix || NULL == list )
+	{
+		printf("\r\nFATAL ERROR : input pointer is NULL.\r\n") ;
+		return FALSE ;
+	}
+	if ( FALSE == Init_Data_Matrix( matrix, list->count, list->dimen, list->featuretype ) )
+		return FALSE ;
+	if ( 0 < list->ld && NULL == (row = (double *) malloc( (list->dimen+1) * sizeof(double) )) )
+	{
+		printf("\r\nFATAL ERROR : fail to malloc memory.\r\n") ;
+		Clear_Data_Matrix( matrix ) ;
+		return FALSE ;
+	}
+
+	node = list->front ;
+	while ( NULL != node && i < matrix->count )
+	{
+		if ( NULL != row )
+		{
+			for ( k = 0 ; k < list->dimen ; k ++ )
+			{
+				row[k] = node->point[k*list->ld] ;
+				if ( TRUE == list->normalized_input )
+					row[k] = (list->x_devi[k] > 0) ? (row[k]-list->x_mean[k])/list->x_devi[k] : 0 ;
+			}
+			row[list->dimen] = 0 ;
+			Pack_Data_Point( matrix, row, matrix->x + i*matrix->stride ) ;
+		}
+		else
+			Pack_Data_Point( matrix, node->point, matrix->x + i*matrix->stride ) ;
+		matrix->target[i] = node->target ;
+		matrix->fold[i] = node->fold ;
+		node = node->next ;
+		i ++ ;
+	}
+	if ( NULL != row )
+		free( row ) ;
+	if ( i != matrix->count || NULL != node )
+	{
+		printf("\r\nFATAL ERROR : Data_List count is inconsistent.\r\n") ;
+		Clear_Data_Matrix( matrix ) ;
+		return FALSE ;
+	}
+	return TRUE ;
+}
+
+/*******************************************************************************\
+
+	BOOL Pack_Data_Point ( Data_Matrix * matrix, double * point, double * x ) 
+	
+	write an input vector in the layout of the rows of Data_Matrix, i.e. 
+	reordered, scaled and padded, so that it can be passed to Calculate_Kernel 
+	together with the rows of the matrix.
+	input:  the pointer to Data_Matrix, the input vector of dimen entries and 
+	        the output of stride entries
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Pack_Data_Point ( Data_Matrix * matrix, double * point, double * x )
+{
+	unsigned int k ;
+
+	if ( NULL == matrix || NULL == point || NULL == x || NULL == matrix->column )
+		return FALSE ;
+	for ( k = 0 ; k < matrix->numeric ; k ++ )
+		x[k] = matrix->scale[k] * point[matrix->column[k]] ;
+	for ( ; k < matrix->cont ; k ++ )
+		x[k] = 0 ;
+	for ( k = 0 ; k < matrix->dimen - matrix->numeric ; k ++ )
+		x[matrix->cont + k] = point[matrix->column[matrix->numeric + k]] ;
+	for ( ; k < matrix->cat ; k ++ )
+		x[matrix->cont + k] = 0 ;
+	return TRUE ;
+}
+
+
+BOOL Clear_Data_Matrix ( Data_Matrix * matrix )
+{
+	if ( NULL == matrix )
+		return FALSE ;
+	if ( NULL != matrix->x )
+	{
+#ifdef _WIN32
+		_aligned_free( matrix->x ) ;
+#else
+		free( matrix->x ) ;
+#endif
+	}
+	if ( NULL != matrix->target )
+		free( matrix->target ) ;
+	if ( NULL != matrix->fold )
+		free( matrix->fold ) ;
+	if ( NULL != matrix->column )
+		free( matrix->column ) ;
+	if ( NULL != matrix->scale )
+		free( matrix->scale ) ;
+	if ( NULL != matrix->weight )
+		free( matrix->weight ) ;
+	matrix->x = NULL ;
+	matrix->target = NULL ;
+	matrix->fold = NULL ;
+	matrix->column = NULL ;
+	matrix->scale = NULL ;
+	matrix->weight = NULL ;
+	matrix->count = 0 ;
+	return TRUE ;
+}
 
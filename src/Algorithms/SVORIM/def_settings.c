@@ -63,6 +63,13 @@ def_Settings * Create_def_Settings_Matlab ( void )
 	INDEX = 1 ;
 	
 	settings->cache_size = DEF_CACHE ;
+	settings->threads = DEF_THREADS ;
+	settings->fcacheall = DEF_FCACHEALL ;
+	settings->seeding = DEF_SEEDING ;
+	settings->shrinking = DEF_SHRINKING ;
+	settings->approx = DEF_APPROX ;
+	settings->rank = DEF_RANK ;
+	settings->secondorder = DEF_SECONDORDER ;
 	settings->lnC_step = DEF_COARSESTEP ;
 	settings->lnK_step = DEF_COARSESTEP ;
 	settings->lnC_start = DEF_INFERLNC ;
@@ -134,7 +141,7 @@ def_Settings * Create_def_Settings_Matlab ( void )
 	return settings ; 
 }
 
-BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol, double ** train)
+BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol, double * train)
 {
 	char buf[LENGTH] ;
 	char msg[20] ;
@@ -201,7 +208,7 @@ BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol,
 
 
 		/* load data into pairs */ 
-				if ( FALSE == smo_Loadfile_Matlab(&(defsetting->pairs), defsetting->inputfile, 0, nFil,nCol,train) )
+				if ( FALSE == smo_Loadfile_Matlab(&(defsetting->pairs), defsetting->inputfile, 0, nFil,nCol,train,nFil) )
 
 			batchgoon = FALSE ;
 	}
@@ -209,7 +216,7 @@ BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol,
 	{
 
 		/* load data into pairs */
-		if ( FALSE == smo_Loadfile_Matlab(&(defsetting->pairs), defsetting->inputfile, 0, nFil,nCol,train) )
+		if ( FALSE == smo_Loadfile_Matlab(&(defsetting->pairs), defsetting->inputfile, 0, nFil,nCol,train,nFil) )
 
 		{	
 			batchgoon = FALSE ;
@@ -224,7 +231,6 @@ BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol,
 #endif
 	}	
 
-	defsetting->cache_size = DEF_CACHE ;	
 	defsetting->time = 0 ;
 
 	defsetting->lnC_step = defsetting->def_lnC_step ;
@@ -330,6 +336,13 @@ def_Settings * Create_def_Settings ( char * filename )
 	INDEX = 1 ;
 	
 	settings->cache_size = DEF_CACHE ;
+	settings->threads = DEF_THREADS ;
+	settings->fcacheall = DEF_FCACHEALL ;
+	settings->seeding = DEF_SEEDING ;
+	settings->shrinking = DEF_SHRINKING ;
+	settings->approx = DEF_APPROX ;
+	settings->rank = DEF_RANK ;
+	settings->secondorder = DEF_SECONDORDER ;
 	settings->lnC_step = DEF_COARSESTEP ;
 	settings->lnK_step = DEF_COARSESTEP ;
 	settings->lnC_start = DEF_INFERLNC ;
@@ -471,13 +484,13 @@ BOOL Update_def_Settings( def_Settings * defsetting )
 		if ( NULL == ( defsetting->testfile = strdup(buf) ) )
 			batchgoon = FALSE ;
 		// load data into pairs 
-		if ( FALSE == smo_Loadfile(&(defsetting->pairs), defsetting->inputfile, 0) )
+		if ( FALSE == smo_Loadfile(&(defsetting->pairs), defsetting->inputfile, 0, defsetting->threads) )
 			batchgoon = FALSE ;
 	}
 	else
 	{
 		// load data into pairs 
-		if ( FALSE == smo_Loadfile(&(defsetting->pairs), defsetting->inputfile, 0) )
+		if ( FALSE == smo_Loadfile(&(defsetting->pairs), defsetting->inputfile, 0, defsetting->threads) )
 		{	
 			batchgoon = FALSE ;
 			printf("Failed to load training data from the file %s\n", defsetting->inputfile) ;
@@ -491,7 +504,6 @@ BOOL Update_def_Settings( def_Settings * defsetting )
 #endif
 	}	
 
-	defsetting->cache_size = DEF_CACHE ;	
 	defsetting->time = 0 ;
 
 	defsetting->lnC_step = defsetting->def_lnC_step ;
@@ -504,7 +516,7 @@ BOOL Update_def_Settings( def_Settings * defsetting )
 	// load data into pairs 
 	// load testing data into pairs
 	//if (batchgoon == TRUE)
-	//	if ( FALSE == smo_Loadfile(&(defsetting->testdata), defsetting->testfile, defsetting->pairs.dimen) )
+	//	if ( FALSE == smo_Loadfile(&(defsetting->testdata), defsetting->testfile, defsetting->pairs.dimen, defsetting->threads) )
 	//		printf ("Failed to load testing data from the file %s", defsetting->testfile ) ;	
 	
 	return batchgoon ;	
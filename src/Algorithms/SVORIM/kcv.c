@@ -108,9 +108,9 @@ kcv_Settings * Create_Kcv ( def_Settings * defsetting )
 	}
 	
 	if (defsetting->seeds>0)
-		srand(defsetting->seeds) ;
+		kcvsetting->seed = defsetting->seeds ;
 	else
-		srand((unsigned)time( NULL )) ;
+		kcvsetting->seed = (unsigned)time( NULL ) ;
 
 	free(labelnum) ;
 	return kcvsetting ;	
@@ -145,12 +145,12 @@ BOOL Rehearsal_Kcv ( kcv_Settings * kcvsetting, def_Settings * defsetting )
         	                rdseed = defsetting->seeds ;
                 	else
                         	rdseed = (unsigned)time( NULL ) ;
-                	srand(rdseed) ;
+                	kcvsetting->seed = rdseed ;
 #endif
 			sz=0 ;
 			while (sz<kfold[index])
 			{
-				rd = (unsigned int) floor (rand()*(double)defsetting->pairs.labelnum[label]/RAND_MAX) ;
+				rd = (unsigned int) floor (urand(&(kcvsetting->seed))*(double)defsetting->pairs.labelnum[label]) ;
 				if ( 0 == kcvsetting->cvfold[label][rd] )
 				{
 					kcvsetting->cvfold[label][rd] = index ;
@@ -219,11 +219,163 @@ BOOL Clear_Kcv ( kcv_Settings * settings)
 	return TRUE ;
 }
 
-BOOL Init_Kcv ( kcv_Settings * kcvsetting, def_Settings * defsetting )
+typedef struct _Kcv_Task
 {
+	kcv_Settings * kcvsetting ;
+	def_Settings * defsetting ;
+	unsigned int threads ;          /* threads of SMO inside one task*/
+	double * rate ;                 /* validation rate per fold and grid*/
+	double * svs ;                  /* number of SVs per fold and grid*/
+	BOOL failed ;
+} Kcv_Task ;
+
+/*******************************************************************************\
+
+	static BOOL Kcv_Fold_Grid ( Kcv_Task * task, unsigned int fold, unsigned int ki )
+
+	train on one fold at one lnK for all lnC in turn, as the serial loop did,
+	and save the validation results. the task links private copies of the
+	nodes into its own training and validation lists, so that the tasks share
+	the inputs read-only and never touch the lists of the others.
+	input:  the task, the index of the fold and of lnK
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+static BOOL Kcv_Fold_Grid ( Kcv_Task * task, unsigned int fold, unsigned int ki )
+{
+	kcv_Settings * kcvsetting = task->kcvsetting ;
+	def_Settings local = *(task->defsetting) ;
 	smo_Settings * smosetting ;
-	unsigned int index, ki, ci, rd, label ;
+	Data_Node * nodes ;
+	Data_Node * node ;
+	unsigned int label, index, ci, grid ;
+	long unsigned int k ;
+
+	nodes = (Data_Node *) malloc(local.pairs.count*sizeof(Data_Node)) ;
+	local.training.labelnum = (unsigned int *) calloc(local.pairs.classes,sizeof(unsigned int)) ;
+	local.validation.labelnum = (unsigned int *) calloc(local.pairs.classes,sizeof(unsigned int)) ;
+	if ( NULL == nodes || NULL == local.training.labelnum || NULL == local.validation.labelnum )
+	{
+		printf("fail to malloc the lists of the %d-th fold.\r\n", fold+1) ;
+		if (NULL != nodes)
+			free(nodes) ;
+		if (NULL != local.training.labelnum)
+			free(local.training.labelnum) ;
+		if (NULL != local.validation.labelnum)
+			free(local.validation.labelnum) ;
+		return FALSE ;
+	}
+	if ( 0 == ki )
+		printf("Processing the %d-th fold ...\r\n",fold+1) ;
+
+	/* create the training list and validation list */
+	local.index = fold ;
+	local.training.count = 0 ;
+	local.training.front = NULL ;
+	local.training.rear = NULL ;
+	local.validation.count = 0 ;
+	local.validation.front = NULL ;
+	local.validation.rear = NULL ;
+	k = 0 ;
+	for (label = 0 ; label < kcvsetting->ranks; label ++ )
+	{
+		for (index = 0 ; index < (unsigned int)local.pairs.labelnum[label]; index ++)
+		{
+			node = nodes + k ;
+			/* only the fields read by SMO, the outputs are written back below*/
+			node->count = kcvsetting->pointernode[label][index]->count ;
+			node->fold = kcvsetting->pointernode[label][index]->fold ;
+			node->point = kcvsetting->pointernode[label][index]->point ;
+			node->target = kcvsetting->pointernode[label][index]->target ;
+			node->guess = 0 ;
+			node->fx = 0 ;
+			node->next = NULL ;
+			if ( fabs(kcvsetting->cvfold[label][index] - fmod((double)fold,(double)min(local.kfold,local.pairs.labelnum[label]))) < 0.001)
+			{
+				Add_Data_List ( &(local.validation), node ) ;
+				local.validation.labelnum[label] += 1 ;
+			}
+			else
+			{
+				Add_Data_List ( &(local.training), node ) ;
+				local.training.labelnum[label] += 1 ;
+			}
+			k ++ ;
+		}
+	}
+
+	local.threads = task->threads ;
+	local.kappa = pow(10.0, kcvsetting->lnK[ki]) ;
+	local.vc = pow(10.0, kcvsetting->lnC[0]) ;
+	/* create smosettings*/
+	if ( NULL == (smosetting = Create_smo_Settings(&local)) )
+	{
+		free(local.training.labelnum) ;
+		free(local.validation.labelnum) ;
+		free(nodes) ;
+		return FALSE ;
+	}
+	grid = fold*kcvsetting->C_steps*kcvsetting->K_steps + ki*kcvsetting->C_steps ;
+	for ( ci = 0 ; ci < kcvsetting->C_steps ; ci ++)
+	{
+		smosetting->vc = pow(10.0, kcvsetting->lnC[ci]) ;
+		/* start from the solution at the previous C on this fold*/
+		if ( TRUE == local.seeding && ci > 0 )
+			Seed_Alphas( smosetting->alpha, pow(10.0, kcvsetting->lnC[ci-1]), smosetting ) ;
+		/* train on the grid*/
+		smo_routine (smosetting) ;
+		/* calculate the validation output*/
+		svm_predict (&(local.validation), smosetting) ;
+		task->rate[grid+ci] = smosetting->testrate ;
+		task->svs[grid+ci] = smosetting->svs ;
+	}
+	/* the serial loop left the outputs of the last grid on the nodes*/
+	if ( ki + 1 == kcvsetting->K_steps )
+	{
+		k = 0 ;
+		for (label = 0 ; label < kcvsetting->ranks; label ++ )
+		{
+			for (index = 0 ; index < (unsigned int)local.pairs.labelnum[label]; index ++)
+			{
+				node = kcvsetting->pointernode[label][index] ;
+				if ( fabs(kcvsetting->cvfold[label][index] - fmod((double)fold,(double)min(local.kfold,local.pairs.labelnum[label]))) < 0.001)
+				{
+					node->fx = nodes[k].fx ;
+					node->guess = nodes[k].guess ;
+				}
+				k ++ ;
+			}
+		}
+	}
+	/* clear smosettings*/
+	Clear_smo_Settings(smosetting) ;
+	free(local.training.labelnum) ;
+	free(local.validation.labelnum) ;
+	free(nodes) ;
+	return TRUE ;
+}
+
+static void Task_Kcv ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	Kcv_Task * task = (Kcv_Task *) arg ;
+	unsigned long int t ;
+
+	for ( t = begin ; t < end ; t ++ )
+	{
+		if ( FALSE == Kcv_Fold_Grid( task, t / task->kcvsetting->K_steps, t % task->kcvsetting->K_steps ) )
+			task->failed = TRUE ;
+	}
+}
+
+BOOL Init_Kcv ( kcv_Settings * kcvsetting, def_Settings * defsetting )
+{
+	Kcv_Task task ;
+	Thread_Pool * pool ;
+	unsigned int index, ki, ci, rd ;
+	unsigned int grids, tasks ;
 	int grid ;
+	double rate, start ;
 	
 	if ( NULL == kcvsetting || NULL == defsetting )
 		return FALSE ;
@@ -272,70 +424,57 @@ BOOL Init_Kcv ( kcv_Settings * kcvsetting, def_Settings * defsetting )
 		free(kcvsetting->cv_variance) ;
 	kcvsetting->cv_variance = (double *) calloc(kcvsetting->C_steps*kcvsetting->K_steps, sizeof(double)) ;
 
+	defsetting->validation.datatype = defsetting->pairs.datatype ;
+	defsetting->training.datatype = defsetting->pairs.datatype ;
+	defsetting->validation.classes = defsetting->pairs.classes ;
+	defsetting->training.classes = defsetting->pairs.classes ;
+
+	/* every fold at every lnK is one task, the lnC of a task run in turn on one
+	   smo_Settings. the tasks are handed out one by one to the threads, and the
+	   threads left over go to the SMO inside the tasks.*/
+	grids = kcvsetting->C_steps*kcvsetting->K_steps ;
+	tasks = defsetting->kfold*kcvsetting->K_steps ;
+	task.kcvsetting = kcvsetting ;
+	task.defsetting = defsetting ;
+	task.failed = FALSE ;
+	task.rate = (double *) calloc(defsetting->kfold*grids, sizeof(double)) ;
+	task.svs = (double *) calloc(defsetting->kfold*grids, sizeof(double)) ;
+	if ( NULL == task.rate || NULL == task.svs )
+	{
+		printf("fail to malloc kcv.\r\n") ;
+		if (NULL != task.rate)
+			free(task.rate) ;
+		if (NULL != task.svs)
+			free(task.svs) ;
+		return FALSE ;
+	}
+	pool = Create_Thread_Pool( min(defsetting->threads, tasks) ) ;
+	task.threads = max(1, defsetting->threads/Thread_Pool_Size(pool)) ;
+	start = tcpu() ;
+	Run_Thread_Pool( pool, tasks, 1, Task_Kcv, &task ) ;
+	kcvsetting->time += tcpu() - start ;
+	Clear_Thread_Pool( pool ) ;
+
+	/* save the validation results fold by fold, as the serial loop did*/
 	for (defsetting->index = 0 ; defsetting->index < defsetting->kfold ; defsetting->index ++)
 	{
-		printf("Processing the %d-th fold ...\r\n",defsetting->index+1) ;
-
-		defsetting->training.count = 0 ;	
-		defsetting->validation.count = 0 ;		
-		for (label = 0 ; label < kcvsetting->ranks; label ++ )
-		{
-			for (index = 0 ; index < (unsigned int)defsetting->pairs.labelnum[label]; index ++)
-			{
-				kcvsetting->pointernode[label][index]->next = NULL ;
-
-				if ( fabs(kcvsetting->cvfold[label][index] - fmod((double)defsetting->index,(double)min(defsetting->kfold,defsetting->pairs.labelnum[label]))) < 0.001)				
-
-				{
-					Add_Data_List ( &(defsetting->validation), kcvsetting->pointernode[label][index] ) ;
-					defsetting->validation.labelnum[label] += 1 ;
-				}
-				else
-				{
-					Add_Data_List ( &(defsetting->training), kcvsetting->pointernode[label][index] ) ;
-					defsetting->training.labelnum[label] += 1 ;
-				}
-			}
-		}
-		
-		defsetting->validation.datatype = defsetting->pairs.datatype ;
-		defsetting->training.datatype = defsetting->pairs.datatype ;
-		defsetting->validation.classes = defsetting->pairs.classes ;
-		defsetting->training.classes = defsetting->pairs.classes ;
-		grid = 0 ;
-		for ( ki = 0 ; ki < kcvsetting->K_steps ; ki ++) 		
+		for ( grid = 0 ; grid < (int)grids ; grid ++ )
 		{
-			defsetting->kappa = pow(10.0, kcvsetting->lnK[ki]) ;
-			defsetting->vc = pow(10.0, kcvsetting->lnC[0]) ;
-			
-			smosetting = Create_smo_Settings(defsetting) ;
-			for ( ci = 0 ; ci < kcvsetting->C_steps ; ci ++)
-			{									
-				smosetting->vc = pow(10.0, kcvsetting->lnC[ci]) ;
-		
-				smo_routine (smosetting) ;
-				 kcvsetting->time += smosetting->smo_timing ;
-		
-				svm_predict (&defsetting->validation, smosetting) ;
-
-				kcvsetting->cv_lnC[grid] = kcvsetting->lnC[ci] ;
-				kcvsetting->cv_lnK[grid] = kcvsetting->lnK[ki] ;
-				kcvsetting->cv_error[grid] = (kcvsetting->cv_mean[grid] * (double)(defsetting->index) + smosetting->testrate)/((double)(defsetting->index)+1.0) ;
-				kcvsetting->cv_variance[grid] += (smosetting->testrate-kcvsetting->cv_mean[grid])*(smosetting->testrate-kcvsetting->cv_mean[grid])*((double)(defsetting->index))/((double)(defsetting->index+1.0));
-				kcvsetting->cv_mean[grid] = kcvsetting->cv_error[grid] ; 
-				kcvsetting->cv_svs[grid] += smosetting->svs ;
-	
-				grid ++ ;
-			}
-
-			Clear_smo_Settings(smosetting) ; 
+			rate = task.rate[defsetting->index*grids + grid] ;
+			kcvsetting->cv_lnC[grid] = kcvsetting->lnC[grid % kcvsetting->C_steps] ;
+			kcvsetting->cv_lnK[grid] = kcvsetting->lnK[grid / kcvsetting->C_steps] ;
+			kcvsetting->cv_error[grid] = (kcvsetting->cv_mean[grid] * (double)(defsetting->index) + rate)/((double)(defsetting->index)+1.0) ;
+			kcvsetting->cv_variance[grid] += (rate-kcvsetting->cv_mean[grid])*(rate-kcvsetting->cv_mean[grid])*((double)(defsetting->index))/((double)(defsetting->index+1.0));
+			kcvsetting->cv_mean[grid] = kcvsetting->cv_error[grid] ; 
+			kcvsetting->cv_svs[grid] += task.svs[defsetting->index*grids + grid] ;
 		}
-		defsetting->validation.count = 0 ;
-		defsetting->validation.front = NULL ;
-		defsetting->validation.rear = NULL ;			
-		defsetting->training.count = 0 ;
-		defsetting->training.front = NULL ;
-		defsetting->training.rear = NULL ;
+	}
+	free(task.rate) ;
+	free(task.svs) ;
+	if ( TRUE == task.failed )
+	{
+		printf("Error : cross validation failed on some folds.\r\n") ;
+		return FALSE ;
 	}
 
 
@@ -396,14 +535,5 @@ BOOL Init_Kcv ( kcv_Settings * kcvsetting, def_Settings * defsetting )
 	printf("Best Settings at log(C)=%f log(Kappa)=%f \r\nwith validation error rate %f and %.0f SVs.\r\n", (kcvsetting->cv_lnC[rd]), (kcvsetting->cv_lnK[rd]), kcvsetting->final_error[rd], kcvsetting->cv_svs[rd]/(kcvsetting->index+1)/defsetting->kfold) ;
 
 
-	rd = defsetting->pairs.count ;
-	defsetting->pairs.count = 0 ;
-	defsetting->pairs.front = NULL ;
-	defsetting->pairs.rear = NULL ;
-	for (index = 0 ; index < rd ; index ++)
-	{
-		kcvsetting->nodelist[index]->next = NULL ;
-		Add_Data_List ( &(defsetting->pairs), kcvsetting->nodelist[index] ) ;
-	}
 	return TRUE ;
 }
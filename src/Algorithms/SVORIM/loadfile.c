@@ -1,12 +1,22 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <math.h>
 #include <limits.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include "smo.h"
 
-BOOL smo_Loadfile_Matlab ( Data_List * pairs, char * inputfilename, int inputdim, int nFil, int nCol, double ** matrix) 
+BOOL smo_Loadfile_Matlab ( Data_List * pairs, char * inputfilename, int inputdim, int nFil, int nCol, double * matrix, int ld) 
 { 
 
 	int fila=0,columna=0;
@@ -20,6 +30,7 @@ BOOL smo_Loadfile_Matlab ( Data_List * pairs, char * inputfilename, int inputdim
 	unsigned int result, sz ;
 	int var = 0, chg = 0 ;
 	double * point = NULL ;
+	unsigned long int step = 1 ;
 	unsigned int y ;
 	int i = 0, j = 0 ;
 	double mean = 0 ;
@@ -72,6 +83,26 @@ BOOL smo_Loadfile_Matlab ( Data_List * pairs, char * inputfilename, int inputdim
 	for ( j = 0; j < dim; j ++ )
 		xmean[j] = 0 ;
 
+	/*/ the training points are read in place from the column-major matrix of 
+	/ MATLAB, whose columns are ld apart, and are first copied when 
+	/ Create_Data_Matrix packs them. the test points are normalized in place 
+	/ by svm_predict, so they are copied row by row into one block*/
+	if ( 0 == inputdim )
+	{
+		pairs->ld = ld ;
+		step = ld ;
+	}
+	else if ( NULL == (pairs->block = (double *) malloc( nFil * (dim+1) * sizeof(double) )) )
+	{
+		printf("not enough memory.\n") ;
+		free(pairs->x_mean) ;
+		pairs->x_mean = NULL ;
+		free(pairs->x_devi) ;
+		pairs->x_devi = NULL ;
+		free(xmean) ;
+		return FALSE ;
+	}
+
 	/*/ begin to initialize data_list for digital input only*/
 	//printf("\nLOADING.... \n") ;
 	pairs->datatype = CLASSIFICATION ; 
@@ -84,41 +115,17 @@ BOOL smo_Loadfile_Matlab ( Data_List * pairs, char * inputfilename, int inputdim
 		printf("%d\n", index) ;
 		printf("%s\n\n\n", buf) ;
 #endif
-		point = (double *) malloc( (dim+1) * sizeof(double) ) ; /* Pairs to free them*/
-		if ( NULL == point )
-		{
-			printf("not enough memory.\n") ;
-			if (NULL != smo_target)
-				fclose( smo_target ) ;
-			if (NULL != smo_stream)
-				fclose( smo_stream );
-			if (NULL != pairs->x_mean) 
-				free(pairs->x_mean) ;
-			if (NULL != pairs->x_devi) 
-				free(pairs->x_devi) ;
-			if (NULL != xmean)
-				free(xmean) ;
-			Clear_Data_List( pairs ) ;
-			return FALSE ;
-		}
-
-		columna=0;
-
-		while( columna < dim )
+		if ( 0 == inputdim )
+			point = matrix + fila ;
+		else
 		{
-
-			point[columna]= matrix[fila][columna];
-
-			columna++;
-
+			point = pairs->block + fila * (dim+1) ;
+			for ( columna = 0 ; columna < dim ; columna ++ )
+				point[columna] = matrix[fila + columna*ld] ;
+			point[dim] = 0 ;
 		}
-
-		y = matrix[fila][columna];
-
-
-		fila++;
-
-		point[dim]=0 ;
+		y = matrix[fila + dim*ld] ;
+		fila ++ ;
 
 
 
@@ -131,8 +138,8 @@ BOOL smo_Loadfile_Matlab ( Data_List * pairs, char * inputfilename, int inputdim
 				mean = pairs->mean ;	
 				for ( j=0; j<dim; j++ )
 				{
-					pairs->x_mean[j] = (xmean[j] * (((double)(pairs->count)) - 1) + point[j] )/ ((double)(pairs->count))  ;
-					pairs->x_devi[j] = pairs->x_devi[j] + (point[j]-xmean[j])*(point[j]-xmean[j]) * ((double)(pairs->count)-1)/((double)(pairs->count));			
+					pairs->x_mean[j] = (xmean[j] * (((double)(pairs->count)) - 1) + point[j*step] )/ ((double)(pairs->count))  ;
+					pairs->x_devi[j] = pairs->x_devi[j] + (point[j*step]-xmean[j])*(point[j*step]-xmean[j]) * ((double)(pairs->count)-1)/((double)(pairs->count));			
 					xmean[j] = pairs->x_mean[j] ;
 				}
 				if (y>ymax)
@@ -267,7 +274,8 @@ BOOL smo_Loadfile_Matlab ( Data_List * pairs, char * inputfilename, int inputdim
 	node = pairs->front ;
 	while ( node != NULL )
 	{
-		if ( TRUE == pairs->normalized_input )
+		/*/ the points read in place are normalized by Create_Data_Matrix*/
+		if ( TRUE == pairs->normalized_input && 0 == pairs->ld )
 		{
 			for ( j=0; j<dim; j++ )
 			{				
@@ -366,18 +374,247 @@ BOOL smo_Loadfile_Matlab ( Data_List * pairs, char * inputfilename, int inputdim
 
 /*******************************************************************************\
 
-	BOOL smo_Loadfile ( Pairs * pairs, char * filename, unsigned int inputdim ) 
+	the text of a data file is mapped into memory and cut at line ends into 
+	chunks of about LOADCHUNK bytes. the lines of every chunk are counted 
+	first, then every chunk parses its lines into its rows of the block of 
+	Data_List, with the running mean and deviation of the inputs of its own 
+	rows. the statistics of the chunks are merged in their order, so that a 
+	file of one chunk gets exactly those of the row by row update. the chunks 
+	are shared by the thread pool, if any. lines are not limited in length.
+
+\*******************************************************************************/
+
+typedef struct _Load_Chunk
+{
+	const char * begin ;            /* first byte of the chunk, at a line start */
+	const char * end ;              /* one past its last byte */
+	unsigned long int first ;       /* the row of its first line */
+	unsigned long int rows ;        /* the number of its lines */
+	unsigned long int defect ;      /* 1 + the first defective row, or 0 */
+	double * x_mean ;               /* mean of the inputs of its rows */
+	double * x_devi ;               /* sum of squared deviations from the mean */
+} Load_Chunk ;
+
+typedef struct _Load_Task
+{
+	Load_Chunk * chunk ;
+	double * block ;                /* rows of dim+1 doubles */
+	unsigned int * target ;
+	int dim ;
+} Load_Task ;
+
+static const double Pow10[23] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 } ;
+
+#define IS_BLANK(c) (' '==(c)||'\t'==(c)||'\r'==(c)||'\v'==(c)||'\f'==(c))
+#define IS_DIGIT(c) ('0'<=(c)&&'9'>=(c))
+
+/*******************************************************************************\
+
+	const char * Parse_Number ( const char * p, const char * end, double * value )
+
+	read the number at p in the line [p,end) which is not terminated by '\0'. 
+	plain decimals whose digits fit in 2^53 and whose power of ten is exact 
+	are converted by a single multiplication or division, which rounds as 
+	strtod does; anything else is copied out and given to strtod.
+	input:  the position in the line, its end, and the pointer to the value
+	output: the position after the number, or p if there is no number
+
+\*******************************************************************************/
+
+static const char * Parse_Number ( const char * p, const char * end, double * value )
+{
+	const char * s = p ;
+	const char * q ;
+	const char * r ;
+	unsigned long long m = 0 ;
+	int digits = 0, nonzero = 0, e = 0, ex = 0 ;
+	BOOL negative = FALSE, exponent = FALSE ;
+	char token[64] ;
+	char * buf = token ;
+	char * stop ;
+	size_t sz ;
+
+	while ( s < end && IS_BLANK(*s) )
+		s ++ ;
+	q = s ;
+	if ( q < end && ('-' == *q || '+' == *q) )
+	{
+		negative = ('-' == *q) ? TRUE : FALSE ;
+		q ++ ;
+	}
+	while ( q < end && IS_DIGIT(*q) )
+	{
+		if ( nonzero > 0 || '0' != *q )
+		{
+			m = m * 10 + (unsigned long long)(*q - '0') ;
+			nonzero ++ ;
+		}
+		digits ++ ;
+		q ++ ;
+	}
+	if ( q < end && '.' == *q )
+	{
+		q ++ ;
+		while ( q < end && IS_DIGIT(*q) )
+		{
+			if ( nonzero > 0 || '0' != *q )
+			{
+				m = m * 10 + (unsigned long long)(*q - '0') ;
+				nonzero ++ ;
+			}
+			e -- ;
+			digits ++ ;
+			q ++ ;
+		}
+	}
+	if ( digits > 0 && q < end && ('e' == *q || 'E' == *q) )
+	{
+		r = q + 1 ;
+		if ( r < end && ('-' == *r || '+' == *r) )
+			r ++ ;
+		if ( r < end && IS_DIGIT(*r) )
+		{
+			while ( r < end && IS_DIGIT(*r) )
+			{
+				if ( ex < 10000 )
+					ex = ex * 10 + (*r - '0') ;
+				r ++ ;
+			}
+			exponent = ('-' == q[1]) ? TRUE : FALSE ;
+			e = (TRUE == exponent) ? e - ex : e + ex ;
+			q = r ;
+		}
+	}
+	if ( digits > 0 && nonzero <= 19 && m <= (1ULL<<53) && e >= -22 && e <= 22 
+		&& (q == end || IS_BLANK(*q)) )
+	{
+		*value = (e < 0) ? (double)m / Pow10[-e] : (double)m * Pow10[e] ;
+		if ( TRUE == negative )
+			*value = - *value ;
+		return q ;
+	}
+
+	/* hexadecimals, inf, nan, long mantissas and big exponents */
+	q = s ;
+	while ( q < end && !IS_BLANK(*q) )
+		q ++ ;
+	sz = (size_t)(q - s) ;
+	if ( 0 == sz )
+		return p ;
+	if ( sz >= sizeof(token) && NULL == (buf = (char *) malloc(sz+1)) )
+		return p ;
+	memcpy( buf, s, sz ) ;
+	buf[sz] = '\0' ;
+	*value = strtod( buf, &stop ) ;
+	q = (stop == buf) ? p : s + (stop - buf) ;
+	if ( buf != token )
+		free( buf ) ;
+	return q ;
+}
+
+static void Task_Count_Lines ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	Load_Task * task = (Load_Task *) arg ;
+	Load_Chunk * chunk ;
+	const char * p ;
+	unsigned long int c ;
+
+	for ( c = begin ; c < end ; c ++ )
+	{
+		chunk = task->chunk + c ;
+		chunk->rows = 0 ;
+		for ( p = chunk->begin ; p < chunk->end && NULL != (p = (const char *) memchr(p, '\n', chunk->end - p)) ; p ++ )
+			chunk->rows ++ ;
+		/* the last line of the file may have no line end */
+		if ( chunk->end > chunk->begin && '\n' != chunk->end[-1] )
+			chunk->rows ++ ;
+	}
+}
+
+static void Task_Parse_Lines ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	Load_Task * task = (Load_Task *) arg ;
+	Load_Chunk * chunk ;
+	const char * p ;
+	const char * q ;
+	const char * eol ;
+	double * point ;
+	double value, n, old ;
+	unsigned long int c, row ;
+	int i, j, dim = task->dim ;
+
+	for ( c = begin ; c < end ; c ++ )
+	{
+		chunk = task->chunk + c ;
+		chunk->defect = 0 ;
+		for ( j = 0 ; j < dim ; j ++ )
+		{
+			chunk->x_mean[j] = 0 ;
+			chunk->x_devi[j] = 0 ;
+		}
+		row = chunk->first ;
+		for ( p = chunk->begin ; p < chunk->end ; p = eol + 1, row ++ )
+		{
+			if ( NULL == (eol = (const char *) memchr(p, '\n', chunk->end - p)) )
+				eol = chunk->end ;
+			point = task->block + row * (dim+1) ;
+			for ( i = 0 ; i < dim ; i ++ )
+			{
+				if ( p == (q = Parse_Number(p, eol, point + i)) )
+					break ;
+				p = q ;
+			}
+			if ( i < dim )
+			{
+				if ( 0 == chunk->defect )
+					chunk->defect = row + 1 ;
+				for ( ; i < dim ; i ++ )
+					point[i] = 0 ;
+			}
+			point[dim] = 0 ;
+			/* the target is 0 if it is missing, e.g. in test files */
+			if ( p == Parse_Number(p, eol, &value) )
+				task->target[row] = 0 ;
+			else
+				task->target[row] = (unsigned int) value ;
+			/* update the statistics of inputs as the former loader did row by row */
+			n = (double)(row - chunk->first + 1) ;
+			for ( j = 0 ; j < dim ; j ++ )
+			{
+				old = chunk->x_mean[j] ;
+				chunk->x_mean[j] = (old * (n - 1) + point[j]) / n ;
+				chunk->x_devi[j] = chunk->x_devi[j] + (point[j]-old)*(point[j]-old) * (n-1)/n ;
+			}
+		}
+	}
+}
+
+static void Unmap_Loadfile ( char * map, size_t size )
+{
+#ifdef _WIN32
+	free( map ) ;
+#else
+	munmap( map, size ) ;
+#endif
+}
+
+/*******************************************************************************\
+
+	BOOL smo_Loadfile ( Pairs * pairs, char * filename, unsigned int inputdim, unsigned int threads ) 
 	
 	load data file settings->inputfile, and create the data list Pairs 
-	input:  the pointers to pairs and filename
+	with all the points in one block. files of more than one chunk are 
+	parsed by a pool of threads.
+	input:  the pointers to pairs and filename, the dimension of training 
+	        inputs for test data or 0, and the number of threads
 	output: 0 or 1
 
 \*******************************************************************************/
 
-BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim ) 
+BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim, unsigned int threads ) 
 { 
 
-	FILE * smo_stream ;
 	FILE * smo_target = NULL ;
 	char * pstr = NULL ;
 	char buf[LENGTH] ;
@@ -396,6 +633,23 @@ BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim )
 	Data_Node * node = NULL ;
 	int t0=0, tr=0 ;
 	FILE * fid ;
+	char * map = NULL ;
+	size_t size = 0 ;
+	BOOL opened = FALSE ;
+	const char * p ;
+	const char * q ;
+	const char * eol ;
+	double value, n, d ;
+	unsigned long int chunks = 0, c, rows = 0, row ;
+	Load_Chunk * chunk = NULL ;
+	Load_Task task ;
+	Thread_Pool * pool = NULL ;
+#ifdef _WIN32
+	long end ;
+#else
+	struct stat st ;
+	int fd ;
+#endif
 
 	Data_List label ;
 
@@ -405,11 +659,47 @@ BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim )
 	Clear_Data_List( pairs ) ;
 	Create_Data_List( &label ) ;
 
-	if( (smo_stream = fopen( inputfilename, "r+t" )) == NULL )
+	// map the whole file, or read it into memory without mmap
+#ifdef _WIN32
+	if ( NULL != (fid = fopen( inputfilename, "rb" )) )
+	{
+		if ( 0 == fseek( fid, 0, SEEK_END ) && (end = ftell( fid )) > 0 && 0 == fseek( fid, 0, SEEK_SET ) )
+		{
+			size = (size_t) end ;
+			map = (char *) malloc( size ) ;
+			if ( NULL != map && size != fread( map, 1, size, fid ) )
+			{
+				free( map ) ;
+				map = NULL ;
+			}
+		}
+		opened = TRUE ;
+		fclose( fid ) ;
+	}
+#else
+	if ( -1 != (fd = open( inputfilename, O_RDONLY )) )
+	{
+		if ( 0 == fstat( fd, &st ) && st.st_size > 0 )
+		{
+			size = (size_t) st.st_size ;
+			map = (char *) mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 ) ;
+			if ( MAP_FAILED == (void *) map )
+				map = NULL ;
+		}
+		opened = TRUE ;
+		close( fd ) ;
+	}
+#endif
+	if ( FALSE == opened )
 	{
 		//printf( "can not open the file %s.\n", inputfilename );
 		return FALSE ;
 	}
+	if ( NULL == map )
+	{
+		printf( "fgets error in reading the first line.\n" );
+		return FALSE ;
+	}
 	
 	// save file name 
 	var = strlen( inputfilename ) ;
@@ -424,46 +714,22 @@ BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim )
 	strncpy(pairs->filename,inputfilename,var) ;
 	pairs->filename[var]='\0' ;
 
-	// check the input dimension here
+	// check the input dimension here, by the numbers in the first line
 
-	if ( NULL == fgets( buf, LENGTH, smo_stream ))
-	{
-		printf( "fgets error in reading the first line.\n" );
-		fclose( smo_stream );
-		return FALSE ;
-	}
-	
-	var = strlen( buf ) ;
-	
-	if (var >= LENGTH-1) 
+	if ( NULL == (eol = (const char *) memchr(map, '\n', size)) )
+		eol = map + size ;
+	q = map ;
+	do 
 	{
-		printf( "the line is too long in the file %s.\n", inputfilename );
-		fclose( smo_stream );
-		return FALSE ;
-	}
-	
-	if (0 < var)
-	{		
-		do 
-		{
-			dim = dim + 1 ;
-			strtod( buf, &temp ) ;
-			strcpy( buf, temp ) ;
-			chg = var - strlen(buf) ;
-			var = var - chg ;
-		}
-		while ( 0 != chg ) ;
-	}
-	else
-	{ 
-		fclose( smo_stream );
-		printf("the first line in the file is empty.\n") ;
-		return FALSE ;
+		dim = dim + 1 ;
+		p = q ;
+		q = Parse_Number(p, eol, &value) ;
 	}
+	while ( p != q ) ;
 
 	if ( 0 > dim || (0 == dim && 0 == inputdim) ) 
 	{
-		fclose( smo_stream );
+		Unmap_Loadfile( map, size ) ;
 
 #ifdef SMO_DEBUG
 		printf( "input dimension is less than one.\n") ;
@@ -493,6 +759,7 @@ BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim )
 		else if ( inputdim != dim )
 		{
 			printf("Dimensionality in testdata is inconsistent with traindata.\n") ;
+			Unmap_Loadfile( map, size ) ;
 			return FALSE ;
 		}
 		else
@@ -501,11 +768,20 @@ BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim )
 	else
 		pairs->dimen = dim ;
 	
-	//initialize the x_mean and x_devi in Data_List pairs
+	// cut the file into chunks at line ends
+	for ( p = map ; p < map + size ; p = eol )
+	{
+		eol = (size_t)(map + size - p) > LOADCHUNK ? (const char *) memchr(p + LOADCHUNK, '\n', map + size - p - LOADCHUNK) : NULL ;
+		eol = (NULL == eol) ? map + size : eol + 1 ;
+		chunks ++ ;
+	}
+
+	//initialize the x_mean and x_devi in Data_List pairs, and those of the chunks
 
 	if ( NULL == (pairs->x_mean = (double *)(malloc(dim*sizeof(double))) ) 
 		|| NULL == (pairs->x_devi = (double *)(malloc(dim*sizeof(double))) ) 
-		|| NULL == (xmean = (double *)(malloc(dim*sizeof(double))) ) )
+		|| NULL == (xmean = (double *)(malloc(2*chunks*dim*sizeof(double))) ) 
+		|| NULL == (chunk = (Load_Chunk *)(malloc(chunks*sizeof(Load_Chunk))) ) )
 	{		
 		if (NULL != pairs->x_mean) 
 			free(pairs->x_mean) ;
@@ -515,73 +791,92 @@ BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim )
 			free(xmean) ;
 		if (NULL != smo_target)
 			fclose( smo_target ) ;
-		if (NULL != smo_stream)
-			fclose( smo_stream );
+		Unmap_Loadfile( map, size ) ;
 		return FALSE ;
 	}
 	for ( j = 0; j < dim; j ++ )
 		pairs->x_mean[j] = 0 ;
 	for ( j = 0; j < dim; j ++ )
 		pairs->x_devi[j] = 0 ;
-	for ( j = 0; j < dim; j ++ )
-		xmean[j] = 0 ;
+	c = 0 ;
+	for ( p = map ; p < map + size ; p = eol )
+	{
+		eol = (size_t)(map + size - p) > LOADCHUNK ? (const char *) memchr(p + LOADCHUNK, '\n', map + size - p - LOADCHUNK) : NULL ;
+		eol = (NULL == eol) ? map + size : eol + 1 ;
+		chunk[c].begin = p ;
+		chunk[c].end = eol ;
+		chunk[c].x_mean = xmean + 2*c*dim ;
+		chunk[c].x_devi = xmean + (2*c+1)*dim ;
+		c ++ ;
+	}
 
 	// begin to initialize data_list for digital input only
 	printf("\nLoading %s ...  \n", inputfilename) ;
 	pairs->datatype = CLASSIFICATION ; 
 
-	rewind( smo_stream ) ;
-	if (fgets( buf, LENGTH, smo_stream ) == NULL)
-    {
-        printf("\nError reading %s ...  \n", inputfilename) ;
-        exit(1);
-    }
-	do
+	if ( chunks > 1 )
+		pool = Create_Thread_Pool( threads ) ;
+	task.chunk = chunk ;
+	task.dim = dim ;
+	Run_Thread_Pool( pool, chunks, 1, Task_Count_Lines, &task ) ;
+	for ( c = 0 ; c < chunks ; c ++ )
+	{
+		chunk[c].first = rows ;
+		rows += chunk[c].rows ;
+	}
+	task.block = pairs->block = (double *) malloc( rows * (dim+1) * sizeof(double) ) ; // Pairs to free them
+	task.target = (unsigned int *) malloc( rows * sizeof(unsigned int) ) ;
+	if ( NULL == task.block || NULL == task.target )
 	{
+		printf("not enough memory.\n") ;
+		if (NULL != task.target)
+			free(task.target) ;
+		if (NULL != smo_target)
+			fclose( smo_target ) ;
+		free(chunk) ;
+		free(xmean) ;
+		Clear_Thread_Pool( pool ) ;
+		Unmap_Loadfile( map, size ) ;
+		Clear_Data_List( pairs ) ;
+		return FALSE ;
+	}
+	Run_Thread_Pool( pool, chunks, 1, Task_Parse_Lines, &task ) ;
+	Clear_Thread_Pool( pool ) ;
+	Unmap_Loadfile( map, size ) ;
 
-#ifdef SMO_DEBUG 
-		printf("%d\n", index) ;
-		printf("%s\n\n\n", buf) ;
-#endif
-		point = (double *) malloc( (dim+1) * sizeof(double) ) ; // Pairs to free them
-		if ( NULL == point )
+	for ( c = 0 ; c < chunks ; c ++ )
+	{
+		if ( 0 != chunk[c].defect )
 		{
-			printf("not enough memory.\n") ;
-			if (NULL != smo_target)
-				fclose( smo_target ) ;
-			if (NULL != smo_stream)
-				fclose( smo_stream );
-			if (NULL != pairs->x_mean) 
-				free(pairs->x_mean) ;
-			if (NULL != pairs->x_devi) 
-				free(pairs->x_devi) ;
-			if (NULL != xmean)
-				free(xmean) ;
-			Clear_Data_List( pairs ) ;
-			return FALSE ;
+			printf("Warning: the input file %s contains a blank or defective line.\n",inputfilename) ;
+			exit(1) ;
 		}
-		var = strlen( buf ) ;	
-		i = 0 ;
-		chg = dim ;
-
-		while ( chg>0 && i<dim)
+		// merge the statistics of the chunks
+		if ( 0 == c )
 		{
-			point[i] = strtod( buf, &temp ) ;
-			i++ ;
-			strcpy( buf, temp ) ;
-			chg = var - strlen(buf) ;
-			var = var - chg ;
+			for ( j=0; j<dim; j++ )
+			{
+				pairs->x_mean[j] = chunk[c].x_mean[j] ;
+				pairs->x_devi[j] = chunk[c].x_devi[j] ;
+			}
 		}
-		point[dim]=0 ;
-		if (i==dim && chg>0 && var>0)
-			y = (unsigned int)strtod( buf, &temp ) ;
-		else
+		else if ( chunk[c].rows > 0 )
 		{
-			free(point) ;
-			y = 0 ;
-			printf("Warning: the input file %s contains a blank or defective line.\n",inputfilename) ;
- 			exit(1) ;
+			n = (double) (chunk[c].first + chunk[c].rows) ;
+			for ( j=0; j<dim; j++ )
+			{
+				d = chunk[c].x_mean[j] - pairs->x_mean[j] ;
+				pairs->x_mean[j] = pairs->x_mean[j] + d * (double) chunk[c].rows / n ;
+				pairs->x_devi[j] = pairs->x_devi[j] + chunk[c].x_devi[j] + d * d * (double) chunk[c].first * (double) chunk[c].rows / n ;
+			}
 		}
+	}
+	free(chunk) ;
+
+	for ( row = 0 ; row < rows ; row ++ )
+	{
+		point = task.block + row * (dim+1) ;
+		y = task.target[row] ;
 		// load y as target from other file when dim+1
 		if (NULL != smo_target)
 		{
@@ -598,54 +893,30 @@ BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim )
 				printf("Warning: the target file is shorter than the input file.\n") ;
 		}
 
-		/*	for ( i = 0; i < dim; i ++ )
-			{
-				point[i] = strtod( buf, &temp ) ;
-				strcpy( buf, temp ) ;
-			}
-			y = strtod( buf, &temp ) ;
-
-			// load y as target from other file when dim+1
-			if (NULL != smo_target)
-			{
-				fgets( buf, LENGTH, smo_target ) ;
-				y = strtod( buf, &temp ) ;
-			}*/
-
-		if (chg>0) 
-		{	
-						
-			if ( TRUE == Add_Data_List( pairs, Create_Data_Node(index, point, y) ) )
-			{
-				// update statistics
-				pairs->mean = (mean * (((double)(pairs->count)) - 1) + y )/ ((double)(pairs->count))  ;
-				pairs->deviation = pairs->deviation + (y-mean)*(y-mean) * ((double)(pairs->count)-1)/((double)(pairs->count));			
-				mean = pairs->mean ;	
-				for ( j=0; j<dim; j++ )
-				{
-					pairs->x_mean[j] = (xmean[j] * (((double)(pairs->count)) - 1) + point[j] )/ ((double)(pairs->count))  ;
-					pairs->x_devi[j] = pairs->x_devi[j] + (point[j]-xmean[j])*(point[j]-xmean[j]) * ((double)(pairs->count)-1)/((double)(pairs->count));			
-					xmean[j] = pairs->x_mean[j] ;
-				}
-				if (y>ymax)
-				{ ymax = y ; pairs->i_ymax = index ;}
-				if (y<ymin)
-				{ ymin = y ; pairs->i_ymin = index ;}
-				
-				// check data type 
-				Add_Label_Data_List( &label, Create_Data_Node(index, point, y) ) ;
-				index ++ ;
-			}
-			else
-			{
+		if ( TRUE == Add_Data_List( pairs, Create_Data_Node(index, point, y) ) )
+		{
+			// update statistics
+			pairs->mean = (mean * (((double)(pairs->count)) - 1) + y )/ ((double)(pairs->count))  ;
+			pairs->deviation = pairs->deviation + (y-mean)*(y-mean) * ((double)(pairs->count)-1)/((double)(pairs->count));			
+			mean = pairs->mean ;	
+			if (y>ymax)
+			{ ymax = y ; pairs->i_ymax = index ;}
+			if (y<ymin)
+			{ ymin = y ; pairs->i_ymin = index ;}
+			
+			// check data type 
+			Add_Label_Data_List( &label, Create_Data_Node(index, point, y) ) ;
+			index ++ ;
+		}
+		else
+		{
 #ifdef SMO_DEBUG 
-				printf("%d\n", index) ;
-				printf("duplicate data \n") ;
+			printf("%d\n", index) ;
+			printf("duplicate data \n") ;
 #endif
-			}
 		}
 	}
-	while( !feof( smo_stream ) && NULL != fgets( buf, LENGTH, smo_stream ) ) ;
+	free(task.target) ;
 
 	if (label.count>=2||inputdim>0)
 		pairs->datatype = ORDINAL ;
@@ -667,8 +938,6 @@ BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim )
 			free(xmean) ;
 		if (NULL != smo_target)
 			fclose( smo_target ) ;
-		if (NULL != smo_stream)
-			fclose( smo_stream );
 		return FALSE ;
 	}
 	// load index file for feature types strstr
@@ -846,8 +1115,6 @@ BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim )
 	Clear_Label_Data_List (&label) ;
 	if (NULL != smo_target)
 		fclose( smo_target ) ;
-	if (NULL != smo_stream)
-		fclose( smo_stream );
 	if ( NULL != xmean )
 		free( xmean ) ;
 	return TRUE ;
@@ -22,6 +22,12 @@
 #include "smo.h"
 #define VERSION (0)
 
+/* progress callback of SMO for a time budget, arg points to the deadline in wall time */
+static BOOL Budget_Progress ( smo_Settings * settings, void * arg )
+{
+	return ( twall() < *(double *) arg ) ? TRUE : FALSE ;
+}
+
 int main( int argc, char * argv[])
 {
 	def_Settings * defsetting = NULL ;
@@ -32,6 +38,15 @@ int main( int argc, char * argv[])
 	unsigned int sz = 0;
 	unsigned int index = 0 ;
 	double parameter = 0 ;
+	BOOL search = FALSE ;
+	BOOL savemodel = FALSE ;
+	BOOL usemodel = FALSE ;
+	BOOL savestats = FALSE ;
+	double budget = 0, deadline = 0 ;
+	Svor_Model model ;
+	Thread_Pool * pool ;
+	Smo_Timer timer ;
+	double testerror = 0, testrate = 0 ;
 	//double * guess ;
 	FILE * log ; 
 	printf("\nSupport Vector Ordinal Regression Using K-fold Cross Validation v2.%d \n--- Chu Wei Copyright(C) 2003-2004\n\n", VERSION) ;
@@ -52,13 +67,27 @@ int main( int argc, char * argv[])
 		printf("  -P  p  use Polynomial kernel with order p (default Gaussian kernel).\n") ;
 		//printf("  -B     force regularizers Balanced for classification only.\n") ;
 		//printf("  -E  e  set Epsilon at e for regression only (default 0.1).\n") ;
-		printf("  -Z  z  set the times of Zooming at z (default 2).\n") ;			
+		printf("  -Z  z  search C and K by cross validation, zooming in z times (default no search).\n") ;			
 		printf("  -i     normalize the training inputs.\n") ;		
+		printf("  -g     keep Fi of all samples updated after every step.\n") ;
+		printf("         rounding can change the SMO path, so the steps and the solution\n") ;
+		printf("         may differ from the default within the tolerance.\n") ;
+		printf("  -W     Warm start each C from the solution at the previous C in cross validation.\n") ;
+		printf("  -H     sHrink the samples at bound out of the SMO sweeps.\n") ;
+		printf("  -Q     choose the working pairs by the second-order gain (default first-order).\n") ;
+		printf("  -m     save the trained Model with its support vectors in file.model.\n") ;
+		printf("  -J     save the counters and timings of the solver as JSON in file.svm.stats.\n") ;
+		printf("  -D  d  stop SMO after a budget of d seconds (default no budget).\n") ;
+		printf("  -u     Use the model in file.model to predict the test data, no training.\n") ;
 		//printf("  -o     normalize the training targets.\n") ;		
 		printf("  -a     activates loading weighted kernels.\n") ;
 		printf("  -S  s  set the Seed of random number generator at s (default random).\n") ;
 		printf("  -R  r  set the Rehearsal times of fold generation at r (default 1).\n") ;
 		printf("  -T  t  set Tolerance at t (default 0.001).\n") ;
+		printf("  -M  m  keep at most m kernel rows in cache (default %d).\n", DEF_CACHE) ;
+		printf("  -N  n  use n threads for the kernel and Fi (default %d).\n", DEF_THREADS) ;
+		printf("  -Y  n  approximate the kernel by Nystrom with n landmarks (default exact).\n") ;
+		printf("  -X  n  approximate the Gaussian kernel by n random Fourier features.\n") ;
 		printf("new option:\n") ;
 		printf("  -Z  0  set the zooming at 0 to skip cross-validation.\n") ;			
 		printf("  -Ko o  fix K at o manually (default 1).\n") ;			
@@ -101,6 +130,41 @@ int main( int argc, char * argv[])
 						defsetting->normalized_input = TRUE ;	
 						defsetting->pairs.normalized_input = TRUE ;
 						break ;
+					case 'g' :
+						printf("  - keep Fi of all samples updated.\n") ;
+						defsetting->fcacheall = TRUE ;	
+						break ;
+					case 'W' :
+						printf("  - seed alphas from the previous C in cross validation.\n") ;
+						defsetting->seeding = TRUE ;
+						break ;
+					case 'H' :
+						printf("  - shrink the samples at bound in SMO.\n") ;
+						defsetting->shrinking = TRUE ;
+						break ;
+					case 'Q' :
+						printf("  - second-order selection of the working pairs.\n") ;
+						defsetting->secondorder = TRUE ;
+						break ;
+					case 'm' :
+						printf("  - save the Model in a binary file.\n") ;
+						savemodel = TRUE ;
+						break ;
+					case 'J' :
+						printf("  - save the statistics of the solver.\n") ;
+						savestats = TRUE ;
+						break ;
+					case 'D' :
+						if (parameter>0)
+						{
+							printf("  - time budget of %.3f seconds for SMO.\n", parameter) ;
+							budget = parameter ;
+						}
+						break ;
+					case 'u' :
+						printf("  - Use the saved model to predict.\n") ;
+						usemodel = TRUE ;
+						break ;
 					case 'S' :
 						if (parameter>0)
 						{
@@ -120,6 +184,7 @@ int main( int argc, char * argv[])
 						{
 							printf("  - Zoom in scale %.0f.\n", parameter) ;
 							defsetting->loops = (unsigned int)parameter ;
+							search = ( parameter > 0 ) ? TRUE : FALSE ;
 						}
 						break ;
 					case 'R' :
@@ -137,6 +202,36 @@ int main( int argc, char * argv[])
 						printf("  - set regularization factors balanced.\n") ;
 						defsetting->smo_balance = TRUE ;
 						break ;
+					case 'N' :
+						if (parameter>=1)
+						{
+							printf("  - %.0f threads.\n", parameter) ;
+							defsetting->threads = (unsigned int)parameter ;
+						}
+						break ;
+					case 'Y' :
+						if (parameter>=1)
+						{
+							printf("  - Nystrom kernel of %.0f landmarks.\n", parameter) ;
+							defsetting->approx = NYSTROM ;
+							defsetting->rank = (unsigned int)parameter ;
+						}
+						break ;
+					case 'X' :
+						if (parameter>=1)
+						{
+							printf("  - %.0f random Fourier features.\n", parameter) ;
+							defsetting->approx = FOURIER ;
+							defsetting->rank = (unsigned int)parameter ;
+						}
+						break ;
+					case 'M' :
+						if (parameter>=2)
+						{
+							printf("  - kernel cache of %.0f rows.\n", parameter) ;
+							defsetting->cache_size = (unsigned long int)parameter ;
+						}
+						break ;
 					case 'T' :
 						if (parameter>0)
 						{
@@ -255,7 +350,34 @@ int main( int argc, char * argv[])
 
 	while ( TRUE == Update_def_Settings(defsetting) ) 
 	{
-/*		sz = defsetting->loops ;
+		if (TRUE == usemodel)
+		{
+			// predict with the saved model, without training
+			sprintf(buf, "%s.model", defsetting->inputfile) ;
+			printf ("\n\n TESTING on %s with the model %s...\n", defsetting->testfile, buf ) ;
+			tstart(&timer) ;
+			if ( FALSE == Load_Svor_Model(&model, buf) )
+				continue ;
+			if ( FALSE == smo_Loadfile(&(defsetting->testdata), defsetting->testfile, model.matrix.dimen, defsetting->threads) )
+				printf ("No testing data found in the file %s.\n", defsetting->testfile ) ;
+			else
+			{
+				pool = Create_Thread_Pool(defsetting->threads) ;
+				if ( TRUE == svm_predict_model(&defsetting->testdata, &model, pool, &testerror, &testrate) )
+				{
+					tend(&timer) ;
+					svm_saveguess(&defsetting->testdata, defsetting->inputfile) ;
+					printf ("\r\nTEST ERROR NUMBER %.0f, AAE %.0f and SVs %lu, with %.3f seconds.\n", 
+					testerror*defsetting->testdata.count, testrate*defsetting->testdata.count, model.matrix.count, tval(&timer)) ;
+				}
+				else
+					printf ("Failed to predict the test data in %s.\n", defsetting->testfile ) ;
+				Clear_Thread_Pool(pool) ;
+			}
+			Clear_Svor_Model(&model) ;
+			continue ;
+		}
+		sz = ( TRUE == search ) ? defsetting->loops : 0 ;
 		while (sz > 0)
 		{
 			// coarse search
@@ -289,7 +411,6 @@ int main( int argc, char * argv[])
 			Clear_Kcv ( kcvsetting ) ;
 			sz -= 1 ;
 		}
-*/
 		// save validation output
 		defsetting->lnC_start = log10(defsetting->vc) ;		 
 		defsetting->lnC_end = log10(defsetting->vc) ;		
@@ -339,6 +460,9 @@ int main( int argc, char * argv[])
 		defsetting->training.rear = defsetting->pairs.rear ;	
 		defsetting->training.classes = defsetting->pairs.classes ;	
 		defsetting->training.dimen = defsetting->pairs.dimen ;
+		// the copy made by Init_Kcv
+		if (NULL != defsetting->training.featuretype)
+			free(defsetting->training.featuretype) ;
 		defsetting->training.featuretype = defsetting->pairs.featuretype ;
 		// create smosettings
 		printf ("\n\n TESTING on %s...\n", defsetting->testfile ) ;	
@@ -349,7 +473,7 @@ int main( int argc, char * argv[])
 		defsetting->training.rear = NULL ;
 		defsetting->training.featuretype = NULL ;
 		// load test data
-		if ( FALSE == smo_Loadfile(&(defsetting->testdata), defsetting->testfile, defsetting->pairs.dimen) )
+		if ( FALSE == smo_Loadfile(&(defsetting->testdata), defsetting->testfile, defsetting->pairs.dimen, defsetting->threads) )
 		{
 			printf ("No testing data found in the file %s.\n", defsetting->testfile ) ;
 			svm_saveresults (&defsetting->pairs, smosetting) ;		
@@ -357,13 +481,40 @@ int main( int argc, char * argv[])
 		// calculate the test output
 		else
 		{
-			smo_routine (smosetting) ;
+			if (budget > 0)
+			{
+				deadline = twall() + budget ;
+				smosetting->progress = Budget_Progress ;
+				smosetting->progress_arg = &deadline ;
+			}
+			if (FALSE == smo_routine (smosetting) && TRUE == smosetting->abort)
+				printf ("SMO was stopped by the time budget of %.3f seconds.\r\n", budget) ;
 			svm_predict (&defsetting->testdata, smosetting) ;
 			svm_saveresults (&defsetting->testdata, smosetting) ;
+			if (TRUE == savemodel)
+			{
+				sprintf(buf, "%s.model", defsetting->inputfile) ;
+				if (TRUE == Settings_Svor_Model(&model, smosetting))
+				{
+					if (TRUE == Save_Svor_Model(&model, buf))
+						printf("MODEL with %lu support vectors has been saved in %s.\n", model.matrix.count, buf) ;
+					Clear_Svor_Model(&model) ;
+				}
+			}
 
 			if (ORDINAL == smosetting->pairs->datatype)
 				printf ("\r\nTEST ERROR NUMBER %.0f, AAE %.0f and SVs %.0f, at C=%.3f Kappa=%.3f with %.3f seconds.\r\n", 
 				smosetting->testerror*defsetting->testdata.count,smosetting->testrate*defsetting->testdata.count, smosetting->svs, smosetting->vc, smosetting->kappa, smosetting->smo_timing) ;
+			if (TRUE == smosetting->shrinking)
+				printf ("At most %lu of %lu samples were shrunk in SMO.\r\n", smosetting->shrunk, smosetting->pairs->count) ;
+			printf ("SMO took %lu steps with %s working pairs.\r\n", smosetting->stats.accepted, 
+				TRUE == smosetting->secondorder ? "second-order" : "first-order") ;
+			if (TRUE == savestats)
+			{
+				sprintf(buf, "%s.svm.stats", defsetting->inputfile) ;
+				if (TRUE == Save_Smo_Stats(smosetting, buf))
+					printf("SOLVER STATISTICS have been saved in %s.\r\n", buf) ;
+			}
 
 			if (NULL != (log = fopen ("kfoldsvc.log", "a+t")) ) 
 			{
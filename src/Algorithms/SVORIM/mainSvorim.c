@@ -14,6 +14,34 @@
 #define VERSION (0)
 #define DEBUG 0
 
+/* the counters and the wall times of the solver as a struct for the sixth output */
+static mxArray *Stats_Struct(smo_Settings *settings) {
+  const char *fields[] = {"precomputed", "kernels", "hits", "misses", "accepted", "rejected",
+    "sweeps", "io_peak", "io", "precompute", "optimise", "predict", "memory"};
+  Smo_Stats *stats = &(settings->stats);
+  mxArray *out = mxCreateStructMatrix(1, 1, 13, fields);
+  mxArray *io = mxCreateDoubleMatrix(1, stats->io_count, mxREAL);
+  double *data = mxGetPr(io);
+  unsigned long int i;
+
+  for (i = 0; i < stats->io_count; i++)
+    data[i] = (double)stats->io[i];
+  mxSetField(out, 0, "precomputed", mxCreateDoubleScalar((double)stats->precomputed));
+  mxSetField(out, 0, "kernels", mxCreateDoubleScalar((double)stats->kernels));
+  mxSetField(out, 0, "hits", mxCreateDoubleScalar((double)stats->hits));
+  mxSetField(out, 0, "misses", mxCreateDoubleScalar((double)stats->misses));
+  mxSetField(out, 0, "accepted", mxCreateDoubleScalar((double)stats->accepted));
+  mxSetField(out, 0, "rejected", mxCreateDoubleScalar((double)stats->rejected));
+  mxSetField(out, 0, "sweeps", mxCreateDoubleScalar((double)stats->sweeps));
+  mxSetField(out, 0, "io_peak", mxCreateDoubleScalar((double)stats->io_peak));
+  mxSetField(out, 0, "io", io);
+  mxSetField(out, 0, "precompute", mxCreateDoubleScalar(stats->precompute));
+  mxSetField(out, 0, "optimise", mxCreateDoubleScalar(stats->optimise));
+  mxSetField(out, 0, "predict", mxCreateDoubleScalar(stats->predict));
+  mxSetField(out, 0, "memory", mxCreateDoubleScalar(stats->memory));
+  return out;
+}
+
 /* mexFunction es la rutina de enlace con el código C. */
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   clock_t start;
@@ -28,10 +56,12 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
      Polinómico(1: SI, 0:NO)");
        }*/
 
-  if (nrhs != 6) {
-    mexErrMsgTxt("Error. 6 parameters required => Train , Ko , Co, Normalize "
-                 "(1: YES, 0:NO), MexPrintf Outputs (1:YES, 0: NO), Linear "
-                 "kernel (1: YES, 0:NO)");
+  if (nrhs < 6 || nrhs > 9) {
+    mexErrMsgTxt("Error. 6 to 9 parameters required => Train , Ko , Co, "
+                 "Normalize (1: YES, 0:NO), MexPrintf Outputs (1:YES, 0: NO), "
+                 "Linear kernel (1: YES, 0:NO), [Threads (default 1)], "
+                 "[Initial alphas, samples x thresholds (default zeros)], "
+                 "[Training projection (1: YES, 0:NO, default 0)]");
   }
 
   def_Settings *defsetting = NULL;
@@ -45,19 +75,20 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   FILE * log ;
   double * guess ;*/
 
-  double **matBien = NULL;
-  double **matTrain = NULL;
-  double **matTest = NULL;
+  double *matTrain = NULL;
   double *data1 = NULL;
   double *data6 = NULL;
 
   // struct estructura * ptr = NULL;
   struct estructura e1;
 
-  int aux, aux2;
-  int m = -1, n = -1, contador, i, j;
+  int m = -1, n = -1, i, j;
   int nFil = 0, nFil2 = 0, nCol = 0, nCol2 = 0;
   double Ko = 0, Co = 0, Normalizar = 0, salidasMexPrintf = 0, kPolinomico = 0;
+  double nThreads = 0, projection = 0;
+  mxArray *stats = NULL;
+  double *alpha0 = NULL;
+  size_t mAlpha0 = 0, nAlpha0 = 0;
 
   /*TEST REMOVED
   if( i< 2)*/
@@ -67,44 +98,12 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   m = mxGetM(prhs[i]); /*numero filas*/
   n = mxGetN(prhs[i]); /*numero columnas*/
 
-  /*Reservo la matriz dinamica MatBien*/
-  matBien = (double **)calloc(m, sizeof(double *));
-
-  for (aux = 0; aux < m; aux++) {
-    matBien[aux] = (double *)calloc(n, sizeof(double));
-  }
-
-  /* Retrieve the input data */
-  data1 = mxGetPr(prhs[i]); /*Pointer to the first element of the real data*/
-
-  /*Recolocacion de la matriz*/
-  contador = 0;
-  for (aux = 0; aux < n; aux++) {
-    for (aux2 = 0; aux2 < m; aux2++) {
-      matBien[aux2][aux] = data1[contador];
-      contador++;
-    }
-  }
+  /* the training matrix is read in place, column-major, by smo_Loadfile_Matlab */
+  matTrain = mxGetPr(prhs[i]);
 
   nFil = m;
   nCol = n;
 
-  /*Reservo la matriz dinamica MatTrain*/
-  matTrain = (double **)calloc(m, sizeof(double *));
-
-  for (aux = 0; aux < m; aux++) {
-    matTrain[aux] = (double *)calloc(n, sizeof(double));
-  }
-
-  /*ASIGNACION TRAIN Y COMPROBACION*/
-
-  for (aux = 0; aux < m; aux++) {
-    for (aux2 = 0; aux2 < n; aux2++) {
-      matTrain[aux][aux2] = matBien[aux][aux2];
-      /*mexPrintf ("matTrain[%d][%d]=%lf\n",aux,aux2,matTrain[aux][aux2]);*/
-    }
-  }
-
   /* TEST REMOVED if(i==2)*parametro dos: K*/
   i = 1;
   data1 = mxGetPr(prhs[i]);
@@ -130,16 +129,33 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   data1 = mxGetPr(prhs[i]);
   kPolinomico = data1[0];
 
-  /* TEST REMOVED Hack*/
+  /* optional: number of threads */
+  if (nrhs > 6) {
+    i = 6;
+    data1 = mxGetPr(prhs[i]);
+    nThreads = data1[0];
+  }
+
+  /* optional: initial alphas per sample and threshold, e.g. the fifth output
+   * of a previous call scaled by C/C_previous */
+  if (nrhs > 7 && !mxIsEmpty(prhs[7])) {
+    alpha0 = mxGetPr(prhs[7]);
+    mAlpha0 = mxGetM(prhs[7]);
+    nAlpha0 = mxGetN(prhs[7]);
+  }
+
+  /* optional: return the projection of the training samples as the third
+   * output, empty otherwise */
+  if (nrhs > 8) {
+    i = 8;
+    data1 = mxGetPr(prhs[i]);
+    projection = data1[0];
+  }
+
+  /* TEST REMOVED Hack: the first two rows of the training matrix */
   /* TODO: Is this for debuging? */
   nFil2 = 2;
   nCol2 = nCol;
-  matTest = (double **)calloc(nFil2, sizeof(double *));
-  for (aux = 0; aux < nFil2; aux++)
-    matTest[aux] = (double *)calloc(nCol2, sizeof(double));
-  for (aux = 0; aux < nFil2; aux++)
-    for (aux2 = 0; aux2 < nCol2; aux2++)
-      matTest[aux][aux2] = matTrain[aux][aux2];
   /* End Hack*/
 
   /* compruebo que las dos matrices tenga el mismo numero de filas y columnas,
@@ -190,6 +206,12 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   if (salidasMexPrintf == 1) // Hemos activados los mexPrintf
     mexPrintf("  - C at %f.\n", Co);
 
+  if (nThreads >= 1) {
+    defsetting->threads = (unsigned int)nThreads;
+    if (salidasMexPrintf == 1)
+      mexPrintf("  - %u threads.\n", defsetting->threads);
+  }
+
   if (Normalizar == 1) // Hemos activado la normalización
   {
     defsetting->normalized_input = TRUE;
@@ -213,22 +235,40 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   defsetting->training.classes = defsetting->pairs.classes;
   defsetting->training.dimen = defsetting->pairs.dimen;
   defsetting->training.featuretype = defsetting->pairs.featuretype;
+  /* the matrix is packed and normalized once from the points read in place */
+  defsetting->training.ld = defsetting->pairs.ld;
+  defsetting->training.normalized_input = defsetting->pairs.normalized_input;
+  defsetting->training.x_mean = defsetting->pairs.x_mean;
+  defsetting->training.x_devi = defsetting->pairs.x_devi;
 
   /* create smosettings*/
   // mexPrintf ("\n\nTESTING....\n", defsetting->testfile ) ;
 
   smosetting = Create_smo_Settings(defsetting);
   smosetting->pairs = &defsetting->pairs;
+  /* start SMO from the initial alphas if they are given */
+  if (NULL != alpha0) {
+    if (mAlpha0 == smosetting->pairs->count &&
+        nAlpha0 == smosetting->pairs->classes - 1)
+      Assign_Alphas(smosetting->alpha, alpha0, smosetting);
+    else
+      mexWarnMsgTxt("The size of initial alphas does not match the training "
+                    "data, SMO starts from zero.");
+  }
   defsetting->training.count = 0;
   defsetting->training.front = NULL;
   defsetting->training.rear = NULL;
   defsetting->training.featuretype = NULL;
+  defsetting->training.ld = 0;
+  defsetting->training.x_mean = NULL;
+  defsetting->training.x_devi = NULL;
 
   /* load test data*/
   #if 0
   if (FALSE ==
       smo_Loadfile_Matlab(&(defsetting->testdata), defsetting->testfile,
-                          defsetting->pairs.dimen, nFil2, nCol2, matTest)) {
+                          defsetting->pairs.dimen, nFil2, nCol2, matTrain,
+                          nFil)) {
     mexPrintf("No testing data found in the file %s.\n", defsetting->testfile);
     /*svm_saveresults (&defsetting->pairs, smosetting) ;*/
   }
@@ -245,7 +285,10 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
     // Test
     start = clock();
     svm_predict(&defsetting->testdata, smosetting);
-    e1 = svm_saveresults_Matlab(&defsetting->testdata, smosetting);
+    e1 = svm_saveresults_Matlab(&defsetting->testdata, smosetting,
+                                (projection == 1) ? TRUE : FALSE);
+    if (nlhs > 5)
+      stats = Stats_Struct(smosetting);
     /*testTime= (clock()-start)/((double)CLOCKS_PER_SEC);*/
     // e1=svm_saveresults_Matlab (&defsetting->testdata, smosetting) ;
 
@@ -261,18 +304,6 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   }
   Clear_smo_Settings(smosetting);
 
-  /* free aux matrices */
-  for (aux = 0; aux < m; aux++) {
-    free(matBien[aux]);
-    free(matTrain[aux]);
-  }
-  free(matBien);
-  free(matTrain);
-
-  for (aux = 0; aux < nFil2; aux++)
-    free(matTest[aux]);
-  free(matTest);
-
   /* free memory then exit*/
   Clear_def_Settings(defsetting);
 
@@ -315,5 +346,25 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
 	if (i== 3) {
 		plhs[i] = mxCreateDoubleScalar(trainTime);
 	}
+
+	if (i == 4) {
+		/* the alphas per sample and threshold, to seed a later call */
+		plhs[i] = mxCreateDoubleMatrix(e1.n_alpha, e1.n_threshold, mxREAL);
+		data6 = mxGetPr(plhs[i]);
+
+		for (j = 0; j < e1.n_alpha * e1.n_threshold; j++) {
+			data6[j] = e1.alphas[j];
+		}
+	}
+
+	if (i == 5) {
+		/* counters and wall times of the solver */
+		plhs[i] = (NULL != stats) ? stats : mxCreateDoubleMatrix(0, 0, mxREAL);
+	}
   }
+  free(e1.data2);
+  free(e1.alpha);
+  free(e1.biasj);
+  free(e1.guess);
+  free(e1.alphas);
 }
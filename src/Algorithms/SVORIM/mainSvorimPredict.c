@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "smo.h"
+
+#include "mex.h"
+
+/* score the m x d matrix Test with the model into the m x 1 outputs, and 
+   release the model*/
+static void Predict_Outputs ( Svor_Model * model, int nlhs, mxArray *plhs[], const mxArray * test, double nThreads )
+{
+	Thread_Pool * pool = NULL ;
+	double * fx = NULL ;
+	double * guess = NULL ;
+	size_t m = mxGetM(test) ;
+
+	plhs[0] = mxCreateDoubleMatrix(m, 1, mxREAL) ;
+	if(nlhs > 1)
+		plhs[1] = mxCreateDoubleMatrix(m, 1, mxREAL) ;
+	if(0 == m)
+	{
+		Clear_Svor_Model( model ) ;
+		return ;
+	}
+	fx = mxGetPr(plhs[0]) ;
+	guess = (nlhs > 1) ? mxGetPr(plhs[1]) : (double *) mxMalloc(m*sizeof(double)) ;
+	if(nThreads > 1)
+		pool = Create_Thread_Pool( (unsigned int) nThreads ) ;
+
+	if ( FALSE == Predict_Svor_Model( model, mxGetPr(test), m, fx, guess, pool ) )
+	{
+		Clear_Thread_Pool( pool ) ;
+		Clear_Svor_Model( model ) ;
+		mexErrMsgTxt("The prediction failed");
+	}
+	Clear_Thread_Pool( pool ) ;
+	Clear_Svor_Model( model ) ;
+	if(nlhs <= 1)
+		mxFree(guess) ;
+}
+
+/* prediction with a trained model: only the support vectors are kept in a 
+   packed Svor_Model and the test patterns are scored in blocks, in parallel 
+   if threads are requested, instead of a full train x test kernel matrix.
+   [projected, predicted] = svorimpredict(Train, Alpha, Thresholds, Test, Ko, [Linear kernel], [Threads])
+   the model may also be a file saved by svorim -m, which is mapped without copying it:
+   [projected, predicted] = svorimpredict(ModelFile, Test, [Threads]) */
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+	Svor_Model model ;
+	Kernel_Name kernel = GAUSSIAN ;
+	unsigned int p = DEF_P ;
+	double Ko = 0, kPolinomico = 0, nThreads = 0 ;
+	char * filename ;
+	size_t n, d, m ;
+
+	if(nrhs >= 1 && mxIsChar(prhs[0]))
+	{
+		if(nrhs < 2 || nrhs > 3)
+		{
+			mexErrMsgTxt("Error. 2 or 3 parameters required => ModelFile , Test , [Threads (default 1)]");
+		}
+		if(!mxIsDouble(prhs[1]))
+		{
+			mexErrMsgTxt("Test must be a double matrix");
+		}
+		if(nrhs > 2)
+			nThreads = mxGetScalar(prhs[2]) ;
+		filename = mxArrayToString(prhs[0]) ;
+		if(NULL == filename || FALSE == Load_Svor_Model( &model, filename ))
+		{
+			if(NULL != filename)
+				mxFree(filename) ;
+			mexErrMsgTxt("The model file can not be loaded");
+		}
+		mxFree(filename) ;
+		if(mxGetM(prhs[1]) > 0 && mxGetN(prhs[1]) != model.matrix.dimen)
+		{
+			Clear_Svor_Model( &model ) ;
+			mexErrMsgTxt("Number of columns of the model and test must be the same");
+		}
+		Predict_Outputs( &model, nlhs, plhs, prhs[1], nThreads ) ;
+		return ;
+	}
+
+	if(nrhs < 5 || nrhs > 7)
+	{
+		mexErrMsgTxt("Error. 5 to 7 parameters required => Train , Alpha , Thresholds , Test , Ko , [Linear kernel (1: YES, 0:NO)], [Threads (default 1)]");
+	}
+	if(!mxIsDouble(prhs[0]) || !mxIsDouble(prhs[1]) || !mxIsDouble(prhs[2]) || !mxIsDouble(prhs[3]))
+	{
+		mexErrMsgTxt("Train, Alpha, Thresholds and Test must be double matrices");
+	}
+	n = mxGetM(prhs[0]) ;
+	d = mxGetN(prhs[0]) ;
+	m = mxGetM(prhs[3]) ;
+	if(mxGetNumberOfElements(prhs[1]) != n)
+	{
+		mexErrMsgTxt("The number of alphas must match the rows of Train");
+	}
+	if(mxGetNumberOfElements(prhs[2]) < 1)
+	{
+		mexErrMsgTxt("At least one threshold is required");
+	}
+	if(m > 0 && mxGetN(prhs[3]) != d)
+	{
+		mexErrMsgTxt("Number of columns of training and test must be the same");
+	}
+	Ko = mxGetScalar(prhs[4]) ;
+	if(nrhs > 5)
+		kPolinomico = mxGetScalar(prhs[5]) ;
+	if(nrhs > 6)
+		nThreads = mxGetScalar(prhs[6]) ;
+
+	/* the same kernel as chosen by svorim for these parameters*/
+	if(kPolinomico == 1)
+	{
+		kernel = POLYNOMIAL ;
+		if(Ko >= 1)
+			p = (unsigned int) Ko ;
+	}
+
+	if(0 == m)
+	{
+		plhs[0] = mxCreateDoubleMatrix(0, 1, mxREAL) ;
+		if(nlhs > 1)
+			plhs[1] = mxCreateDoubleMatrix(0, 1, mxREAL) ;
+		return ;
+	}
+	if ( FALSE == Create_Svor_Model( &model, mxGetPr(prhs[0]), mxGetPr(prhs[1]), n, d, mxGetPr(prhs[2]), 
+		mxGetNumberOfElements(prhs[2]) + 1, kernel, Ko, p ) )
+	{
+		mexErrMsgTxt("The model can not be created");
+	}
+	Predict_Outputs( &model, nlhs, plhs, prhs[3], nThreads ) ;
+}
+/*end of mainSvorimPredict.c*/
@@ -11,14 +11,17 @@ if nargin < 1
         else
           setenv('CFLAGS','-O3 -fstack-protector-strong -Wformat -Werror=format-security -Wno-unused-result')
         end
-        mex mainSvorim.c alphas.c cachelist.c datalist.c def_settings.c kcv.c loadfile.c ordinal_takestep.c setandfi.c smo_kernel.c smo_routine.c smo_settings.c smo_timer.c svc_predict.c -output svorim
+        mex -lpthread mainSvorim.c alphas.c cachelist.c datalist.c def_settings.c kcv.c loadfile.c ordinal_takestep.c setandfi.c smo_approx.c smo_kernel.c smo_routine.c smo_settings.c smo_thread.c smo_timer.c svc_predict.c -output svorim
+        mex -lpthread mainSvorimPredict.c datalist.c smo_approx.c smo_kernel.c smo_thread.c smo_timer.c svc_predict.c -output svorimpredict
         delete *.o
       % This part is for MATLAB
       else
           if ispc
-            mex COMPFLAGS="\$COMPFLAGS -std=c99 -O3" -largeArrayDims mainSvorim.c alphas.c cachelist.c datalist.c def_settings.c kcv.c loadfile.c ordinal_takestep.c setandfi.c smo_kernel.c smo_routine.c smo_settings.c smo_timer.c svc_predict.c -output svorim
+            mex COMPFLAGS="\$COMPFLAGS -std=c99 -O3" -largeArrayDims mainSvorim.c alphas.c cachelist.c datalist.c def_settings.c kcv.c loadfile.c ordinal_takestep.c setandfi.c smo_approx.c smo_kernel.c smo_routine.c smo_settings.c smo_thread.c smo_timer.c svc_predict.c -output svorim
+            mex COMPFLAGS="\$COMPFLAGS -std=c99 -O3" -largeArrayDims mainSvorimPredict.c datalist.c smo_approx.c smo_kernel.c smo_thread.c smo_timer.c svc_predict.c -output svorimpredict
           else
-            mex CFLAGS="\$CFLAGS -std=c99 -O3" -largeArrayDims mainSvorim.c alphas.c cachelist.c datalist.c def_settings.c kcv.c loadfile.c ordinal_takestep.c setandfi.c smo_kernel.c smo_routine.c smo_settings.c smo_timer.c svc_predict.c -output svorim
+            mex CFLAGS="\$CFLAGS -std=c99 -O3" -largeArrayDims -lpthread mainSvorim.c alphas.c cachelist.c datalist.c def_settings.c kcv.c loadfile.c ordinal_takestep.c setandfi.c smo_approx.c smo_kernel.c smo_routine.c smo_settings.c smo_thread.c smo_timer.c svc_predict.c -output svorim
+            mex CFLAGS="\$CFLAGS -std=c99 -O3" -largeArrayDims -lpthread mainSvorimPredict.c datalist.c smo_approx.c smo_kernel.c smo_thread.c smo_timer.c svc_predict.c -output svorimpredict
           end
       end
     catch err
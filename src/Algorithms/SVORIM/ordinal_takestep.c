@@ -29,7 +29,6 @@ BOOL ordinal_takestep ( Alphas * alpha1, Alphas * alpha2, unsigned int threshold
 	double ObjH = 0, ObjL = 0 ;
 	Set_Name name1, name2 ;
 	Alphas * alpha3 = NULL ;
-	Cache_Node * cache = NULL ;
 	int * index ; 
 #ifdef _ORDINAL_DEBUG
 	double temp = 0 ; 
@@ -104,6 +103,8 @@ BOOL ordinal_takestep ( Alphas * alpha1, Alphas * alpha2, unsigned int threshold
 	F1 = alpha1->f_cache ;	
 	F2 = alpha2->f_cache ;		
 
+	Get_Kernel_Row( alpha1, settings ) ;
+	Get_Kernel_Row( alpha2, settings ) ;
 	K11 = Calc_Kernel( alpha1, alpha1, settings ) ; 
 	K12 = Calc_Kernel( alpha1, alpha2, settings ) ;
 	K22 = Calc_Kernel( alpha2, alpha2, settings ) ; 
@@ -228,6 +229,8 @@ BOOL ordinal_takestep ( Alphas * alpha1, Alphas * alpha2, unsigned int threshold
 
 		alpha1->alpha[threshold-1] = n1 ;
 		alpha2->alpha[threshold-1] = n2 ;
+		Update_Weight( alpha1, - s1*(n1 - a1), settings ) ;
+		Update_Weight( alpha2, - s2*(n2 - a2), settings ) ;
 
 
 
@@ -409,66 +412,12 @@ BOOL ordinal_takestep ( Alphas * alpha1, Alphas * alpha2, unsigned int threshold
 			}		
 		}
 
-		cache = Io_CACHE.front ;
-		while ( NULL != cache ) 
-		{
-			alpha3 = cache->alpha ;
-			if (0==index[alpha3-ALPHA])
-			{
-				alpha3->f_cache = alpha3->f_cache 
-					- s1*(n1 - a1)*Calc_Kernel( alpha1, alpha3, settings ) 
-					- s2*(n2 - a2)*Calc_Kernel( alpha2, alpha3, settings ) ;
-				index[alpha3-ALPHA] = 1 ;
-			}
-
-
-			for (loop = 0 ; loop < settings->pairs->classes-1 ; loop ++)
-			{
-				if (cache->alpha->pair->target > (loop+1) )
-				{
-
-					if (cache->alpha->setname[loop]==Io_b || cache->alpha->setname[loop]==I_One)
-					{
-						if (cache->alpha->f_cache-1<settings->bj_up[loop])
-						{
-							settings->bj_up[loop] = cache->alpha->f_cache-1 ;
-							settings->ij_up[loop] = cache->alpha - ALPHA + 1 ;
-						}
-					}
-					if (cache->alpha->setname[loop]==Io_b || cache->alpha->setname[loop]==I_Fou)
-					{
-						if (cache->alpha->f_cache-1>settings->bj_low[loop])
-						{
-							settings->bj_low[loop] = cache->alpha->f_cache-1 ;
-							settings->ij_low[loop] = cache->alpha - ALPHA + 1 ;
-						}
-					}
-				}
-				else
-				{
-
-					if (cache->alpha->setname[loop]==Io_a || cache->alpha->setname[loop]==I_Thr)
-					{
-						if (cache->alpha->f_cache+1<settings->bj_up[loop])
-						{
-							settings->bj_up[loop] = cache->alpha->f_cache+1 ;
-							settings->ij_up[loop] = cache->alpha - ALPHA + 1 ;
-						}
-					}
-					if (cache->alpha->setname[loop]==Io_a || cache->alpha->setname[loop]==I_Two)
-					{
-						if (cache->alpha->f_cache+1>settings->bj_low[loop])
-						{
-							settings->bj_low[loop] = cache->alpha->f_cache+1 ;
-							settings->ij_low[loop] = cache->alpha - ALPHA + 1 ;
-						}
-					}
-				}
-			}
-			cache = cache->next ;
-		}
+		Update_Io_Cache( alpha1, - s1*(n1 - a1), alpha2, - s2*(n2 - a2), index, settings ) ;
 
 		
+		/* keep f_cache of the other samples up to date as well*/
+		if ( TRUE == settings->fcacheall )
+			Update_Ordinal_Fi( alpha1, - s1*(n1 - a1), alpha2, - s2*(n2 - a2), index, settings ) ;
 		free(index) ;
 
 #ifdef _ORDINAL_DEBUG
@@ -16,14 +16,120 @@
     #include <malloc.h>
 #endif
 #include <math.h>
+#include <string.h>
 #include "smo.h"
 
 
+typedef struct _Fi_Task
+{
+	smo_Settings * settings ;
+	Alphas * ai ;
+	double * partial ; 
+} Fi_Task ;
+
+/* coefficient of sample aj in the expansion, summed over the thresholds*/
+static double Coef_Alpha ( Alphas * aj, smo_Settings * settings )
+{
+	double alpha = 0 ;
+	unsigned int k ;
+
+	for (k=0;k<settings->pairs->classes-1;k++)
+	{
+		if (MATRIX.target[aj-ALPHA]<=k+1)
+			alpha -= aj->alpha[k] ;
+		else
+			alpha += aj->alpha[k] ;
+	}
+	return alpha ;
+}
+
+/* serial sum of the expansion at ai over the samples [begin,end)*/
+static double Sum_Fi ( Alphas * ai, unsigned long int begin, unsigned long int end, smo_Settings * settings )
+{
+	Alphas * aj ;
+	double alpha ;
+	double Fi = 0 ;
+	unsigned long int j ;
+
+	for ( j = begin ; j < end ; j ++ )
+	{		
+		aj = ALPHA + j ;
+		alpha = Coef_Alpha( aj, settings ) ;
+		if ( alpha != 0 )
+			Fi = Fi + alpha * Calc_Kernel( aj, ai, settings ) ;
+	}
+	return Fi ;
+}
+
+static void Task_Fi ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	Fi_Task * task = (Fi_Task *) arg ;
+	task->partial[block] = Sum_Fi( task->ai, begin, end, task->settings ) ;
+}
+
+/*******************************************************************************\
+
+	double Linear_Fi ( Alphas * ai, smo_Settings * settings )
+	
+	Fi of ai for the linear kernel in primal form, the product of the weight 
+	vector with the packed input of ai plus the jitter of its own term
+	input:  the pointer to alpha and the pointer to smo_Settings 
+	output: the value of Fi
+
+\*******************************************************************************/
+
+double Linear_Fi ( Alphas * ai, smo_Settings * settings )
+{
+	return Matrix_Kernel( &(MATRIX), LINEAR, P, settings->weight, MATRIX.x + (ai-ALPHA)*MATRIX.stride ) 
+		+ 0.001 * Coef_Alpha( ai, settings ) ;
+}
+
+/*******************************************************************************\
+
+	void Update_Weight ( Alphas * alpha, double d, smo_Settings * settings )
+	
+	add d times the packed input of alpha to the weight vector, if any
+	input:  the pointer to alpha, the change of its coefficient and the pointer to smo_Settings 
+	output: none
+
+\*******************************************************************************/
+
+void Update_Weight ( Alphas * alpha, double d, smo_Settings * settings )
+{
+	double * x ;
+	unsigned int k ;
+
+	if ( NULL == settings->weight || 0 == d )
+		return ;
+	x = MATRIX.x + (alpha-ALPHA)*MATRIX.stride ;
+	for ( k = 0 ; k < MATRIX.cont ; k ++ )
+		settings->weight[k] = settings->weight[k] + d * x[k] ;
+}
+
+/* Fi of ai from scratch*/
+static double Ordinal_Fi ( Alphas * ai, smo_Settings * settings )
+{
+	if ( NULL != settings->weight )
+		return Linear_Fi( ai, settings ) ;
+	return Sum_Fi( ai, 0, MATRIX.count, settings ) ;
+}
+
+static void Task_Refresh_Fi ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	smo_Settings * settings = (smo_Settings *) arg ;
+	unsigned long int i ;
+
+	for ( i = begin ; i < end ; i ++ )
+		(ALPHA + i)->f_cache = Ordinal_Fi( ALPHA + i, settings ) ;
+}
+
 /*******************************************************************************\
 
 	double Calculate_Ordinal_Fi ( long unsigned int i, smo_Settings * settings )
 	
 	calculate Fi for input index i, which is defined as Fi=f(x_i)
+	the sum is split into one fixed block per thread and the blocks are added 
+	in order, so the result only depends on the number of threads
 	input:  index i in Data_List Pairs, and the pointer to smo_Settings 
 	output: the value of Fi
 
@@ -31,14 +137,10 @@
 
 double Calculate_Ordinal_Fi ( long unsigned int i, smo_Settings * settings )
 {
-	Alphas * ai ;
-	Alphas * aj ;
-	Data_Node * Pi ;
-	Data_Node * Pj ;
-	double alpha ;
+	Fi_Task task ;
+	unsigned long int chunk, b ;
+	unsigned int threads ;
     double Fi = 0 ;
-	long unsigned int j = 0 ;
-	long unsigned int k ;
 
 	if ( NULL == settings || i <= 0 )
 	{
@@ -52,37 +154,147 @@ double Calculate_Ordinal_Fi ( long unsigned int i, smo_Settings * settings )
 		exit(1) ;
 	}
 
-	ai = ALPHA + i - 1 ;
-	Pi = ai->pair ;
-	Pj = settings->pairs->front ;
+	task.ai = ALPHA + i - 1 ;
+	if ( NULL != settings->weight )
+		return Linear_Fi( task.ai, settings ) ;
+	threads = Thread_Pool_Size( POOL ) ;
+	if ( threads <= 1 || MATRIX.count < MINPARALLEL )
+		return Sum_Fi( task.ai, 0, MATRIX.count, settings ) ;
+
+	chunk = (MATRIX.count + threads - 1) / threads ;
+	task.settings = settings ;
+	task.partial = (double *) calloc(threads, sizeof(double)) ;
+	if ( NULL == task.partial )
+		return Sum_Fi( task.ai, 0, MATRIX.count, settings ) ;
+	Run_Thread_Pool( POOL, MATRIX.count, chunk, Task_Fi, &task ) ;
+	for ( b = 0 ; b < threads ; b ++ )
+		Fi = Fi + task.partial[b] ;
+	free( task.partial ) ;
+	return Fi ;
+
+} 
+
+/*******************************************************************************\
+
+	void Refresh_Ordinal_Fi ( smo_Settings * settings )
 	
-	while ( Pj != NULL )
-	{		
+	recalculate f_cache of all samples, in parallel over the samples, after 
+	rebuilding the weight vector of the linear kernel
+	input:  the pointer to smo_Settings 
+	output: none
+
+\*******************************************************************************/
+
+void Refresh_Ordinal_Fi ( smo_Settings * settings )
+{
+	unsigned int threads = Thread_Pool_Size( POOL ) ;
+	unsigned long int i ;
+
+	if ( NULL != settings->weight )
+	{
+		memset( settings->weight, 0, MATRIX.cont*sizeof(double) ) ;
+		for ( i = 0 ; i < MATRIX.count ; i ++ )
+			Update_Weight( ALPHA + i, Coef_Alpha( ALPHA + i, settings ), settings ) ;
+	}
+
+	Run_Thread_Pool( POOL, MATRIX.count, max(1, MATRIX.count/(8*threads)), Task_Refresh_Fi, settings ) ;
+}
+
+typedef struct _Update_Task
+{
+	smo_Settings * settings ;
+	Alphas * alpha1 ;
+	Alphas * alpha2 ;
+	double d1 ;
+	double d2 ;
+	int * index ;
+} Update_Task ;
+
+static void Task_Update_Fi ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	Update_Task * task = (Update_Task *) arg ;
+	smo_Settings * settings = task->settings ;
+	Alphas * aj ;
+	unsigned long int j ;
+
+	for ( j = begin ; j < end ; j ++ )
+	{
+		if ( NULL != task->index && 0 != task->index[j] )
+			continue ;
 		aj = ALPHA + j ;
-		alpha = 0 ;
-		for (k=0;k<settings->pairs->classes-1;k++)
-		{
-			if (aj->pair->target<=k+1)
-				alpha -= aj->alpha[k] ;
-			else
-				alpha += aj->alpha[k] ;
-		}
-		if ( alpha != 0 )
-			Fi = Fi + alpha * Calc_Kernel( aj, ai, settings ) ;
-		Pj = Pj->next ;
-		j++ ;
+		if ( TRUE == aj->shrunk )
+			continue ;
+		if ( 0 != task->d1 )
+			aj->f_cache = aj->f_cache + task->d1 * Calc_Kernel( task->alpha1, aj, settings ) ;
+		if ( 0 != task->d2 )
+			aj->f_cache = aj->f_cache + task->d2 * Calc_Kernel( task->alpha2, aj, settings ) ;
 	}
+}
 
-#ifdef _ORDINAL_DEBUG
-	if ( j != settings->pairs->count ) 
+/*******************************************************************************\
+
+	void Update_Ordinal_Fi ( Alphas * alpha1, double d1, Alphas * alpha2, double d2, int * index, smo_Settings * settings )
+	
+	add d1*K(x1,x)+d2*K(x2,x) to f_cache of every sample whose index is 0, i.e. 
+	the samples that the takestep did not update itself. with fcacheall the 
+	takesteps call it so that f_cache is valid for all samples, as libsvm 
+	keeps its gradient, and examine_example needs no Calculate_Ordinal_Fi.
+	the kernel rows of alpha1 and alpha2 are fetched by the takestep already.
+	input:  the two updated alphas and the changes of their coefficients, 
+	        the flags of updated samples (or NULL), and the pointer to smo_Settings 
+	output: none
+
+\*******************************************************************************/
+
+void Update_Ordinal_Fi ( Alphas * alpha1, double d1, Alphas * alpha2, double d2, int * index, smo_Settings * settings )
+{
+	Update_Task task ;
+	unsigned int threads = Thread_Pool_Size( POOL ) ;
+
+	task.settings = settings ;
+	task.alpha1 = alpha1 ;
+	task.alpha2 = alpha2 ;
+	task.d1 = d1 ;
+	task.d2 = d2 ;
+	task.index = index ;
+	if ( threads <= 1 || MATRIX.count < MINPARALLEL )
+		Task_Update_Fi( &task, 0, MATRIX.count, 0 ) ;
+	else
+		Run_Thread_Pool( POOL, MATRIX.count, (MATRIX.count + threads - 1)/threads, Task_Update_Fi, &task ) ;
+}
+
+static void Task_Unshrink_Fi ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	smo_Settings * settings = (smo_Settings *) arg ;
+	unsigned long int i ;
+
+	for ( i = begin ; i < end ; i ++ )
 	{
-		printf ( "Error in Calculate Fi \n" ) ;
-		exit(1) ;
+		if ( TRUE == (ALPHA + i)->shrunk )
+			(ALPHA + i)->f_cache = Ordinal_Fi( ALPHA + i, settings ) ;
 	}
-#endif
-	return Fi ;
+}
 
-} 
+/*******************************************************************************\
+
+	void Unshrink_Alphas ( smo_Settings * settings )
+	
+	bring the shrunk samples back, recalculating their f_cache with fcacheall
+	input:  the pointer to smo_Settings 
+	output: none
+
+\*******************************************************************************/
+
+void Unshrink_Alphas ( smo_Settings * settings )
+{
+	unsigned int threads = Thread_Pool_Size( POOL ) ;
+	unsigned long int i ;
+
+	if ( TRUE == settings->fcacheall )
+		Run_Thread_Pool( POOL, MATRIX.count, max(1, MATRIX.count/(8*threads)), Task_Unshrink_Fi, settings ) ;
+	for ( i = 0 ; i < MATRIX.count ; i ++ )
+		(ALPHA + i)->shrunk = FALSE ;
+}
 
 /*******************************************************************************\
 
@@ -39,6 +39,16 @@ typedef enum _BOOL
 
 #define MINNUM          (2)			
 #define LENGTH          (307200)		 
+#define LOADCHUNK       (1<<22)		/* bytes of data file parsed by one thread */
+#define ROWALIGN        (8)			
+#define PROGRESS        (1000)		/* takesteps between two calls of the progress callback */
+
+/* add n to a counter that the worker threads may share*/
+#ifdef _WIN32
+#define COUNT_ADD(counter, n)  ((counter) += (n))	/* the thread pool runs serially*/
+#else
+#define COUNT_ADD(counter, n)  __atomic_fetch_add( &(counter), (n), __ATOMIC_RELAXED )
+#endif
 
 struct estructura
 {
@@ -48,6 +58,7 @@ struct estructura
 	double * alpha;
 	double * biasj;
 	double * guess;
+	double * alphas;
 
 };
 
@@ -87,6 +98,14 @@ typedef enum _Kernel_Name
 
 } Kernel_Name ;
 
+typedef enum _Approx_Name
+{
+	EXACT = 0 ,	
+	NYSTROM = 1 ,
+	FOURIER = 2 ,
+
+} Approx_Name ;
+
 typedef enum _Training_Method
 {
 	BAYESIAN = 1 ,
@@ -128,26 +147,139 @@ typedef struct _Data_List
 	double * x_devi ;				
 	Data_Node * front ;          
 	Data_Node * rear ;             
+	double * block ;                /* points of all nodes in one block, or NULL */
+	unsigned long int ld ;          /* if not 0, points are read in place from a column-major matrix, ld apart */
 
 } Data_List ;
 
-typedef struct _Cache_Node
+typedef struct _Data_Matrix 
 {
-	double new_Fi ;
-	struct _Alphas * alpha ;
-	struct _Cache_Node * previous ;
-	struct _Cache_Node * next ;
+	unsigned long int count ;       
+	unsigned int dimen ;            
+	unsigned int stride ;           
+	unsigned int numeric ;          /* continuous inputs, stored first */
+	unsigned int cont ;             
+	unsigned int cat ;              
+	unsigned int * column ;         
+	double * scale ;                
+	double * weight ;               
+	double sumweight ;              
+	BOOL scaled ;                   
+	double * x ;                    
+	unsigned int * target ;         
+	int * fold ;                    
+
+} Data_Matrix ;
+
+/* kernel evaluations instantiated for one kernel type and order, with or 
+   without categorical inputs, see Get_Kernel_Ops*/
+typedef struct _Kernel_Ops
+{
+	double (* pair) ( Data_Matrix * matrix, unsigned int p, double * pi, double * pj ) ;
+	void (* row) ( Data_Matrix * matrix, unsigned int p, double * pi, unsigned long int begin, unsigned long int end, double * row ) ;
+	double (* sum) ( Data_Matrix * matrix, unsigned int p, double * pi, double * coef, unsigned long int begin, unsigned long int end, double sum ) ;
+
+} Kernel_Ops ;
 
-} Cache_Node ;
+/* low-rank feature map approximating the kernel, see smo_approx.c*/
+typedef struct _Feature_Map
+{
+	Approx_Name approx ;
+	unsigned int rank ;
+	Data_Matrix input ;
+	unsigned int p ;
+	const Kernel_Ops * kops ;
+	double * factor ;
+	double * phase ;
+
+} Feature_Map ;
+
+typedef struct _Svor_Model 
+{
+	Data_Matrix matrix ;	/* packed and scaled inputs of the support vectors only */
+	double * coef ;				
+	double * biasj ;			
+	unsigned int classes ;
+	Kernel_Name kernel ;
+	unsigned int p ;
+	double kappa ;
+	double * ard ;		/* already folded into matrix.scale and matrix.weight */
+	double * x_mean ;	/* NULL if the training inputs were not normalized */
+	double * x_devi ;
+	void * map ;		/* model file holding all the arrays above, NULL if allocated */
+	unsigned long int mapsize ;
+
+} Svor_Model ;
+
+/* sections of a binary model file, each one starting at a multiple of MODELALIGN */
+typedef enum _Model_Section 
+{
+	MODEL_COLUMN = 0,
+	MODEL_SCALE ,
+	MODEL_WEIGHT ,
+	MODEL_ARD ,
+	MODEL_MEAN ,
+	MODEL_DEVI ,
+	MODEL_BIASJ ,
+	MODEL_COEF ,
+	MODEL_X ,
+	MODEL_SECTIONS ,
+
+} Model_Section ;
+
+/* header at the start of a binary model file, in the native byte order */
+typedef struct _Model_Header 
+{
+	char magic[8] ;
+	unsigned int version ;
+	unsigned int order ;
+	unsigned int kernel ;
+	unsigned int p ;
+	unsigned int classes ;
+	unsigned int dimen ;
+	unsigned int numeric ;
+	unsigned int cont ;
+	unsigned int cat ;
+	unsigned int stride ;
+	unsigned int normalized ;
+	unsigned int reserved ;
+	double kappa ;
+	double sumweight ;
+	unsigned long long count ;
+	unsigned long long size ;
+	unsigned long long offset[MODEL_SECTIONS] ;
+
+} Model_Header ;
 
 typedef struct _Cache_List 
 {
 	long unsigned int count ;
-	Cache_Node * front ;
-	Cache_Node * rear ;
+	long unsigned int size ;	
+	struct _Alphas ** member ;	/* the alphas in Io packed, the latest one at the end */
 	
 } Cache_List ;
 
+typedef struct _Kernel_Cache
+{
+	unsigned long int count ;       
+	unsigned long int size ;        
+	unsigned long int used ;        
+	double ** row ;                 
+	long int * prev ;               
+	long int * next ;               
+	long int head ;                 
+	long int tail ;                 
+
+} Kernel_Cache ;
+
+typedef struct _Thread_Pool Thread_Pool ;
+typedef struct _Smo_Timer
+{
+	double start ;
+	double end ;
+} Smo_Timer ;
+typedef void (* Thread_Task) ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block ) ;
+
 typedef struct _Alphas
 {
 	double * alpha ;
@@ -155,11 +287,36 @@ typedef struct _Alphas
 	double * kernel ;					
 
 	Data_Node * pair ;					
-	Cache_Node * cache ;				
+	long unsigned int cache ;	/* position in Cache List plus 1, 0 if not in Io */
 	Set_Name * setname ;				
+	BOOL shrunk ;
 
 } Alphas ;
 
+typedef struct _Smo_Stats
+{
+	unsigned long int precomputed ; /* kernel evaluations before SMO*/
+	unsigned long int kernels ;     /* kernel evaluations in the last SMO*/
+	unsigned long int hits ;        /* kernel rows found in the bounded cache*/
+	unsigned long int misses ;
+	unsigned long int accepted ;    /* takesteps that updated a pair*/
+	unsigned long int rejected ;
+	unsigned long int sweeps ;      /* examineAll sweeps*/
+	unsigned long int io_peak ;
+	unsigned long int io_count ;
+	unsigned long int io_size ;
+	unsigned long int * io ;        /* size of Io at every sweep and every PROGRESS steps*/
+	double precompute ;             /* wall times*/
+	double optimise ;
+	double predict ;
+	double memory ;                 /* peak resident memory in MB, 0 if unknown*/
+
+} Smo_Stats ;
+
+/* SMO stops if it returns FALSE*/
+struct _smo_Settings ;
+typedef BOOL (* Smo_Progress) ( struct _smo_Settings * settings, void * arg ) ;
+
 
 typedef struct _smo_Settings
 {
@@ -172,10 +329,24 @@ typedef struct _smo_Settings
 	Kernel_Name kernel ;            
 	unsigned int p ;               
 	double kappa ;					
+	const Kernel_Ops * kops ;
 
 	struct _Alphas * alpha ;		
 	struct _Cache_List io_cache ;	
 	struct _Data_List * pairs ;		
+	struct _Data_Matrix matrix ;	
+	struct _Kernel_Cache kcache ;	
+	struct _Thread_Pool * pool ;	
+	double * weight ;				/* sum of alpha*x for the linear kernel, otherwise NULL*/
+	BOOL primal ;					/* no kernel cache, f_cache is taken from weight*/
+	unsigned int threads ;			
+	struct _Feature_Map * fmap ;	/* NULL unless the kernel is approximated*/
+	double map_timing ;
+	BOOL secondorder ;
+	double * diag ;					/* kernel diagonal if secondorder*/
+	Smo_Stats stats ;
+	Smo_Progress progress ;			/* called after every sweep and every PROGRESS steps, or NULL*/
+	void * progress_arg ;
 	
 	Method_Name method ;        
 
@@ -193,6 +364,11 @@ typedef struct _smo_Settings
 
 	unsigned long int cache_size ;  
 	BOOL cacheall ;
+	BOOL fcacheall ;                
+	BOOL warm ;                
+	BOOL shrinking ;
+	long unsigned int shrunk ;
+	Smo_Timer timer ;
 	BOOL ardon ;
 	
 
@@ -232,6 +408,13 @@ typedef struct _def_Settings
 	unsigned int kfold ;       
 	unsigned int repeat ;      
 	unsigned long int cache_size ;  
+	unsigned int threads ;          
+	BOOL fcacheall ;                
+	BOOL seeding ;                
+	BOOL shrinking ;
+	Approx_Name approx ;
+	unsigned int rank ;
+	BOOL secondorder ;
 
 	double lnC_start ;
 	double lnC_end ;
@@ -286,6 +469,7 @@ typedef struct _kcv_Settings
 	Data_Node ** nodelist ;
 	Data_Node *** pointernode ;
 	unsigned int ** cvfold ;
+	unsigned int seed ;
 	
 	double * cv_error ;           
 	double * cv_mean ;            
@@ -333,6 +517,10 @@ typedef struct _kcv_Settings
 #define DURATION       (settings->duration) 
 #define Io_CACHE       (settings->io_cache) 
 #define ALPHA          (settings->alpha)
+#define MATRIX         (settings->matrix)
+#define KCACHE         (settings->kcache)
+#define POOL           (settings->pool)
+#define KOPS           (settings->kops)
 #define INPUTFILE      (settings->inputfile) 
 #define TESTFILE       (settings->testfile) 
 #define DUMPINGFILE    (settings->dumpingfile)
@@ -363,6 +551,21 @@ typedef struct _kcv_Settings
 #define DEF_COARSESTEP   (0.5)
 #define DEF_REFINESTEP   (0.1)
 #define DEF_CACHE        (5000)
+#define DEF_THREADS      (1)
+#define DEF_FCACHEALL    (FALSE)
+#define DEF_SEEDING      (FALSE)
+#define DEF_SHRINKING    (FALSE)
+#define DEF_APPROX       (EXACT)
+#define DEF_RANK         (0)
+#define DEF_SECONDORDER  (FALSE)
+#define TAU              (1e-12)
+#define MINPARALLEL      (2048)
+#define PREDICTBLOCK     (64)
+#define SVBLOCK          (512)
+#define MODEL_MAGIC      "SVORMDL"
+#define MODEL_VERSION    (1)
+#define MODEL_ORDER      (0x01020304)
+#define MODELALIGN       (64)
 #define DEF_ZOOMIN       (5)
 #define DEF_REPEAT       (1) 
 #define DEF_LOOP         (2)
@@ -373,7 +576,7 @@ def_Settings * Create_def_Settings ( char * filename );
 def_Settings * Create_def_Settings_Matlab ( void );
 void Clear_def_Settings( def_Settings * settings ) ;
 //BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol, double ** train,double ** test );
-BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol, double ** train);
+BOOL Update_def_Settings_Matlab( def_Settings * defsetting, int nFil, int nCol, double * train);
 BOOL Update_def_Settings( def_Settings * defsetting );
 
 
@@ -384,35 +587,64 @@ BOOL Clear_Data_List ( Data_List * list ) ;
 BOOL Add_Data_List ( Data_List * list, Data_Node * node ) ;
 Data_Node * Create_Data_Node ( long unsigned int index, double * point, unsigned int y ) ;
 BOOL Clear_Label_Data_List ( Data_List * list ) ;
+BOOL Init_Data_Matrix ( Data_Matrix * matrix, unsigned long int count, unsigned int dimen, int * featuretype ) ;
+BOOL Create_Data_Matrix ( Data_Matrix * matrix, Data_List * list ) ;
+BOOL Clear_Data_Matrix ( Data_Matrix * matrix ) ;
+BOOL Pack_Data_Point ( Data_Matrix * matrix, double * point, double * x ) ;
 
 /*	load data file settings->inputfile, and create the data list Pairs 
 //BOOL smo_Loadfile ( Data_List * , char * , int ) ;*/
-BOOL smo_Loadfile_Matlab ( Data_List * pairs, char * inputfilename, int inputdim, int nFil, int nCol, double ** matrix);
-BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim );  
+BOOL smo_Loadfile_Matlab ( Data_List * pairs, char * inputfilename, int inputdim, int nFil, int nCol, double * matrix, int ld);
+BOOL smo_Loadfile ( Data_List * pairs, char * inputfilename, int inputdim, unsigned int threads );  
 
 
 /*create and initialize the smo_Settings structure from def_Settings*/
 smo_Settings * Create_smo_Settings ( def_Settings * settings ) ;
 void Clear_smo_Settings( smo_Settings * settings ) ;
 
-/* cache, a doubly linked list*/
+/* cache of Set Io, a packed array*/
 BOOL Create_Cache_List( Cache_List * ) ;
 BOOL Clear_Cache_List( Cache_List * ) ;
 BOOL Is_Cache_Empty( Cache_List * ) ;
 BOOL Add_Cache_Node( Cache_List *, Alphas * ) ;
-BOOL Sort_Cache_Node( Cache_List *, Alphas * ) ;
 BOOL Del_Cache_Node( Cache_List *, Alphas * ) ; 
+void Update_Io_Cache ( Alphas * alpha1, double d1, Alphas * alpha2, double d2, int * index, smo_Settings * settings ) ;
 
 /* create Alpha Matrix*/
 Alphas * Create_Alphas( smo_Settings * ) ;
 BOOL Clean_Alphas ( Alphas *, smo_Settings * ) ;
 BOOL Check_Alphas ( Alphas *, smo_Settings * ) ;
+BOOL Seed_Alphas ( Alphas *, double, smo_Settings * ) ;
+BOOL Assign_Alphas ( Alphas *, double *, smo_Settings * ) ;
 BOOL Clear_Alphas ( smo_Settings * ) ;
 
 /* calculate kerenl*/
 double Calc_Kernel( Alphas * , Alphas * , smo_Settings * ) ;
 double Calculate_Kernel( double * , double * , smo_Settings * ) ;
-double Calculate_Ordinal_Fi ( long unsigned int i, smo_Settings * settings ) ;
+double Matrix_Kernel( Data_Matrix * , Kernel_Name , unsigned int , double * , double * ) ;
+const Kernel_Ops * Get_Kernel_Ops( Data_Matrix * , Kernel_Name , unsigned int ) ;
+BOOL Scale_Data_Matrix ( smo_Settings * ) ;
+BOOL Create_Kernel_Cache ( Kernel_Cache * , unsigned long int count, unsigned long int size ) ;
+BOOL Clear_Kernel_Cache ( Kernel_Cache * ) ;
+double * Get_Kernel_Row ( Alphas * , smo_Settings * ) ;
+
+/* thread pool*/
+Thread_Pool * Create_Thread_Pool ( unsigned int threads ) ;
+void Clear_Thread_Pool ( Thread_Pool * pool ) ;
+unsigned int Thread_Pool_Size ( Thread_Pool * pool ) ;
+void Run_Thread_Pool ( Thread_Pool * pool, unsigned long int count, unsigned long int chunk, Thread_Task task, void * arg ) ;
+
+Feature_Map * Create_Feature_Map ( smo_Settings * settings, Approx_Name approx, unsigned int rank, unsigned int seed ) ;
+BOOL Map_Data_Point ( Feature_Map * fmap, double * x, double * z ) ;
+BOOL Map_Data_Matrix ( smo_Settings * settings ) ;
+BOOL Clear_Feature_Map ( Feature_Map * fmap ) ;
+
+double Calculate_Ordinal_Fi ( long unsigned int i, smo_Settings * settings ) ;
+void Refresh_Ordinal_Fi ( smo_Settings * settings ) ;
+void Update_Ordinal_Fi ( Alphas * alpha1, double d1, Alphas * alpha2, double d2, int * index, smo_Settings * settings ) ;
+void Unshrink_Alphas ( smo_Settings * settings ) ;
+double Linear_Fi ( Alphas * ai, smo_Settings * settings ) ;
+void Update_Weight ( Alphas * alpha, double d, smo_Settings * settings ) ;
 
 /* get label*/
 Set_Name Get_Ordinal_Label ( Alphas * , unsigned int, smo_Settings * settings) ;
@@ -425,6 +657,15 @@ double Calculate_Ordinal_Fi( long unsigned int, smo_Settings * ) ;
 BOOL Is_Io ( Alphas * alpha, smo_Settings * settings ) ;
 BOOL smo_routine ( smo_Settings * settings ) ;
 BOOL svm_predict ( Data_List * test, smo_Settings * settings ) ;
+BOOL Create_Svor_Model ( Svor_Model * model, double * sv, double * coef, unsigned long int count, unsigned int dimen, 
+	double * biasj, unsigned int classes, Kernel_Name kernel, double kappa, unsigned int p ) ;
+BOOL Predict_Svor_Model ( Svor_Model * model, double * test, unsigned long int count, double * fx, double * guess, Thread_Pool * pool ) ;
+void Clear_Svor_Model ( Svor_Model * model ) ;
+BOOL Settings_Svor_Model ( Svor_Model * model, smo_Settings * settings ) ;
+BOOL Save_Svor_Model ( Svor_Model * model, char * filename ) ;
+BOOL Load_Svor_Model ( Svor_Model * model, char * filename ) ;
+BOOL svm_predict_model ( Data_List * testlist, Svor_Model * model, Thread_Pool * pool, double * testerror, double * testrate ) ;
+BOOL svm_saveguess ( Data_List * testlist, char * inputfile ) ;
 
 kcv_Settings * Create_Kcv ( def_Settings * settings ) ;
 BOOL Init_Kcv ( kcv_Settings * settings, def_Settings * defsetting ) ;
@@ -432,7 +673,8 @@ BOOL Clear_Kcv ( kcv_Settings * settings) ;
 /*BOOL svm_saveresults ( Data_List * testlist, smo_Settings * settings ) ;*/
 BOOL svm_saveresults ( Data_List * testlist, smo_Settings * settings );
 
-struct estructura svm_saveresults_Matlab(Data_List * testlist, smo_Settings * settings);
+struct estructura svm_saveresults_Matlab(Data_List * testlist, smo_Settings * settings, BOOL projection);
+BOOL Save_Smo_Stats ( smo_Settings * settings, char * filename ) ;
 
 BOOL Rehearsal_Kcv ( kcv_Settings * kcvsetting, def_Settings * defsetting ) ;
 
@@ -440,9 +682,13 @@ BOOL ordinal_takestep ( Alphas * alpha1, Alphas * alpha2, unsigned int threshold
 Set_Name Get_Ordinal_Label ( Alphas * alpha, unsigned int j, smo_Settings * settings) ;
 
 /*timing routines*/
-void tstart(void) ;
-void tend(void) ;
-double tval() ;
+void tstart(Smo_Timer * timer) ;
+void tend(Smo_Timer * timer) ;
+double tval(Smo_Timer * timer) ;
+double tcpu(void) ;
+double twall(void) ;
+double tmemory(void) ;
+double urand(unsigned int * seed) ;
 
 #endif
 
@@ -30,6 +30,69 @@ unsigned int active_threshold (smo_Settings * settings)
 	return j ; 
 }
 
+/* the value of alpha at threshold, F-1 above it or F+1 below it, and TRUE 
+   if it is in the low set of the threshold if low, or in the up set otherwise */
+static BOOL ordinal_threshold_side ( Alphas * alpha, unsigned int threshold, BOOL low, double * value )
+{
+	Set_Name name = alpha->setname[threshold-1] ;
+
+	if ( alpha->pair->target > threshold )
+	{
+		*value = alpha->f_cache - 1 ;
+		if ( TRUE == low )
+			return ( Io_b == name || I_Fou == name ) ? TRUE : FALSE ;
+		return ( Io_b == name || I_One == name ) ? TRUE : FALSE ;
+	}
+	*value = alpha->f_cache + 1 ;
+	if ( TRUE == low )
+		return ( Io_a == name || I_Two == name ) ? TRUE : FALSE ;
+	return ( Io_a == name || I_Thr == name ) ? TRUE : FALSE ;
+}
+
+/*******************************************************************************\
+
+	long unsigned int ordinal_second_order ( Alphas * alpha, unsigned int threshold, BOOL low, long unsigned int extreme, smo_Settings * settings )
+
+	the partner of alpha at threshold of the largest gap*gap/eta, as the 
+	second-order working set selection of libsvm, among the samples in the low 
+	set if low, or in the up set otherwise, that violate the condition with 
+	alpha by more than TOL. the candidates are the samples in Io and the 
+	first-order extreme, whose Fi are up to date.
+	input:  the alpha, the threshold, the set of the partner, the index of 
+	        the first-order partner and the pointer to smo_Settings
+	output: the index of the partner, extreme if none does better
+
+\*******************************************************************************/
+
+static long unsigned int ordinal_second_order ( Alphas * alpha, unsigned int threshold, BOOL low, long unsigned int extreme, smo_Settings * settings )
+{
+	Alphas * cand ;
+	long unsigned int i, best = extreme ;
+	double F = 0, value = 0, gap, eta, gain, most = 0 ;
+
+	ordinal_threshold_side( alpha, threshold, low, &F ) ;
+	Get_Kernel_Row( alpha, settings ) ;
+	for ( i = 0 ; i <= Io_CACHE.count ; i ++ )
+	{
+		cand = ( i < Io_CACHE.count ) ? Io_CACHE.member[i] : ALPHA + extreme - 1 ;
+		if ( cand == alpha || FALSE == ordinal_threshold_side( cand, threshold, low, &value ) )
+			continue ;
+		gap = ( TRUE == low ) ? value - F : F - value ;
+		if ( gap <= TOL )
+			continue ;
+		eta = settings->diag[cand - ALPHA] + settings->diag[alpha - ALPHA] - 2.0*Calc_Kernel( cand, alpha, settings ) ;
+		if ( eta <= 0 )
+			eta = TAU ;
+		gain = gap*gap/eta ;
+		if ( gain > most )
+		{
+			most = gain ;
+			best = cand - ALPHA + 1 ;
+		}
+	}
+	return best ;
+}
+
 BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 {
 	double F2 = 0 ;
@@ -38,6 +101,7 @@ BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 	long unsigned int i1 = 0 ;
 	long unsigned int i2 = 0 ;
 	BOOL optimal = TRUE ; 
+	BOOL low = FALSE ;
 
 	if ( NULL == alpha || NULL == settings )
 		return FALSE ;
@@ -57,7 +121,8 @@ BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 
 	if ( FALSE == Is_Io(alpha,settings) )
 	{
-		alpha->f_cache = Calculate_Ordinal_Fi(i2, settings) ;
+		if ( FALSE == settings->fcacheall )
+			alpha->f_cache = Calculate_Ordinal_Fi(i2, settings) ;
 
 		for (loop = 0 ; loop < settings->pairs->classes-1 ; loop ++)
 		{
@@ -120,6 +185,7 @@ BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 						i1 = settings->ij_low[loop] ;
 						F2 = settings->bj_low[loop]-(alpha->f_cache-1) ;
 						j = loop+1 ;
+						low = TRUE ;
 					}
 				}
 			}
@@ -133,6 +199,7 @@ BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 						i1 = settings->ij_up[loop] ;
 						F2 = (alpha->f_cache-1) - settings->bj_up[loop] ;
 						j = loop+1 ; 
+						low = FALSE ;
 					}
 				}
 			}
@@ -150,6 +217,7 @@ BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 						i1 = settings->ij_low[loop] ;
 						F2 = settings->bj_low[loop]-(alpha->f_cache+1) ;
 						j = loop+1 ;
+						low = TRUE ;
 					}
 				}
 			}
@@ -163,6 +231,7 @@ BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 						i1 = settings->ij_up[loop] ;
 						F2 = (alpha->f_cache+1)-settings->bj_up[loop] ;
 						j = loop+1 ;
+						low = FALSE ;
 					}
 				}
 			}
@@ -171,10 +240,17 @@ BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 
 	if (optimal == FALSE)
 	{		
+		/* a better partner at the threshold by the second-order gain */
+		if ( TRUE == settings->secondorder )
+			i1 = ordinal_second_order( alpha, j, low, i1, settings ) ;
 		if (TRUE ==  ordinal_takestep( ALPHA + i1 - 1, ALPHA + i2 - 1, j , settings) )
+		{
+			settings->stats.accepted += 1 ;
 			return TRUE ;
+		}
 		else 
 		{
+			settings->stats.rejected += 1 ;
 			if ( TRUE == SMO_DISPLAY )
 			{
 				printf("%lu and %lu failed in takestep.\n",i1,i2) ;
@@ -185,13 +261,93 @@ BOOL ordinal_examine_example ( Alphas * alpha, smo_Settings * settings )
 	return FALSE ;
 }
 
+/*******************************************************************************\
+
+	BOOL ordinal_shrinkable ( Alphas * alpha, smo_Settings * settings )
+
+	a sample at bound can be left out of the sweeps if its Fi lies beyond the 
+	current b_low and b_up of every threshold, as the shrinking of libsvm. 
+	the samples in Io and the current extremes of the bounds are never shrunk.
+	input:  the alpha just examined, and the pointer to smo_Settings
+	output: TRUE if alpha can be shrunk
+
+\*******************************************************************************/
+
+static BOOL ordinal_shrinkable ( Alphas * alpha, smo_Settings * settings )
+{
+	double F = alpha->f_cache ;
+	long unsigned int i = alpha - ALPHA + 1 ;
+	unsigned int loop ;
+
+	if ( TRUE == Is_Io(alpha, settings) )
+		return FALSE ;
+	for ( loop = 0 ; loop < settings->pairs->classes - 1 ; loop ++ )
+	{
+		if ( i == settings->ij_up[loop] || i == settings->ij_low[loop] )
+			return FALSE ;
+		if ( alpha->pair->target > loop + 1 )
+		{
+			if ( I_One == alpha->setname[loop] && F - 1 <= settings->bj_low[loop] )
+				return FALSE ;
+			if ( I_Fou == alpha->setname[loop] && F - 1 >= settings->bj_up[loop] )
+				return FALSE ;
+		}
+		else
+		{
+			if ( I_Thr == alpha->setname[loop] && F + 1 <= settings->bj_low[loop] )
+				return FALSE ;
+			if ( I_Two == alpha->setname[loop] && F + 1 >= settings->bj_up[loop] )
+				return FALSE ;
+		}
+	}
+	return TRUE ;
+}
+
+/*******************************************************************************\
+
+	BOOL ordinal_progress ( smo_Settings * settings )
+
+	record the size of Io in settings->stats and call the progress callback, 
+	which sets settings->abort if it returns FALSE.
+	input:  the pointer to smo_Settings
+	output: FALSE if SMO has to stop
+
+\*******************************************************************************/
+
+static BOOL ordinal_progress ( smo_Settings * settings )
+{
+	Smo_Stats * stats = &(settings->stats) ;
+	unsigned long int * io ;
+
+	if ( stats->io_count >= stats->io_size )
+	{
+		io = (unsigned long int *) realloc( stats->io, (2*stats->io_size + 64)*sizeof(unsigned long int) ) ;
+		if ( NULL != io )
+		{
+			stats->io = io ;
+			stats->io_size = 2*stats->io_size + 64 ;
+		}
+	}
+	if ( stats->io_count < stats->io_size )
+		stats->io[stats->io_count++] = Io_CACHE.count ;
+	if ( Io_CACHE.count > stats->io_peak )
+		stats->io_peak = Io_CACHE.count ;
+	if ( NULL != settings->progress && FALSE == settings->progress( settings, settings->progress_arg ) )
+		settings->abort = TRUE ;
+	return ( TRUE == settings->abort ) ? FALSE : TRUE ;
+}
+
 BOOL smo_ordinal (smo_Settings * settings)
 {
 	BOOL examineAll = TRUE ;
+	BOOL verify = FALSE ;
 	long unsigned int numChanged = 0 ;
+	long unsigned int shrunk = 0 ;
 	Alphas * alpha = NULL ;   
 	long unsigned int loop = 0 ;
+	long unsigned int next = PROGRESS ;
 	unsigned int j ;
+	double start = twall() ;
 	
 	if (NULL == settings)
 		return FALSE ;
@@ -202,7 +358,19 @@ BOOL smo_ordinal (smo_Settings * settings)
 		return FALSE ;
 	}
 	SMO_WORKING = TRUE ;
-	Clean_Alphas (ALPHA, settings) ;	
+	/* start from the seeded alphas if any */
+	if ( FALSE == settings->warm )
+		Clean_Alphas (ALPHA, settings) ;
+	settings->warm = FALSE ;
+	settings->shrunk = 0 ;
+	settings->stats.kernels = 0 ;
+	settings->stats.hits = 0 ;
+	settings->stats.misses = 0 ;
+	settings->stats.accepted = 0 ;
+	settings->stats.rejected = 0 ;
+	settings->stats.sweeps = 0 ;
+	settings->stats.io_peak = 0 ;
+	settings->stats.io_count = 0 ;
 	Check_Alphas ( ALPHA, settings ) ;
 
 	if ( TRUE == SMO_DISPLAY )
@@ -215,7 +383,7 @@ BOOL smo_ordinal (smo_Settings * settings)
 		printf("\n") ;
 	}
 
-	tstart() ; 
+	tstart( &(settings->timer) ) ; 
 
 
 	while ( numChanged > 0 || examineAll )
@@ -226,8 +394,31 @@ BOOL smo_ordinal (smo_Settings * settings)
 			numChanged = 0 ;
 			for ( loop = 1; loop <= settings->pairs->count; loop ++ )
 			{
-				numChanged += ordinal_examine_example( ALPHA + loop - 1, settings ) ; 
+				alpha = ALPHA + loop - 1 ;
+				if ( TRUE == alpha->shrunk )
+					continue ;
+				if ( TRUE == ordinal_examine_example( alpha, settings ) )
+				{
+					numChanged += 1 ;
+					if ( settings->stats.accepted >= next )
+					{
+						next = settings->stats.accepted + PROGRESS ;
+						if ( FALSE == ordinal_progress( settings ) )
+							break ;
+					}
+				}
+				else if ( TRUE == settings->shrinking && FALSE == verify 
+					&& TRUE == ordinal_shrinkable( alpha, settings ) )
+				{
+					alpha->shrunk = TRUE ;
+					shrunk += 1 ;
+				}
 			}			
+			if ( shrunk > settings->shrunk )
+				settings->shrunk = shrunk ;
+			settings->stats.sweeps += 1 ;
+			if ( TRUE == settings->abort || FALSE == ordinal_progress( settings ) )
+				break ;
 			if (TRUE == SMO_DISPLAY)
 				for (loop=1;loop<settings->pairs->classes;loop++)
 					printf("threshold %lu : up=%f(%lu), low=%f(%lu)\n", loop, settings->bj_up[loop-1], 
@@ -239,21 +430,44 @@ BOOL smo_ordinal (smo_Settings * settings)
 			j = active_threshold (settings) ;
 			while ( numChanged>0&&j>0 )
 			{
+				if ( settings->stats.accepted >= next )
+				{
+					next = settings->stats.accepted + PROGRESS ;
+					if ( FALSE == ordinal_progress( settings ) )
+						break ;
+				}
+				/* the most violating pair, or the extreme up and its best partner */
+				if ( TRUE == settings->secondorder )
+					numChanged = ordinal_takestep (ALPHA + settings->ij_up[j-1] - 1, 
+						ALPHA + ordinal_second_order( ALPHA + settings->ij_up[j-1] - 1, j, TRUE, settings->ij_low[j-1], settings ) - 1, j, settings) ;
+				else
 				numChanged = ordinal_takestep (ALPHA + settings->ij_up[j-1] - 1, 
 					ALPHA + settings->ij_low[j-1] - 1, j, settings) ;
+				if ( numChanged > 0 )
+					settings->stats.accepted += 1 ;
+				else
+					settings->stats.rejected += 1 ;
 				j = active_threshold (settings) ;
 			}
 			numChanged = 0 ;
 			if ( TRUE == settings->abort )
-			{
-				SMO_WORKING = FALSE ;
-				return FALSE ;
-			}
+				break ;
 		} 
 
 		if ( TRUE == examineAll )
 		{
-			examineAll = FALSE ;
+			if ( 0 == numChanged && shrunk > 0 )
+			{
+				/* bring back the shrunk samples and sweep over all of them again */
+				Unshrink_Alphas( settings ) ;
+				shrunk = 0 ;
+				verify = TRUE ;
+			}
+			else
+			{
+				examineAll = FALSE ;
+				verify = FALSE ;
+			}
 		}
 		else if ( 0 == numChanged )
 		{
@@ -262,9 +476,12 @@ BOOL smo_ordinal (smo_Settings * settings)
 
 	} 
 
-	tend() ;
-	settings->smo_timing = tval() ;
+	tend( &(settings->timer) ) ;
+	settings->smo_timing = tval( &(settings->timer) ) + settings->map_timing ;
+	settings->map_timing = 0 ;
 	DURATION += settings->smo_timing ;
+	settings->stats.optimise = twall() - start ;
+	settings->stats.memory = tmemory() ;
 
 	if (TRUE == SMO_DISPLAY)
 	{
@@ -294,7 +511,7 @@ BOOL smo_ordinal (smo_Settings * settings)
 #endif
 		if (loop > 1)
 		{
-			if (settings->biasj[loop-1]+TOL<settings->biasj[loop-2])
+			if (FALSE == settings->abort && settings->biasj[loop-1]+TOL<settings->biasj[loop-2])
 			{
 				printf("Warning: thresholds %lu : %f < thresholds %lu : %f.\n",loop, settings->biasj[loop-1], loop-1, settings->biasj[loop-2]) ;
 				exit(1) ;
@@ -302,7 +519,7 @@ BOOL smo_ordinal (smo_Settings * settings)
 		}
 	}
 	SMO_WORKING = FALSE ;
-	return TRUE ; 
+	return ( TRUE == settings->abort ) ? FALSE : TRUE ; 
 }
 
 BOOL smo_routine (smo_Settings * settings)
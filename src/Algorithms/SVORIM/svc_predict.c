@@ -1,8 +1,18 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <math.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include "smo.h"
 
 
@@ -10,12 +20,13 @@
 BOOL svm_predict ( Data_List * testlist, smo_Settings * settings )
 {	
 	Data_List * trainlist ;
-	Data_Node * trainnode ;
 	Data_Node * testnode ;
-	double fx, kernel, guess = 0 ;
+	double fx, guess = 0 ;
 	double error = 0 ;
-	double alpha ;
 	unsigned int i, j=0, k ;
+	double * x ;
+	double * coef ;
+	double start = twall() ;
 
 	if (testlist == NULL || settings == NULL)
 		return FALSE ;
@@ -26,12 +37,38 @@ BOOL svm_predict ( Data_List * testlist, smo_Settings * settings )
 		return FALSE ;	
 	if (trainlist->dimen != testlist->dimen)
 		return FALSE ;
+	/* test inputs are packed like the rows of MATRIX*/
+	if ( NULL == (x = (double *) malloc((MATRIX.stride + (NULL != settings->fmap ? settings->fmap->input.stride : 0))*sizeof(double))) )
+	{
+		printf("Fatal Error : fail to malloc memory.\n") ;
+		return FALSE ;
+	}
 
 	settings->c1p = 0 ;
 	settings->c1n = 0 ;
 	settings->c2p = 0 ;	
 	settings->c2n = 0 ;		
 	settings->svs = 0 ;
+	/* coefficients of the packed training rows, summed over the thresholds*/
+	if ( NULL == (coef = (double *) malloc(max(MATRIX.count, 1)*sizeof(double))) )
+	{
+		printf("Fatal Error : fail to malloc memory.\n") ;
+		free( x ) ;
+		return FALSE ;
+	}
+	for (j=0;j<MATRIX.count;j++)
+	{
+		coef[j] = 0 ;
+		for (k=0;k<settings->pairs->classes-1;k++)
+		{
+			if (MATRIX.target[j]<=k+1)
+				coef[j] -= (ALPHA+j)->alpha[k] ;
+			else
+				coef[j] += (ALPHA+j)->alpha[k] ;
+		}
+		if ( coef[j] != 0 )
+			settings->svs ++ ;
+	}
 
 	i = 0 ;
 	testnode = testlist->front ;
@@ -49,29 +86,18 @@ BOOL svm_predict ( Data_List * testlist, smo_Settings * settings )
 					testnode->point[k] = 0 ;
 			}
 		}
-		trainnode = trainlist->front ;
-		j = 0 ;
-		while (trainnode!=NULL)
-		{		
-
-			alpha = 0 ;
-			for (k=0;k<settings->pairs->classes-1;k++)
-			{
-				if ((ALPHA+j)->pair->target<=k+1)
-					alpha -= (ALPHA+j)->alpha[k] ;
-				else
-					alpha += (ALPHA+j)->alpha[k] ;
-			}
-			if ( alpha != 0 )
-			{
-				kernel = Calculate_Kernel (trainnode->point, testnode->point, settings) ;				
-				fx = fx + alpha * kernel ;
-				if (i==0)
-					settings->svs ++ ;
-			}
-			trainnode = trainnode->next ;
-			j++ ;
+		if ( NULL != settings->fmap )
+		{
+			Pack_Data_Point( &(settings->fmap->input), testnode->point, x + MATRIX.stride ) ;
+			Map_Data_Point( settings->fmap, x + MATRIX.stride, x ) ;
 		}
+		else
+			Pack_Data_Point( &(MATRIX), testnode->point, x ) ;
+		/* one product with the weight vector of the linear kernel*/
+		if ( NULL != settings->weight )
+			fx = Matrix_Kernel( &(MATRIX), LINEAR, P, settings->weight, x ) ;
+		else
+			fx = KOPS->sum( &(MATRIX), P, x, coef, 0, MATRIX.count, fx ) ;
 		testnode -> fx = fx ;
 		testnode->guess = fx ;
 		
@@ -108,11 +134,756 @@ BOOL svm_predict ( Data_List * testlist, smo_Settings * settings )
 		settings->testrate = 0 ;
 		settings->testerror = 0 ;
 	}	
+	free( coef ) ;
+	free( x ) ;
+	settings->stats.predict = twall() - start ;
+	return TRUE ;
+}
+
+/*******************************************************************************\
+
+	BOOL Create_Svor_Model ( Svor_Model * model, double * sv, double * coef, unsigned long int count, unsigned int dimen, 
+		double * biasj, unsigned int classes, Kernel_Name kernel, double kappa, unsigned int p )
+	
+	pack the samples with non-zero coefficient into a model for prediction. 
+	the inputs are scaled as Create_smo_Settings does without ARD, i.e. with 
+	weights 1/dimen and kappa folded in for the Gaussian kernel, so that the 
+	kernel values are the ones used in training.
+	input:  the pointer to Svor_Model, the count x dimen training inputs stored 
+	        column by column as in MATLAB, their coefficients, the classes-1 
+	        thresholds, the kernel type, kappa and the polynomial order
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Create_Svor_Model ( Svor_Model * model, double * sv, double * coef, unsigned long int count, unsigned int dimen, 
+	double * biasj, unsigned int classes, Kernel_Name kernel, double kappa, unsigned int p )
+{
+	double * point ;
+	unsigned long int i, n = 0 ;
+	unsigned int k ;
+
+	if ( NULL == model || NULL == sv || NULL == coef || NULL == biasj || dimen < 1 || classes < 2 )
+		return FALSE ;
+	model->coef = NULL ;
+	model->biasj = NULL ;
+	model->ard = NULL ;
+	model->x_mean = NULL ;
+	model->x_devi = NULL ;
+	model->map = NULL ;
+	model->mapsize = 0 ;
+	model->classes = classes ;
+	model->kernel = kernel ;
+	model->kappa = kappa ;
+	model->p = p ;
+	for ( i = 0 ; i < count ; i ++ )
+	{
+		if ( 0 != coef[i] )
+			n ++ ;
+	}
+	if ( FALSE == Init_Data_Matrix( &(model->matrix), max(n, 1), dimen, NULL ) )
+		return FALSE ;
+	model->matrix.count = n ;
+	model->coef = (double *) malloc(max(n, 1)*sizeof(double)) ;
+	model->biasj = (double *) malloc((classes-1)*sizeof(double)) ;
+	model->ard = (double *) malloc(dimen*sizeof(double)) ;
+	point = (double *) malloc(dimen*sizeof(double)) ;
+	if ( NULL == model->coef || NULL == model->biasj || NULL == model->ard || NULL == point )
+	{
+		printf("Fatal Error : fail to malloc memory.\n") ;
+		if ( NULL != point )
+			free( point ) ;
+		Clear_Svor_Model( model ) ;
+		return FALSE ;
+	}
+	for ( k = 0 ; k < dimen ; k ++ )
+	{
+		model->ard[k] = 1.0/(double)dimen ;
+		model->matrix.scale[k] = sqrt( (GAUSSIAN == kernel ? kappa : 1.0)/(double)dimen ) ;
+	}
+	model->matrix.scaled = TRUE ;
+	n = 0 ;
+	for ( i = 0 ; i < count ; i ++ )
+	{
+		if ( 0 == coef[i] )
+			continue ;
+		for ( k = 0 ; k < dimen ; k ++ )
+			point[k] = sv[i + k*count] ;
+		Pack_Data_Point( &(model->matrix), point, model->matrix.x + n*model->matrix.stride ) ;
+		model->matrix.target[n] = 0 ;
+		model->matrix.fold[n] = 0 ;
+		model->coef[n] = coef[i] ;
+		n ++ ;
+	}
+	for ( k = 0 ; k < classes - 1 ; k ++ )
+		model->biasj[k] = biasj[k] ;
+	free( point ) ;
+	return TRUE ;
+}
+
+typedef struct _Predict_Task
+{
+	Svor_Model * model ;
+	double * test ;
+	unsigned long int count ;
+	double * fx ;
+	double * guess ;
+	double * weight ;               /* sum of coef*x over the support vectors for the linear kernel, or NULL*/
+	const Kernel_Ops * kops ;
+	BOOL failed ;
+} Predict_Task ;
+
+static void Task_Predict ( void * arg, unsigned long int begin, unsigned long int end, unsigned int block )
+{
+	Predict_Task * task = (Predict_Task *) arg ;
+	Data_Matrix * matrix = &(task->model->matrix) ;
+	double * x, * point ;
+	unsigned long int i, s, send ;
+	unsigned int k ;
+
+	x = (double *) malloc((end-begin)*matrix->stride*sizeof(double)) ;
+	point = (double *) malloc(matrix->dimen*sizeof(double)) ;
+	if ( NULL == x || NULL == point )
+	{
+		task->failed = TRUE ;
+		if ( NULL != x )
+			free( x ) ;
+		if ( NULL != point )
+			free( point ) ;
+		return ;
+	}
+	for ( i = begin ; i < end ; i ++ )
+	{
+		for ( k = 0 ; k < matrix->dimen ; k ++ )
+		{
+			point[k] = task->test[i + k*task->count] ;
+			/* transform input point as the training inputs*/
+			if ( NULL != task->model->x_mean )
+				point[k] = ( 0 != task->model->x_devi[k] ) ? (point[k]-task->model->x_mean[k])/task->model->x_devi[k] : 0 ;
+		}
+		Pack_Data_Point( matrix, point, x + (i-begin)*matrix->stride ) ;
+		task->fx[i] = 0 ;
+		if ( NULL != task->weight )
+			task->fx[i] = Matrix_Kernel( matrix, LINEAR, task->model->p, task->weight, x + (i-begin)*matrix->stride ) ;
+	}
+	/* sweep a block of support vectors over the block of test points, so that 
+	   both stay in cache, keeping the order of the sum for every test point*/
+	for ( s = 0 ; s < matrix->count && NULL == task->weight ; s += SVBLOCK )
+	{
+		send = min( s + SVBLOCK, matrix->count ) ;
+		for ( i = begin ; i < end ; i ++ )
+		{
+			task->fx[i] = task->kops->sum( matrix, task->model->p, x + (i-begin)*matrix->stride, 
+				task->model->coef, s, send, task->fx[i] ) ;
+		}
+	}
+	for ( i = begin ; i < end ; i ++ )
+	{
+		task->guess[i] = 1 ;
+		for ( k = 1 ; k < task->model->classes ; k ++ )
+		{
+			if ( task->fx[i] > task->model->biasj[k-1] )
+				task->guess[i] = k + 1 ;
+			else
+				break ;
+		}
+	}
+	free( x ) ;
+	free( point ) ;
+}
+
+/*******************************************************************************\
+
+	BOOL Predict_Svor_Model ( Svor_Model * model, double * test, unsigned long int count, double * fx, double * guess, Thread_Pool * pool )
+	
+	score the test inputs in blocks of PREDICTBLOCK points, spread over the 
+	thread pool if any, and assign the labels by the thresholds as svm_predict.
+	the linear kernel is scored by one weight vector over the support vectors.
+	input:  the pointer to Svor_Model, the count x dimen test inputs stored 
+	        column by column, the outputs fx and guess of count entries, and the 
+	        thread pool or NULL
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Predict_Svor_Model ( Svor_Model * model, double * test, unsigned long int count, double * fx, double * guess, Thread_Pool * pool )
+{
+	Predict_Task task ;
+	Data_Matrix * matrix ;
+	unsigned long int j ;
+	unsigned int k ;
+
+	if ( NULL == model || NULL == test || NULL == fx || NULL == guess )
+		return FALSE ;
+	matrix = &(model->matrix) ;
+	task.model = model ;
+	task.test = test ;
+	task.count = count ;
+	task.fx = fx ;
+	task.guess = guess ;
+	task.weight = NULL ;
+	task.kops = Get_Kernel_Ops( matrix, model->kernel, model->p ) ;
+	task.failed = FALSE ;
+	if ( ((POLYNOMIAL == model->kernel && model->p <= 1) || LINEAR == model->kernel) && 0 == matrix->cat && count > 0 )
+	{
+		if ( NULL == (task.weight = (double *) calloc(matrix->cont, sizeof(double))) )
+		{
+			printf("Fatal Error : fail to malloc memory.\n") ;
+			return FALSE ;
+		}
+		for ( j = 0 ; j < matrix->count ; j ++ )
+		{
+			for ( k = 0 ; k < matrix->cont ; k ++ )
+				task.weight[k] = task.weight[k] + model->coef[j] * matrix->x[j*matrix->stride + k] ;
+		}
+	}
+	if ( count > 0 )
+		Run_Thread_Pool( pool, count, PREDICTBLOCK, Task_Predict, &task ) ;
+	if ( NULL != task.weight )
+		free( task.weight ) ;
+	if ( TRUE == task.failed )
+	{
+		printf("Fatal Error : fail to malloc memory.\n") ;
+		return FALSE ;
+	}
+	return TRUE ;
+}
+
+void Clear_Svor_Model ( Svor_Model * model )
+{
+	if ( NULL == model )
+		return ;
+	if ( NULL != model->map )
+	{
+		/* all the arrays are in the model file*/
+#ifdef _WIN32
+		_aligned_free( model->map ) ;
+#else
+		munmap( model->map, model->mapsize ) ;
+#endif
+		model->matrix.x = NULL ;
+		model->matrix.column = NULL ;
+		model->matrix.scale = NULL ;
+		model->matrix.weight = NULL ;
+		model->matrix.count = 0 ;
+		model->coef = NULL ;
+		model->biasj = NULL ;
+		model->ard = NULL ;
+		model->x_mean = NULL ;
+		model->x_devi = NULL ;
+		model->map = NULL ;
+		model->mapsize = 0 ;
+		return ;
+	}
+	Clear_Data_Matrix( &(model->matrix) ) ;
+	if ( NULL != model->coef )
+		free( model->coef ) ;
+	if ( NULL != model->biasj )
+		free( model->biasj ) ;
+	if ( NULL != model->ard )
+		free( model->ard ) ;
+	if ( NULL != model->x_mean )
+		free( model->x_mean ) ;
+	if ( NULL != model->x_devi )
+		free( model->x_devi ) ;
+	model->coef = NULL ;
+	model->biasj = NULL ;
+	model->ard = NULL ;
+	model->x_mean = NULL ;
+	model->x_devi = NULL ;
+}
+
+/* the coefficient of the j-th training sample in the function, as in svm_predict*/
+static double Model_Coef ( smo_Settings * settings, unsigned long int j )
+{
+	double alpha = 0 ;
+	unsigned int k ;
+
+	for ( k = 0 ; k < settings->pairs->classes - 1 ; k ++ )
+	{
+		if ( MATRIX.target[j] <= k + 1 )
+			alpha -= (ALPHA+j)->alpha[k] ;
+		else
+			alpha += (ALPHA+j)->alpha[k] ;
+	}
+	return alpha ;
+}
+
+/*******************************************************************************\
+
+	BOOL Settings_Svor_Model ( Svor_Model * model, smo_Settings * settings )
+	
+	copy the support vectors of a trained smo_Settings into a model, i.e. the 
+	rows of MATRIX with non-zero coefficient, which are scaled by ARD and kappa 
+	already, together with the thresholds and the normalization of the inputs.
+	input:  the pointer to Svor_Model and the pointer to smo_Settings
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Settings_Svor_Model ( Svor_Model * model, smo_Settings * settings )
+{
+	Data_List * trainlist ;
+	int * featuretype ;
+	double coef ;
+	unsigned long int j, n = 0 ;
+	unsigned int k ;
+
+	if ( NULL == model || NULL == settings || NULL == ALPHA || NULL == settings->biasj || NULL == MATRIX.x )
+		return FALSE ;
+	if ( NULL != settings->fmap )
+	{
+		printf("Warning : the model of an approximate kernel can not be saved.\n") ;
+		return FALSE ;
+	}
+	trainlist = settings->pairs ;
+	model->matrix.x = NULL ;
+	model->matrix.target = NULL ;
+	model->matrix.fold = NULL ;
+	model->matrix.column = NULL ;
+	model->matrix.scale = NULL ;
+	model->matrix.weight = NULL ;
+	model->coef = NULL ;
+	model->biasj = NULL ;
+	model->ard = NULL ;
+	model->x_mean = NULL ;
+	model->x_devi = NULL ;
+	model->map = NULL ;
+	model->mapsize = 0 ;
+	model->classes = trainlist->classes ;
+	model->kernel = KERNEL ;
+	model->kappa = KAPPA ;
+	model->p = P ;
+	for ( j = 0 ; j < MATRIX.count ; j ++ )
+	{
+		if ( 0 != Model_Coef( settings, j ) )
+			n ++ ;
+	}
+	/* the same layout as MATRIX, the categorical columns are after numeric*/
+	if ( NULL == (featuretype = (int *) calloc(MATRIX.dimen, sizeof(int))) )
+	{
+		printf("Fatal Error : fail to malloc memory.\n") ;
+		return FALSE ;
+	}
+	for ( k = MATRIX.numeric ; k < MATRIX.dimen ; k ++ )
+		featuretype[MATRIX.column[k]] = 1 ;
+	if ( FALSE == Init_Data_Matrix( &(model->matrix), max(n, 1), MATRIX.dimen, featuretype ) )
+	{
+		free( featuretype ) ;
+		return FALSE ;
+	}
+	free( featuretype ) ;
+	model->matrix.count = n ;
+	model->coef = (double *) malloc(max(n, 1)*sizeof(double)) ;
+	model->biasj = (double *) malloc((model->classes-1)*sizeof(double)) ;
+	model->ard = (double *) malloc(MATRIX.dimen*sizeof(double)) ;
+	if ( TRUE == trainlist->normalized_input && NULL != trainlist->x_mean && NULL != trainlist->x_devi )
+	{
+		model->x_mean = (double *) malloc(MATRIX.dimen*sizeof(double)) ;
+		model->x_devi = (double *) malloc(MATRIX.dimen*sizeof(double)) ;
+		if ( NULL == model->x_mean || NULL == model->x_devi )
+		{
+			printf("Fatal Error : fail to malloc memory.\n") ;
+			Clear_Svor_Model( model ) ;
+			return FALSE ;
+		}
+		for ( k = 0 ; k < MATRIX.dimen ; k ++ )
+		{
+			model->x_mean[k] = trainlist->x_mean[k] ;
+			model->x_devi[k] = trainlist->x_devi[k] ;
+		}
+	}
+	if ( NULL == model->coef || NULL == model->biasj || NULL == model->ard )
+	{
+		printf("Fatal Error : fail to malloc memory.\n") ;
+		Clear_Svor_Model( model ) ;
+		return FALSE ;
+	}
+	for ( k = 0 ; k < MATRIX.dimen ; k ++ )
+		model->ard[k] = ( NULL != settings->ard ) ? settings->ard[k] : 1.0/(double)MATRIX.dimen ;
+	for ( k = 0 ; k < MATRIX.cont ; k ++ )
+		model->matrix.scale[k] = MATRIX.scale[k] ;
+	for ( k = 0 ; k < MATRIX.cat ; k ++ )
+		model->matrix.weight[k] = MATRIX.weight[k] ;
+	model->matrix.sumweight = MATRIX.sumweight ;
+	model->matrix.scaled = MATRIX.scaled ;
+	n = 0 ;
+	for ( j = 0 ; j < MATRIX.count ; j ++ )
+	{
+		if ( 0 == (coef = Model_Coef( settings, j )) )
+			continue ;
+		memcpy( model->matrix.x + n*model->matrix.stride, MATRIX.x + j*MATRIX.stride, MATRIX.stride*sizeof(double) ) ;
+		model->matrix.target[n] = MATRIX.target[j] ;
+		model->matrix.fold[n] = MATRIX.fold[j] ;
+		model->coef[n] = coef ;
+		n ++ ;
+	}
+	for ( k = 0 ; k < model->classes - 1 ; k ++ )
+		model->biasj[k] = settings->biasj[k] ;
 	return TRUE ;
 }
 
+/* length in bytes of a section of the model file described by header*/
+static unsigned long long Model_Section_Size ( Model_Header * header, int section )
+{
+	switch ( section )
+	{
+	case MODEL_COLUMN :
+		return (unsigned long long) header->dimen * sizeof(unsigned int) ;
+	case MODEL_SCALE :
+		return (unsigned long long) header->cont * sizeof(double) ;
+	case MODEL_WEIGHT :
+		return (unsigned long long) header->cat * sizeof(double) ;
+	case MODEL_ARD :
+		return (unsigned long long) header->dimen * sizeof(double) ;
+	case MODEL_MEAN :
+	case MODEL_DEVI :
+		return ( 0 != header->normalized ) ? (unsigned long long) header->dimen * sizeof(double) : 0 ;
+	case MODEL_BIASJ :
+		return (unsigned long long) (header->classes - 1) * sizeof(double) ;
+	case MODEL_COEF :
+		return header->count * sizeof(double) ;
+	case MODEL_X :
+		return header->count * header->stride * sizeof(double) ;
+	default :
+		return 0 ;
+	}
+}
+
+/*******************************************************************************\
+
+	BOOL Save_Svor_Model ( Svor_Model * model, char * filename )
+	
+	write the model into a binary file: Model_Header followed by the sections 
+	listed in Model_Section, each one starting at a multiple of MODELALIGN, so 
+	that Load_Svor_Model can use them in place. the numbers are written in the 
+	native byte order, which is recorded in the header.
+	input:  the pointer to Svor_Model and the name of the model file
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Save_Svor_Model ( Svor_Model * model, char * filename )
+{
+	Model_Header header ;
+	void * section[MODEL_SECTIONS] ;
+	char pad[MODELALIGN] ;
+	unsigned long long pos, len ;
+	BOOL ok ;
+	FILE * fid ;
+	int s ;
+
+	if ( NULL == model || NULL == filename || NULL == model->matrix.column || NULL == model->coef || NULL == model->biasj )
+		return FALSE ;
+	memset( &header, 0, sizeof(Model_Header) ) ;
+	memset( pad, 0, MODELALIGN ) ;
+	memcpy( header.magic, MODEL_MAGIC, sizeof(header.magic) ) ;
+	header.version = MODEL_VERSION ;
+	header.order = MODEL_ORDER ;
+	header.kernel = (unsigned int) model->kernel ;
+	header.p = model->p ;
+	header.classes = model->classes ;
+	header.dimen = model->matrix.dimen ;
+	header.numeric = model->matrix.numeric ;
+	header.cont = model->matrix.cont ;
+	header.cat = model->matrix.cat ;
+	header.stride = model->matrix.stride ;
+	header.normalized = ( NULL != model->x_mean && NULL != model->x_devi ) ? 1 : 0 ;
+	header.kappa = model->kappa ;
+	header.sumweight = model->matrix.sumweight ;
+	header.count = model->matrix.count ;
+
+	section[MODEL_COLUMN] = model->matrix.column ;
+	section[MODEL_SCALE] = model->matrix.scale ;
+	section[MODEL_WEIGHT] = model->matrix.weight ;
+	section[MODEL_ARD] = model->ard ;
+	section[MODEL_MEAN] = model->x_mean ;
+	section[MODEL_DEVI] = model->x_devi ;
+	section[MODEL_BIASJ] = model->biasj ;
+	section[MODEL_COEF] = model->coef ;
+	section[MODEL_X] = model->matrix.x ;
+	pos = sizeof(Model_Header) ;
+	for ( s = 0 ; s < MODEL_SECTIONS ; s ++ )
+	{
+		if ( NULL == section[s] && Model_Section_Size( &header, s ) > 0 )
+			return FALSE ;
+		pos = ((pos + MODELALIGN - 1)/MODELALIGN)*MODELALIGN ;
+		header.offset[s] = pos ;
+		pos += Model_Section_Size( &header, s ) ;
+	}
+	header.size = pos ;
+
+	if ( NULL == (fid = fopen( filename, "wb" )) )
+	{
+		printf("Fail to open the model file %s.\n", filename) ;
+		return FALSE ;
+	}
+	ok = ( 1 == fwrite( &header, sizeof(Model_Header), 1, fid ) ) ? TRUE : FALSE ;
+	pos = sizeof(Model_Header) ;
+	for ( s = 0 ; s < MODEL_SECTIONS && TRUE == ok ; s ++ )
+	{
+		len = header.offset[s] - pos ;
+		if ( len > 0 && len != fwrite( pad, 1, (size_t) len, fid ) )
+			ok = FALSE ;
+		len = Model_Section_Size( &header, s ) ;
+		if ( len > 0 && len != fwrite( section[s], 1, (size_t) len, fid ) )
+			ok = FALSE ;
+		pos = header.offset[s] + len ;
+	}
+	if ( 0 != fclose( fid ) )
+		ok = FALSE ;
+	if ( FALSE == ok )
+		printf("Fail to write the model file %s.\n", filename) ;
+	return ok ;
+}
 
-struct estructura svm_saveresults_Matlab(Data_List * testlist, smo_Settings * settings)
+/* check a header against the length of the model file*/
+static BOOL Check_Model_Header ( Model_Header * header, unsigned long long size )
+{
+	unsigned long long len ;
+	int s ;
+
+	if ( 0 != memcmp( header->magic, MODEL_MAGIC, sizeof(header->magic) ) )
+	{
+		printf("Error : this is not a model file.\n") ;
+		return FALSE ;
+	}
+	if ( MODEL_ORDER != header->order )
+	{
+		printf("Error : the model file was saved in another byte order.\n") ;
+		return FALSE ;
+	}
+	if ( header->version < 1 || header->version > MODEL_VERSION )
+	{
+		printf("Error : the version %u of the model file is not supported (at most %d).\n", header->version, MODEL_VERSION) ;
+		return FALSE ;
+	}
+	if ( header->size != size || header->count > size/sizeof(double) )
+	{
+		printf("Error : the model file is truncated.\n") ;
+		return FALSE ;
+	}
+	if ( header->kernel > LINEAR || header->classes < 2 || header->dimen < 1 || header->numeric > header->dimen 
+		|| header->cont != ((header->numeric + ROWALIGN - 1)/ROWALIGN)*ROWALIGN
+		|| header->cat != ((header->dimen - header->numeric + ROWALIGN - 1)/ROWALIGN)*ROWALIGN
+		|| header->stride != header->cont + header->cat )
+	{
+		printf("Error : the model file is inconsistent.\n") ;
+		return FALSE ;
+	}
+	for ( s = 0 ; s < MODEL_SECTIONS ; s ++ )
+	{
+		len = Model_Section_Size( header, s ) ;
+		if ( 0 != header->offset[s] % MODELALIGN || header->offset[s] < sizeof(Model_Header) 
+			|| header->offset[s] > size || len > size - header->offset[s] )
+		{
+			printf("Error : the model file is truncated.\n") ;
+			return FALSE ;
+		}
+	}
+	return TRUE ;
+}
+
+/*******************************************************************************\
+
+	BOOL Load_Svor_Model ( Svor_Model * model, char * filename )
+	
+	map a model file written by Save_Svor_Model into memory, and point the 
+	arrays of the model into the mapping, without copying them. the mapping 
+	is released by Clear_Svor_Model. without mmap, i.e. on Windows, the file 
+	is read into one aligned block instead.
+	input:  the pointer to Svor_Model and the name of the model file
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Load_Svor_Model ( Svor_Model * model, char * filename )
+{
+	Model_Header * header ;
+	char * map = NULL ;
+	unsigned long long size = 0 ;
+	unsigned int k ;
+#ifdef _WIN32
+	FILE * fid ;
+	long end ;
+#else
+	struct stat st ;
+	int fd ;
+#endif
+
+	if ( NULL == model || NULL == filename )
+		return FALSE ;
+	model->matrix.x = NULL ;
+	model->matrix.target = NULL ;
+	model->matrix.fold = NULL ;
+	model->matrix.column = NULL ;
+	model->matrix.scale = NULL ;
+	model->matrix.weight = NULL ;
+	model->matrix.count = 0 ;
+	model->coef = NULL ;
+	model->biasj = NULL ;
+	model->ard = NULL ;
+	model->x_mean = NULL ;
+	model->x_devi = NULL ;
+	model->map = NULL ;
+	model->mapsize = 0 ;
+#ifdef _WIN32
+	if ( NULL != (fid = fopen( filename, "rb" )) )
+	{
+		if ( 0 == fseek( fid, 0, SEEK_END ) && (end = ftell( fid )) >= (long) sizeof(Model_Header) && 0 == fseek( fid, 0, SEEK_SET ) )
+		{
+			size = (unsigned long long) end ;
+			map = (char *) _aligned_malloc( (size_t) size, MODELALIGN ) ;
+			if ( NULL != map && (size_t) size != fread( map, 1, (size_t) size, fid ) )
+			{
+				_aligned_free( map ) ;
+				map = NULL ;
+			}
+		}
+		fclose( fid ) ;
+	}
+#else
+	if ( -1 != (fd = open( filename, O_RDONLY )) )
+	{
+		if ( 0 == fstat( fd, &st ) && st.st_size >= (off_t) sizeof(Model_Header) )
+		{
+			size = (unsigned long long) st.st_size ;
+			map = (char *) mmap( NULL, (size_t) size, PROT_READ, MAP_SHARED, fd, 0 ) ;
+			if ( MAP_FAILED == (void *) map )
+				map = NULL ;
+		}
+		close( fd ) ;
+	}
+#endif
+	if ( NULL == map )
+	{
+		printf("Fail to load the model file %s.\n", filename) ;
+		return FALSE ;
+	}
+	model->map = map ;
+	model->mapsize = (unsigned long int) size ;
+	header = (Model_Header *) map ;
+	if ( FALSE == Check_Model_Header( header, size ) )
+	{
+		Clear_Svor_Model( model ) ;
+		return FALSE ;
+	}
+
+	model->classes = header->classes ;
+	model->kernel = (Kernel_Name) header->kernel ;
+	model->kappa = header->kappa ;
+	model->p = header->p ;
+	model->matrix.count = (unsigned long int) header->count ;
+	model->matrix.dimen = header->dimen ;
+	model->matrix.numeric = header->numeric ;
+	model->matrix.cont = header->cont ;
+	model->matrix.cat = header->cat ;
+	model->matrix.stride = header->stride ;
+	model->matrix.sumweight = header->sumweight ;
+	model->matrix.scaled = TRUE ;
+	model->matrix.column = (unsigned int *) (map + header->offset[MODEL_COLUMN]) ;
+	model->matrix.scale = (double *) (map + header->offset[MODEL_SCALE]) ;
+	model->matrix.weight = (double *) (map + header->offset[MODEL_WEIGHT]) ;
+	model->matrix.x = (double *) (map + header->offset[MODEL_X]) ;
+	model->ard = (double *) (map + header->offset[MODEL_ARD]) ;
+	if ( 0 != header->normalized )
+	{
+		model->x_mean = (double *) (map + header->offset[MODEL_MEAN]) ;
+		model->x_devi = (double *) (map + header->offset[MODEL_DEVI]) ;
+	}
+	model->biasj = (double *) (map + header->offset[MODEL_BIASJ]) ;
+	model->coef = (double *) (map + header->offset[MODEL_COEF]) ;
+	for ( k = 0 ; k < header->dimen ; k ++ )
+	{
+		if ( model->matrix.column[k] >= header->dimen )
+		{
+			printf("Error : the model file is inconsistent.\n") ;
+			Clear_Svor_Model( model ) ;
+			return FALSE ;
+		}
+	}
+	return TRUE ;
+}
+
+/*******************************************************************************\
+
+	BOOL svm_predict_model ( Data_List * testlist, Svor_Model * model, Thread_Pool * pool, double * testerror, double * testrate )
+	
+	predict the samples of testlist with a model, e.g. loaded from a model 
+	file, and save fx and guess in the nodes as svm_predict does.
+	input:  the pointer to the test Data_List, the model, the thread pool or 
+	        NULL, and the outputs for the rate of errors and the mean absolute 
+	        error, either one may be NULL
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL svm_predict_model ( Data_List * testlist, Svor_Model * model, Thread_Pool * pool, double * testerror, double * testrate )
+{
+	Data_Node * testnode ;
+	double * test, * fx, * guess ;
+	double error = 0, aae = 0 ;
+	unsigned long int i, count ;
+	unsigned int k ;
+	BOOL ok ;
+
+	if ( NULL == testlist || NULL == model )
+		return FALSE ;
+	if ( TRUE == Is_Data_Empty(testlist) || testlist->dimen != model->matrix.dimen )
+		return FALSE ;
+	count = testlist->count ;
+	test = (double *) malloc(count*testlist->dimen*sizeof(double)) ;
+	fx = (double *) malloc(count*sizeof(double)) ;
+	guess = (double *) malloc(count*sizeof(double)) ;
+	if ( NULL == test || NULL == fx || NULL == guess )
+	{
+		printf("Fatal Error : fail to malloc memory.\n") ;
+		ok = FALSE ;
+	}
+	else
+	{
+		/* column by column, as Predict_Svor_Model takes them*/
+		i = 0 ;
+		testnode = testlist->front ;
+		while ( NULL != testnode && i < count )
+		{
+			for ( k = 0 ; k < testlist->dimen ; k ++ )
+				test[i + k*count] = testnode->point[k] ;
+			testnode = testnode->next ;
+			i ++ ;
+		}
+		ok = Predict_Svor_Model( model, test, count, fx, guess, pool ) ;
+	}
+	if ( TRUE == ok )
+	{
+		i = 0 ;
+		testnode = testlist->front ;
+		while ( NULL != testnode && i < count )
+		{
+			testnode->fx = fx[i] ;
+			testnode->guess = guess[i] ;
+			aae += fabs(testnode->guess-testnode->target) ;
+			if (fabs(testnode->guess-testnode->target)>0.5)
+				error += 1.0 ;
+			testnode = testnode->next ;
+			i ++ ;
+		}
+		if ( NULL != testerror )
+			*testerror = error/count ; /*error number*/
+		if ( NULL != testrate )
+			*testrate = aae/count ; /*aae error*/
+	}
+	if ( NULL != test )
+		free( test ) ;
+	if ( NULL != fx )
+		free( fx ) ;
+	if ( NULL != guess )
+		free( guess ) ;
+	return ok ;
+}
+
+
+struct estructura svm_saveresults_Matlab(Data_List * testlist, smo_Settings * settings, BOOL projection)
 {
 
 	Data_Node * testnode ;
@@ -145,7 +916,9 @@ struct estructura svm_saveresults_Matlab(Data_List * testlist, smo_Settings * se
 		aux.dim2=testlist->count;
 		aux.n_alpha=settings->pairs->count;
 		aux.n_threshold= settings->pairs->classes - 1;
-		aux.n_pairs=settings->pairs->count;
+		/* the training projection is read from f_cache, only if it is asked for */
+		aux.n_pairs=(TRUE==projection)?settings->pairs->count:0;
+		aux.guess=NULL;
 
 		if ( (aux.data2=(double *)malloc(testlist->count*sizeof(double))) == NULL)
 		{
@@ -166,7 +939,13 @@ struct estructura svm_saveresults_Matlab(Data_List * testlist, smo_Settings * se
 			exit(-1);
 		}
 
-		if ( (aux.guess=(double *)malloc(settings->pairs->count*sizeof(double))) == NULL)
+		if ( TRUE == projection && (aux.guess=(double *)malloc(settings->pairs->count*sizeof(double))) == NULL)
+		{
+			printf("Error al reservar memoria\n");
+			exit(-1);
+		}
+
+		if ( (aux.alphas=(double *)malloc(settings->pairs->count*(settings->pairs->classes-1)*sizeof(double))) == NULL)
 		{
 			printf("Error al reservar memoria\n");
 			exit(-1);
@@ -290,6 +1069,7 @@ struct estructura svm_saveresults_Matlab(Data_List * testlist, smo_Settings * se
 					alpha -= (ALPHA+i)->alpha[k] ;
 				else
 					alpha += (ALPHA+i)->alpha[k] ;
+				aux.alphas[i+k*settings->pairs->count]=(ALPHA+i)->alpha[k];
 			}
 			/*fprintf(svmalpha,"%.12f\r", alpha) ;*/
 			aux.alpha[i]=alpha;
@@ -316,7 +1096,7 @@ struct estructura svm_saveresults_Matlab(Data_List * testlist, smo_Settings * se
 	//printf("\nFunction values: TRAIN SVM CONF\n");
 
 
-	for (i = 0; i < settings->pairs->count; i ++)
+	for (i = 0; i < aux.n_pairs; i ++)
 		{			
 			(settings->alpha + i)->pair->guess = (settings->alpha + i)->f_cache ;	
 			/*fprintf(svmfunc,"%.12f\r", fabs((settings->alpha + i)->pair->guess)) ;*/
@@ -333,7 +1113,7 @@ struct estructura svm_saveresults_Matlab(Data_List * testlist, smo_Settings * se
 	temp = 0 ;
 	/*if ( NULL != svmresu )	
 	{*/
-		for (i = 0; i < settings->pairs->count; i ++)
+		for (i = 0; i < aux.n_pairs; i ++)
 		{
 			if (ORDINAL == settings->pairs->datatype)
 			{
@@ -396,66 +1176,41 @@ struct estructura svm_saveresults_Matlab(Data_List * testlist, smo_Settings * se
 /////////////////////////////////////////////
 //////////////////////////////////////////////
 
-BOOL svm_saveresults ( Data_List * testlist, smo_Settings * settings )
+/*******************************************************************************\
+
+	BOOL svm_saveguess ( Data_List * testlist, char * inputfile )
+	
+	save the predictive labels and the function values of the test samples, 
+	in cguess files named after inputfile.
+	input:  the pointer to the test Data_List and the name of training file
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL svm_saveguess ( Data_List * testlist, char * inputfile )
 {
 	Data_Node * testnode ;
-	unsigned int i, result, k ;
+	unsigned int i, result ;
 	char buf[1000] = "" ;
 	char * pstr ;
-	double temp ;
-	double alpha ;
 	FILE * guess_file = NULL ;
-	FILE * svmfunc = NULL ;
-	FILE * svmalpha = NULL ;
-	FILE * svmresu = NULL ;	
 	FILE * testfunc = NULL ;
-	FILE * svmweight = NULL ;
-	
-	if (testlist == NULL || settings == NULL)
-		return FALSE ;
-	
-	if (TRUE == Is_Data_Empty(testlist))
-		return FALSE ;	
-	if (settings->pairs->dimen != testlist->dimen)
-		return FALSE ;
 
-	strcpy (buf, INPUTFILE) ;
-	strcat (buf,".svm.conf") ;
-	svmfunc = fopen( buf, "w+t" ) ; 	
-	printf("FUNCTION VALUES for training data have been saved in %s.\n",buf) ;
-	
-	strcpy (buf, INPUTFILE) ;
-	strcat (buf,".svm.alpha") ;
-	svmalpha = fopen( buf, "w+t" ) ;
-	printf("ALPHAS have been saved in %s.\n",buf) ;
-	
-	strcpy (buf, INPUTFILE) ;
-	strcat (buf,".svm.resu") ;
-	svmresu = fopen( buf, "w+t" ) ;
-	//printf("FUNCTION VALUES for training data have been saved in %s.\n",buf) ;
-
-	if ((POLYNOMIAL==KERNEL && 1==P) || LINEAR==KERNEL )
-	{
-		strcpy (buf, INPUTFILE) ;
-		strcat (buf,".svm.weight") ;
-		svmweight = fopen( buf, "w+t" ) ;
-		printf("LINEAR WEIGHTS have been saved in %s.\n",buf) ;
-	}
+	if (testlist == NULL || inputfile == NULL)
+		return FALSE ;
 
-	if (testlist != settings->pairs)
-	{
-	pstr = strstr( INPUTFILE, "train" ) ;
+	pstr = strstr( inputfile, "train" ) ;
 	if (NULL != pstr)
 	{
-		result = abs( INPUTFILE - pstr ) ;
-		strncpy (buf, INPUTFILE, result ) ;
+		result = abs( inputfile - pstr ) ;
+		strncpy (buf, inputfile, result ) ;
 		buf[result] = '\0' ;
 		strcat(buf, "cguess") ;
 		strcat (buf, pstr+5) ;
 	}
 	else
 	{
-		strcpy (buf, INPUTFILE) ;
+		strcpy (buf, inputfile) ;
 		strcat (buf,".test.resu") ;
 	}
 	guess_file = fopen( buf, "w+t" ) ;	
@@ -484,7 +1239,57 @@ BOOL svm_saveresults ( Data_List * testlist, smo_Settings * settings )
 	}
 	if (i!=testlist->count)
 		printf("Error : in the data list for TESTING.\r\n") ;	
+	if (NULL != guess_file)
+		fclose(guess_file) ;
+	if (NULL != testfunc)
+		fclose(testfunc) ;
+	return TRUE ;
+}
+
+BOOL svm_saveresults ( Data_List * testlist, smo_Settings * settings )
+{
+	unsigned int i, result, k ;
+	char buf[1000] = "" ;
+	double temp ;
+	double alpha ;
+	FILE * svmfunc = NULL ;
+	FILE * svmalpha = NULL ;
+	FILE * svmresu = NULL ;	
+	FILE * svmweight = NULL ;
+	
+	if (testlist == NULL || settings == NULL)
+		return FALSE ;
+	
+	if (TRUE == Is_Data_Empty(testlist))
+		return FALSE ;	
+	if (settings->pairs->dimen != testlist->dimen)
+		return FALSE ;
+
+	strcpy (buf, INPUTFILE) ;
+	strcat (buf,".svm.conf") ;
+	svmfunc = fopen( buf, "w+t" ) ; 	
+	printf("FUNCTION VALUES for training data have been saved in %s.\n",buf) ;
+	
+	strcpy (buf, INPUTFILE) ;
+	strcat (buf,".svm.alpha") ;
+	svmalpha = fopen( buf, "w+t" ) ;
+	printf("ALPHAS have been saved in %s.\n",buf) ;
+	
+	strcpy (buf, INPUTFILE) ;
+	strcat (buf,".svm.resu") ;
+	svmresu = fopen( buf, "w+t" ) ;
+	//printf("FUNCTION VALUES for training data have been saved in %s.\n",buf) ;
+
+	if ((POLYNOMIAL==KERNEL && 1==P) || LINEAR==KERNEL )
+	{
+		strcpy (buf, INPUTFILE) ;
+		strcat (buf,".svm.weight") ;
+		svmweight = fopen( buf, "w+t" ) ;
+		printf("LINEAR WEIGHTS have been saved in %s.\n",buf) ;
 	}
+
+	if (testlist != settings->pairs)
+		svm_saveguess( testlist, INPUTFILE ) ;
 				
 	if ( NULL != svmalpha )	
 	{
@@ -557,17 +1362,59 @@ BOOL svm_saveresults ( Data_List * testlist, smo_Settings * settings )
 			fprintf(svmweight,"%.12f\r", temp) ;
 		}
 	}
-	if (NULL != guess_file)
-		fclose(guess_file) ;
 	if (NULL != svmresu)
 		fclose(svmresu) ;
 	if (NULL != svmalpha)
 		fclose(svmalpha) ;
 	if (NULL != svmfunc)
 		fclose(svmfunc) ;
-	if (NULL != testfunc)
-		fclose(testfunc) ;
 	if (NULL != svmweight)
 		fclose(svmweight) ;
 	return TRUE ;
 }
+
+/*******************************************************************************\
+
+	BOOL Save_Smo_Stats ( smo_Settings * settings, char * filename )
+
+	save the counters and the wall times of the solver as one JSON object.
+	input:  the pointer to smo_Settings and the name of the file
+	output: TRUE or FALSE
+
+\*******************************************************************************/
+
+BOOL Save_Smo_Stats ( smo_Settings * settings, char * filename )
+{
+	Smo_Stats * stats ;
+	unsigned long int i ;
+	FILE * fid ;
+
+	if (NULL == settings || NULL == filename)
+		return FALSE ;
+	if (NULL == (fid = fopen(filename, "w")))
+	{
+		printf("Error : fail to open %s.\n", filename) ;
+		return FALSE ;
+	}
+	stats = &(settings->stats) ;
+	fprintf(fid, "{\n") ;
+	fprintf(fid, "\t\"precomputed\": %lu,\n", stats->precomputed) ;
+	fprintf(fid, "\t\"kernels\": %lu,\n", stats->kernels) ;
+	fprintf(fid, "\t\"hits\": %lu,\n", stats->hits) ;
+	fprintf(fid, "\t\"misses\": %lu,\n", stats->misses) ;
+	fprintf(fid, "\t\"accepted\": %lu,\n", stats->accepted) ;
+	fprintf(fid, "\t\"rejected\": %lu,\n", stats->rejected) ;
+	fprintf(fid, "\t\"sweeps\": %lu,\n", stats->sweeps) ;
+	fprintf(fid, "\t\"io_peak\": %lu,\n", stats->io_peak) ;
+	fprintf(fid, "\t\"io\": [") ;
+	for (i = 0; i < stats->io_count; i ++)
+		fprintf(fid, "%s%lu", (i > 0) ? ", " : "", stats->io[i]) ;
+	fprintf(fid, "],\n") ;
+	fprintf(fid, "\t\"precompute\": %.6f,\n", stats->precompute) ;
+	fprintf(fid, "\t\"optimise\": %.6f,\n", stats->optimise) ;
+	fprintf(fid, "\t\"predict\": %.6f,\n", stats->predict) ;
+	fprintf(fid, "\t\"memory\": %.3f\n", stats->memory) ;
+	fprintf(fid, "}\n") ;
+	fclose(fid) ;
+	return TRUE ;
+}
@@ -50,14 +50,22 @@ classdef SVORLin < Algorithm
             if isempty(strfind(path,obj.algorithmMexPath))
                 addpath(obj.algorithmMexPath);
             end
-            [alpha, thresholds, projectedTrain] = svorim([train.patterns train.targets],1,parameters.C,0,0,1);
-            predictedTrain = obj.assignLabels(projectedTrain, thresholds);
-            model.projection = alpha;
+            % the projection of the training patterns is only returned
+            % when the caller asks for it
+            if nargout > 0
+                [alpha, thresholds, projectedTrain] = svorim([train.patterns train.targets],1,parameters.C,0,0,1,1,[],1);
+                predictedTrain = obj.assignLabels(projectedTrain, thresholds);
+                projectedTrain = projectedTrain';
+            else
+                [alpha, thresholds] = svorim([train.patterns train.targets],1,parameters.C,0,0,1);
+            end
+            % only the support vectors are needed for prediction
+            sv = alpha ~= 0;
+            model.projection = alpha(sv);
             model.thresholds = thresholds;
             model.parameters = parameters;
-            model.train = train.patterns;
+            model.train = train.patterns(sv,:);
             obj.model = model;
-            projectedTrain = projectedTrain';
             if ~isempty(strfind(path,obj.algorithmMexPath))
                 rmpath(obj.algorithmMexPath);
             end
@@ -65,11 +73,13 @@ classdef SVORLin < Algorithm
         
         function [projected, predicted] = privpredict(obj, test)
             %PREDICT predicts labels of TEST patterns labels. The object needs to be fitted to the data first.
-            kernelMatrix = computeKernelMatrix(obj.model.train',test','linear',1);
-            projected = obj.model.projection*kernelMatrix;
-            
-            predicted = SVORLin.assignLabels(projected, obj.model.thresholds);
-            projected = projected';
+            if isempty(strfind(path,obj.algorithmMexPath))
+                addpath(obj.algorithmMexPath);
+            end
+            [projected, predicted] = svorimpredict(obj.model.train, obj.model.projection, obj.model.thresholds, test, 1, 1);
+            if ~isempty(strfind(path,obj.algorithmMexPath))
+                rmpath(obj.algorithmMexPath);
+            end
         end
     end
     methods (Static = true)        
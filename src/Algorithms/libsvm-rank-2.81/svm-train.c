@@ -32,10 +32,12 @@ void exit_with_help()
 	"-r coef0 : set coef0 in kernel function (default 0)\n"
 	"-c cost : set the parameter C of C-SVC, epsilon-SVR, and nu-SVR (default 1)\n"
 	"-n nu : set the parameter nu of nu-SVC, one-class SVM, and nu-SVR (default 0.5)\n"
+	"-nt threads : set the number of threads for the kernel columns (default 1)\n"
 	"-p epsilon : set the epsilon in loss function of epsilon-SVR (default 0.1)\n"
 	"-m cachesize : set cache memory size in MB (default 100)\n"
 	"-e epsilon : set tolerance of termination criterion (default 0.001)\n"
 	"-h shrinking: whether to use the shrinking heuristics, 0 or 1 (default 1)\n"
+	"-a wss: working set selection, 1 (first order) or 2 (second order) (default 1 for SVORIM, 2 otherwise)\n"
 	"-b probability_estimates: whether to train a SVC or SVR model for probability estimates, 0 or 1 (default 0)\n"
 	"-wi weight: set the parameter C of class i to weight*C, for C-SVC (default 1)\n"
 	"-v n: n-fold cross validation mode\n"
@@ -151,6 +153,7 @@ void do_cross_validation()
 void parse_command_line(int argc, char **argv, char *input_file_name, char *model_file_name)
 {
 	int i;
+	int nr_thread = 1;	// serial
 
 	// default values
 	param.svm_type = C_SVC;
@@ -164,6 +167,7 @@ void parse_command_line(int argc, char **argv, char *input_file_name, char *mode
 	param.eps = 1e-3;
 	param.p = 0.1;
 	param.shrinking = 1;
+	param.wss = 0;	// 1 for SVORIM, 2 otherwise
 	param.probability = 0;
 	param.nr_weight = 0;
 	param.weight_label = NULL;
@@ -194,7 +198,10 @@ void parse_command_line(int argc, char **argv, char *input_file_name, char *mode
 				param.coef0 = atof(argv[i]);
 				break;
 			case 'n':
-				param.nu = atof(argv[i]);
+				if(argv[i-1][2] == 't')
+					nr_thread = atoi(argv[i]);
+				else
+					param.nu = atof(argv[i]);
 				break;
 			case 'm':
 				param.cache_size = atof(argv[i]);
@@ -211,6 +218,9 @@ void parse_command_line(int argc, char **argv, char *input_file_name, char *mode
 			case 'h':
 				param.shrinking = atoi(argv[i]);
 				break;
+			case 'a':
+				param.wss = atoi(argv[i]);
+				break;
 			case 'b':
 				param.probability = atoi(argv[i]);
 				break;
@@ -239,6 +249,11 @@ void parse_command_line(int argc, char **argv, char *input_file_name, char *mode
 		}
 	}
 
+	if(param.wss == 0)
+		param.wss = (param.svm_type == SVORIM) ? 1 : 2;
+
+	svm_set_num_threads(nr_thread);
+
 	// determine filenames
 
 	if(i>=argc)
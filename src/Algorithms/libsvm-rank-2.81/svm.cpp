@@ -8,6 +8,13 @@
 #include <limits.h>
 #include <locale.h>
 #include "svm.h"
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
 int libsvm_version = LIBSVM_VERSION;
 typedef float Qfloat;
 typedef signed char schar;
@@ -184,6 +191,277 @@ void Cache::swap_index(int i, int j)
 	}
 }
 
+//
+// Thread pool for the kernel columns
+//
+// nr_thread-1 workers wait for a job, and the caller of run works with them.
+// A job [start,end) is cut into one block per thread. Without pthreads
+// (_WIN32), no workers are started and jobs run in the caller.
+// The number of threads is set by svm_set_num_threads, 1 by default.
+//
+#define PARALLEL_MIN 65536	// smallest column part times features filled in parallel
+
+static int svm_nr_thread = 1;
+
+class Thread_Pool
+{
+public:
+	Thread_Pool(int nr_thread);
+	~Thread_Pool();
+	int size() const { return nr_thread; }
+	static int max_size();
+	// task(arg,begin,end) on the blocks of [start,end), waiting for all of them
+	void run(void (*task)(void *, int, int), void *arg, int start, int end);
+private:
+	int nr_thread;		// workers started plus the caller
+#ifndef _WIN32
+	struct worker_t
+	{
+		Thread_Pool *pool;
+		int id;
+		pthread_t thread;
+	};
+	worker_t *workers;
+	pthread_mutex_t lock;
+	pthread_cond_t start_cond;
+	pthread_cond_t done_cond;
+	unsigned long generation;	// incremented for every job
+	int running;		// workers still busy with the job
+	bool quit;
+
+	void (*task)(void *, int, int);	// the current job
+	void *arg;
+	int start, end;
+
+	void run_block(int id);
+	static void *loop(void *ptr);
+#endif
+};
+
+// the online CPUs, the most threads worth starting
+int Thread_Pool::max_size()
+{
+#ifdef _WIN32
+	return 1;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n < 1) ? 1 : (int)min(n,(long)INT_MAX);
+#endif
+}
+
+#ifdef _WIN32
+Thread_Pool::Thread_Pool(int)
+{
+	info("threads are not supported, running serially\n");
+	nr_thread = 1;
+}
+
+Thread_Pool::~Thread_Pool()
+{
+}
+
+void Thread_Pool::run(void (*task_)(void *, int, int), void *arg_, int start_, int end_)
+{
+	task_(arg_,start_,end_);
+}
+#else
+Thread_Pool::Thread_Pool(int nr_thread_)
+{
+	nr_thread_ = min(nr_thread_,max_size());
+	pthread_mutex_init(&lock,NULL);
+	pthread_cond_init(&start_cond,NULL);
+	pthread_cond_init(&done_cond,NULL);
+	generation = 0;
+	running = 0;
+	quit = false;
+
+	nr_thread = 1;
+	workers = new worker_t[max(nr_thread_-1,1)];
+	for(int t=0;t<nr_thread_-1;t++)
+	{
+		workers[t].pool = this;
+		workers[t].id = t+1;
+		if(pthread_create(&workers[t].thread,NULL,loop,&workers[t]) != 0)
+		{
+			info("only %d threads are started\n",nr_thread);
+			break;
+		}
+		nr_thread++;
+	}
+}
+
+Thread_Pool::~Thread_Pool()
+{
+	pthread_mutex_lock(&lock);
+	quit = true;
+	pthread_cond_broadcast(&start_cond);
+	pthread_mutex_unlock(&lock);
+	for(int t=0;t<nr_thread-1;t++)
+		pthread_join(workers[t].thread,NULL);
+	pthread_mutex_destroy(&lock);
+	pthread_cond_destroy(&start_cond);
+	pthread_cond_destroy(&done_cond);
+	delete[] workers;
+}
+
+void Thread_Pool::run_block(int id)
+{
+	size_t n = (size_t)(end-start);
+	int begin = start + (int)(n*(size_t)id/(size_t)nr_thread);
+	int stop = start + (int)(n*(size_t)(id+1)/(size_t)nr_thread);
+	if(begin < stop)
+		task(arg,begin,stop);
+}
+
+void *Thread_Pool::loop(void *ptr)
+{
+	worker_t *worker = (worker_t *)ptr;
+	Thread_Pool *pool = worker->pool;
+	unsigned long generation = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	while(true)
+	{
+		while(!pool->quit && generation == pool->generation)
+			pthread_cond_wait(&pool->start_cond,&pool->lock);
+		if(pool->quit)
+			break;
+		generation = pool->generation;
+		pthread_mutex_unlock(&pool->lock);
+
+		pool->run_block(worker->id);
+
+		pthread_mutex_lock(&pool->lock);
+		if(--pool->running == 0)
+			pthread_cond_signal(&pool->done_cond);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+void Thread_Pool::run(void (*task_)(void *, int, int), void *arg_, int start_, int end_)
+{
+	if(nr_thread == 1)
+	{
+		task_(arg_,start_,end_);
+		return;
+	}
+
+	pthread_mutex_lock(&lock);
+	task = task_;
+	arg = arg_;
+	start = start_;
+	end = end_;
+	running = nr_thread-1;
+	generation++;
+	pthread_cond_broadcast(&start_cond);
+	pthread_mutex_unlock(&lock);
+
+	run_block(0);
+
+	pthread_mutex_lock(&lock);
+	while(running > 0)
+		pthread_cond_wait(&done_cond,&lock);
+	pthread_mutex_unlock(&lock);
+}
+#endif
+
+//
+// Dense rows for the kernel
+//
+// when most features are nonzero the training instances are also kept as
+// contiguous rows of dense_len values, a multiple of DENSE_ALIGN padded with
+// zeros, so the inner loops below have no remainder. AVX-512 or AVX2 is used
+// if the compiler targets it, e.g. with -march=native, otherwise plain loops
+// that add in the same order as the sparse dot and dist_1.
+//
+#define DENSE_ALIGN 8
+#define DENSE_RATIO 0.5	// smallest fraction of nonzero features for dense rows
+
+#if defined(__AVX512F__)
+
+static inline double sum_pd(__m512d v)
+{
+	double t[8];
+	_mm512_storeu_pd(t,v);
+	return ((t[0]+t[1])+(t[2]+t[3]))+((t[4]+t[5])+(t[6]+t[7]));
+}
+
+static double dense_dot(const double *a, const double *b, int n)
+{
+	__m512d acc = _mm512_setzero_pd();
+	for(int k=0;k<n;k+=8)
+		acc = _mm512_fmadd_pd(_mm512_loadu_pd(a+k),_mm512_loadu_pd(b+k),acc);
+	return sum_pd(acc);
+}
+
+static double dense_dist_1(const double *a, const double *b, int n)
+{
+	__m512d acc = _mm512_setzero_pd();
+	for(int k=0;k<n;k+=8)
+		acc = _mm512_add_pd(acc,_mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(a+k),_mm512_loadu_pd(b+k))));
+	return sum_pd(acc);
+}
+
+#elif defined(__AVX2__)
+
+#ifdef __FMA__
+#define FMADD_PD(a,b,c) _mm256_fmadd_pd(a,b,c)
+#else
+#define FMADD_PD(a,b,c) _mm256_add_pd(_mm256_mul_pd(a,b),c)
+#endif
+
+static inline double sum_pd(__m256d v)
+{
+	__m128d s = _mm_add_pd(_mm256_castpd256_pd128(v),_mm256_extractf128_pd(v,1));
+	return _mm_cvtsd_f64(s) + _mm_cvtsd_f64(_mm_unpackhi_pd(s,s));
+}
+
+static double dense_dot(const double *a, const double *b, int n)
+{
+	__m256d acc0 = _mm256_setzero_pd();
+	__m256d acc1 = _mm256_setzero_pd();
+	for(int k=0;k<n;k+=8)
+	{
+		acc0 = FMADD_PD(_mm256_loadu_pd(a+k),_mm256_loadu_pd(b+k),acc0);
+		acc1 = FMADD_PD(_mm256_loadu_pd(a+k+4),_mm256_loadu_pd(b+k+4),acc1);
+	}
+	return sum_pd(_mm256_add_pd(acc0,acc1));
+}
+
+static double dense_dist_1(const double *a, const double *b, int n)
+{
+	const __m256d sign = _mm256_set1_pd(-0.0);
+	__m256d acc0 = _mm256_setzero_pd();
+	__m256d acc1 = _mm256_setzero_pd();
+	for(int k=0;k<n;k+=8)
+	{
+		acc0 = _mm256_add_pd(acc0,_mm256_andnot_pd(sign,_mm256_sub_pd(_mm256_loadu_pd(a+k),_mm256_loadu_pd(b+k))));
+		acc1 = _mm256_add_pd(acc1,_mm256_andnot_pd(sign,_mm256_sub_pd(_mm256_loadu_pd(a+k+4),_mm256_loadu_pd(b+k+4))));
+	}
+	return sum_pd(_mm256_add_pd(acc0,acc1));
+}
+
+#else
+
+static double dense_dot(const double *a, const double *b, int n)
+{
+	double sum = 0;
+	for(int k=0;k<n;k++)
+		sum += a[k] * b[k];
+	return sum;
+}
+
+static double dense_dist_1(const double *a, const double *b, int n)
+{
+	double sum = 0;
+	for(int k=0;k<n;k++)
+		sum += fabs(a[k] - b[k]);
+	return sum;
+}
+
+#endif
+
 //
 // Kernel evaluation
 //
@@ -191,11 +469,23 @@ void Cache::swap_index(int i, int j)
 // the constructor of Kernel prepares to calculate the l*l kernel matrix
 // the member function get_Q is for getting one column from the Q Matrix
 //
+// a matrix with a block structure (RNK_Q) repeats each kernel row over several
+// variables, Q_ij = sign_i * sign_j * (K(index_i,index_j) + th_cost [phase_i == phase_j]);
+// its get_Q returns the kernel row indexed by sample and get_block the structure
+//
+struct QBlock {
+	const int *index;
+	const schar *sign;
+	const schar *phase;
+	double th_cost;
+};
+
 class QMatrix {
 public:
 	virtual Qfloat *get_Q(int column, int len) const = 0;
 	virtual double *get_QD() const = 0;
 	virtual void swap_index(int i, int j) const = 0;
+	virtual const QBlock *get_block() const { return NULL; }
 	virtual ~QMatrix() {}
 };
 
@@ -211,15 +501,32 @@ public:
 	virtual void swap_index(int i, int j) const	// no so const...
 	{
 		swap(x[i],x[j]);
+		if(xd) swap(xd[i],xd[j]);
 		if(x_square) swap(x_square[i],x_square[j]);
 	}
 protected:
 
 	double (Kernel::*kernel_function)(int i, int j) const;
 
+	// data[j] = K(i,j) for start <= j < end
+	void kernel_row(int i, Qfloat *data, int start, int end) const;
+
 private:
 	const svm_node **x;
 	double *x_square;
+	Thread_Pool *pool;	// NULL if the columns are filled serially
+	int min_parallel;	// shortest column part filled by the pool
+
+	struct kernel_row_job
+	{
+		const Kernel *kernel;
+		int i;
+		Qfloat *data;
+	};
+	static void kernel_row_task(void *arg, int begin, int end);
+	const double **xd;	// dense rows, NULL on the sparse path
+	double *xd_space;
+	int dense_len;
 
 	// svm_parameter
 	const int kernel_type;
@@ -236,6 +543,7 @@ private:
 		double sum = x_square[i]+x_square[j]-2*dot(x[i],x[j]);
 		return (sum > 0.0 ? sum : 0.0);
 	}
+	bool make_dense(int l);
 	double kernel_linear(int i, int j) const
 	{
 		return dot(x[i],x[j]);
@@ -272,59 +580,174 @@ private:
 	{
 		return x[i][(int)(x[j][0].value)].value;
 	}
+
+	// the same kernels on the dense rows
+	inline double dist_2_sqr_dense(int i, int j) const
+	{
+		double sum = x_square[i]+x_square[j]-2*dense_dot(xd[i],xd[j],dense_len);
+		return (sum > 0.0 ? sum : 0.0);
+	}
+	double kernel_linear_dense(int i, int j) const
+	{
+		return dense_dot(xd[i],xd[j],dense_len);
+	}
+	double kernel_poly_dense(int i, int j) const
+	{
+		return pow(gamma*dense_dot(xd[i],xd[j],dense_len)+coef0,degree);
+	}
+	double kernel_rbf_dense(int i, int j) const
+	{
+		return exp(-gamma*dist_2_sqr_dense(i, j));
+	}
+	double kernel_sigmoid_dense(int i, int j) const
+	{
+		return tanh(gamma*dense_dot(xd[i],xd[j],dense_len)+coef0);
+	}
+	double kernel_stump_dense(int i, int j) const
+	{
+		return -dense_dist_1(xd[i],xd[j],dense_len)+coef0;
+	}
+	double kernel_perc_dense(int i, int j) const
+	{
+		return -sqrt(dist_2_sqr_dense(i, j))+coef0;
+	}
+	double kernel_laplace_dense(int i, int j) const
+	{
+		return exp(-gamma*dense_dist_1(xd[i],xd[j],dense_len));
+	}
+	double kernel_expo_dense(int i, int j) const
+	{
+		return exp(-gamma*sqrt(dist_2_sqr_dense(i, j)));
+	}
 };
 
 Kernel::Kernel(int l, svm_node * const * x_, const svm_parameter& param)
 :kernel_type(param.kernel_type), degree(param.degree),
  gamma(param.gamma), coef0(param.coef0)
 {
+	clone(x,x_,l);
+
+	bool dense = (kernel_type != PRECOMPUTED && make_dense(l));
+
 	switch(kernel_type)
 	{
 		case LINEAR:
-			kernel_function = &Kernel::kernel_linear;
+			kernel_function = dense ? &Kernel::kernel_linear_dense : &Kernel::kernel_linear;
 			break;
 		case POLY:
-			kernel_function = &Kernel::kernel_poly;
+			kernel_function = dense ? &Kernel::kernel_poly_dense : &Kernel::kernel_poly;
 			break;
 		case RBF:
-			kernel_function = &Kernel::kernel_rbf;
+			kernel_function = dense ? &Kernel::kernel_rbf_dense : &Kernel::kernel_rbf;
 			break;
 		case SIGMOID:
-			kernel_function = &Kernel::kernel_sigmoid;
+			kernel_function = dense ? &Kernel::kernel_sigmoid_dense : &Kernel::kernel_sigmoid;
 			break;
 		case STUMP:
-			kernel_function = &Kernel::kernel_stump;
+			kernel_function = dense ? &Kernel::kernel_stump_dense : &Kernel::kernel_stump;
 			break;
 		case PERC:
-			kernel_function = &Kernel::kernel_perc;
+			kernel_function = dense ? &Kernel::kernel_perc_dense : &Kernel::kernel_perc;
 			break;
 		case LAPLACE:
-			kernel_function = &Kernel::kernel_laplace;
+			kernel_function = dense ? &Kernel::kernel_laplace_dense : &Kernel::kernel_laplace;
 			break;
 		case EXPO:
-			kernel_function = &Kernel::kernel_expo;
+			kernel_function = dense ? &Kernel::kernel_expo_dense : &Kernel::kernel_expo;
 			break;
 		case PRECOMPUTED:
 			kernel_function = &Kernel::kernel_precomputed;
 			break;
 	}
 
-	clone(x,x_,l);
-
 	if(kernel_type == RBF || kernel_type == PERC || kernel_type == EXPO)
 	{
 		x_square = new double[l];
 		for(int i=0;i<l;i++)
-			x_square[i] = dot(x[i],x[i]);
+			x_square[i] = dense ? dense_dot(xd[i],xd[i],dense_len) : dot(x[i],x[i]);
 	}
 	else
 		x_square = 0;
+
+	pool = NULL;
+	min_parallel = INT_MAX;
+	if(svm_nr_thread > 1)
+	{
+		double nnz = 0;
+		for(int i=0;i<l;i++)
+			for(const svm_node *px=x[i];px->index!=-1;px++)
+				nnz++;
+		pool = new Thread_Pool(svm_nr_thread);
+		min_parallel = (int)min((double)INT_MAX,max(1.0,(double)PARALLEL_MIN*l/max(nnz,1.0)));
+	}
+}
+
+// copy the instances to dense rows if at least DENSE_RATIO of the features
+// are nonzero, aligned for the SIMD loops; return false to stay sparse
+bool Kernel::make_dense(int l)
+{
+	xd = NULL;
+	xd_space = NULL;
+	dense_len = 0;
+
+	int i, max_index = 0;
+	double nnz = 0;
+	for(i=0;i<l;i++)
+		for(const svm_node *p=x[i];p->index!=-1;p++)
+		{
+			if(p->index < 1)
+				return false;
+			if(p->index > max_index)
+				max_index = p->index;
+			nnz++;
+		}
+	if(max_index == 0 || nnz < DENSE_RATIO*l*max_index)
+		return false;
+
+	dense_len = (max_index+DENSE_ALIGN-1)/DENSE_ALIGN*DENSE_ALIGN;
+	xd_space = new double[(size_t)l*dense_len+DENSE_ALIGN];
+	memset(xd_space,0,sizeof(double)*((size_t)l*dense_len+DENSE_ALIGN));
+	double *row = xd_space;
+	while((size_t)row % (DENSE_ALIGN*sizeof(double)))
+		row++;
+
+	xd = new const double*[l];
+	for(i=0;i<l;i++,row+=dense_len)
+	{
+		for(const svm_node *p=x[i];p->index!=-1;p++)
+			row[p->index-1] = p->value;
+		xd[i] = row;
+	}
+	return true;
 }
 
 Kernel::~Kernel()
 {
 	delete[] x;
 	delete[] x_square;
+	delete[] xd;
+	delete[] xd_space;
+	delete pool;
+}
+
+void Kernel::kernel_row_task(void *arg, int begin, int end)
+{
+	kernel_row_job *job = (kernel_row_job *)arg;
+	const Kernel *kernel = job->kernel;
+	for(int j=begin;j<end;j++)
+		job->data[j] = (Qfloat)(kernel->*(kernel->kernel_function))(job->i,j);
+}
+
+void Kernel::kernel_row(int i, Qfloat *data, int start, int end) const
+{
+	if(end-start < min_parallel)
+	{
+		for(int j=start;j<end;j++)
+			data[j] = (Qfloat)(this->*kernel_function)(i,j);
+		return;
+	}
+	kernel_row_job job = { this, i, data };
+	pool->run(kernel_row_task,&job,start,end);
 }
 
 double Kernel::dot(const svm_node *px, const svm_node *py)
@@ -477,7 +900,7 @@ double Kernel::k_function(const svm_node *x, const svm_node *y,
 //
 class Solver {
 public:
-	Solver() {};
+	Solver(int _wss = 2) { wss = _wss; };
 	virtual ~Solver() {};
 
 	struct SolutionInfo {
@@ -507,6 +930,20 @@ protected:
 	double *G_bar;		// gradient, if we treat free variables as 0
 	int l;
 	bool unshrinked;	// XXX
+	int wss;		// working set selection, 1: first order, 2: second order
+	const QBlock *block;	// NULL unless Q has a block structure
+
+	// Q_ij from the column Q_i returned by get_Q
+	Qfloat Q_entry(const Qfloat *Q_i, int i, int j) const
+	{
+		if(block == NULL)
+			return Q_i[j];
+		double value = Q_i[block->index[j]];
+		if(block->phase[j] == block->phase[i])
+			value += block->th_cost;
+		return (Qfloat)(block->sign[i] * block->sign[j] * value);
+	}
+	void add_Q(const Qfloat *Q_i, int i, double c, double *out, int start, int end) const;
 
 	double get_C(int i)
 	{
@@ -544,6 +981,32 @@ void Solver::swap_index(int i, int j)
 	swap(G_bar[i],G_bar[j]);
 }
 
+// out[k] += c * Q_ik for start <= k < end
+void Solver::add_Q(const Qfloat *Q_i, int i, double c, double *out, int start, int end) const
+{
+	int k;
+	if(block == NULL)
+	{
+		for(k=start;k<end;k++)
+			out[k] += c * Q_i[k];
+		return;
+	}
+
+	const int *index = block->index;
+	const schar *sign = block->sign;
+	const schar *phase = block->phase;
+	schar p_i = phase[i];
+	double th_cost = block->th_cost;
+	c *= sign[i];
+	for(k=start;k<end;k++)
+	{
+		double value = Q_i[index[k]];
+		if(phase[k] == p_i)
+			value += th_cost;
+		out[k] += sign[k] * (c * (Qfloat)value);
+	}
+}
+
 void Solver::reconstruct_gradient()
 {
 	// reconstruct inactive elements of G from G_bar and free variables
@@ -570,19 +1033,14 @@ void Solver::reconstruct_gradient()
 			const Qfloat *Q_i = Q->get_Q(i,active_size);
 			for(j=0;j<active_size;j++)
 				if(is_free(j))
-					G[i] += alpha[j] * Q_i[j];
+					G[i] += alpha[j] * Q_entry(Q_i,i,j);
 		}
 	}
 	else
 	{
 		for(i=0;i<active_size;i++)
 			if(is_free(i))
-			{
-				const Qfloat *Q_i = Q->get_Q(i,l);
-				double alpha_i = alpha[i];
-				for(j=active_size;j<l;j++)
-					G[j] += alpha_i * Q_i[j];
-			}
+				add_Q(Q->get_Q(i,l),i,alpha[i],G,active_size,l);
 	}
 }
 
@@ -593,6 +1051,7 @@ void Solver::Solve(int l, const QMatrix& Q, const double *b_, const schar *y_,
 	this->l = l;
 	this->Q = &Q;
 	QD=Q.get_QD();
+	block = Q.get_block();
 	clone(b, b_,l);
 	clone(y, y_,l);
 	clone(alpha,alpha_,l);
@@ -630,13 +1089,9 @@ void Solver::Solve(int l, const QMatrix& Q, const double *b_, const schar *y_,
 			if(!is_lower_bound(i))
 			{
 				const Qfloat *Q_i = Q.get_Q(i,l);
-				double alpha_i = alpha[i];
-				int j;
-				for(j=0;j<l;j++)
-					G[j] += alpha_i*Q_i[j];
+				add_Q(Q_i,i,alpha[i],G,0,l);
 				if(is_upper_bound(i))
-					for(j=0;j<l;j++)
-						G_bar[j] += get_C(i) * Q_i[j];
+					add_Q(Q_i,i,get_C(i),G_bar,0,l);
 			}
 	}
 
@@ -684,9 +1139,11 @@ void Solver::Solve(int l, const QMatrix& Q, const double *b_, const schar *y_,
 		double old_alpha_i = alpha[i];
 		double old_alpha_j = alpha[j];
 
+		double Q_ij = Q_entry(Q_i,i,j);
+
 		if(y[i]!=y[j])
 		{
-			double quad_coef = QD[i]+QD[j]+2*Q_i[j];
+			double quad_coef = QD[i]+QD[j]+2*Q_ij;
 			if (quad_coef <= 0)
 				quad_coef = TAU;
 			double delta = (-G[i]-G[j])/quad_coef;
@@ -729,7 +1186,7 @@ void Solver::Solve(int l, const QMatrix& Q, const double *b_, const schar *y_,
 		}
 		else
 		{
-			double quad_coef = QD[i]+QD[j]-2*Q_i[j];
+			double quad_coef = QD[i]+QD[j]-2*Q_ij;
 			if (quad_coef <= 0)
 				quad_coef = TAU;
 			double delta = (G[i]-G[j])/quad_coef;
@@ -776,9 +1233,36 @@ void Solver::Solve(int l, const QMatrix& Q, const double *b_, const schar *y_,
 		double delta_alpha_i = alpha[i] - old_alpha_i;
 		double delta_alpha_j = alpha[j] - old_alpha_j;
 		
-		for(int k=0;k<active_size;k++)
+		if(block == NULL)
 		{
-			G[k] += Q_i[k]*delta_alpha_i + Q_j[k]*delta_alpha_j;
+			for(int k=0;k<active_size;k++)
+			{
+				G[k] += Q_i[k]*delta_alpha_i + Q_j[k]*delta_alpha_j;
+			}
+		}
+		else
+		{
+			// one pass over both kernel rows, the signs of i and j
+			// folded into the steps
+			const int *index = block->index;
+			const schar *sign = block->sign;
+			const schar *phase = block->phase;
+			schar p_i = phase[i];
+			schar p_j = phase[j];
+			double th_cost = block->th_cost;
+			double d_i = sign[i] * delta_alpha_i;
+			double d_j = sign[j] * delta_alpha_j;
+			for(int k=0;k<active_size;k++)
+			{
+				int r = index[k];
+				double v_i = Q_i[r];
+				double v_j = Q_j[r];
+				if(phase[k] == p_i)
+					v_i += th_cost;
+				if(phase[k] == p_j)
+					v_j += th_cost;
+				G[k] += sign[k] * ((Qfloat)v_i * d_i + (Qfloat)v_j * d_j);
+			}
 		}
 
 		// update alpha_status and G_bar
@@ -788,28 +1272,11 @@ void Solver::Solve(int l, const QMatrix& Q, const double *b_, const schar *y_,
 			bool uj = is_upper_bound(j);
 			update_alpha_status(i);
 			update_alpha_status(j);
-			int k;
 			if(ui != is_upper_bound(i))
-			{
-				Q_i = Q.get_Q(i,l);
-				if(ui)
-					for(k=0;k<l;k++)
-						G_bar[k] -= C_i * Q_i[k];
-				else
-					for(k=0;k<l;k++)
-						G_bar[k] += C_i * Q_i[k];
-			}
+				add_Q(Q.get_Q(i,l),i,ui ? -C_i : C_i,G_bar,0,l);
 
 			if(uj != is_upper_bound(j))
-			{
-				Q_j = Q.get_Q(j,l);
-				if(uj)
-					for(k=0;k<l;k++)
-						G_bar[k] -= C_j * Q_j[k];
-				else
-					for(k=0;k<l;k++)
-						G_bar[k] += C_j * Q_j[k];
-			}
+				add_Q(Q.get_Q(j,l),j,uj ? -C_j : C_j,G_bar,0,l);
 		}
 	}
 
@@ -875,10 +1342,12 @@ int Solver::select_working_set(int &out_i, int &out_j)
 	// j: minimizes the decrease of obj value
 	//    (if quadratic coefficeint <= 0, replace it with tau)
 	//    -y_j*grad(f)_j < -y_i*grad(f)_i, j in I_low(\alpha)
+	// with wss == 1, j maximizes y_j*grad(f)_j instead (maximal violating pair)
 	
 	double Gmax = -INF;
 	double Gmax2 = -INF;
 	int Gmax_idx = -1;
+	int Gmax2_idx = -1;
 	int Gmin_idx = -1;
 	double obj_diff_min = INF;
 
@@ -904,7 +1373,7 @@ int Solver::select_working_set(int &out_i, int &out_j)
 
 	int i = Gmax_idx;
 	const Qfloat *Q_i = NULL;
-	if(i != -1) // NULL Q_i not accessed: Gmax=-INF if i=-1
+	if(i != -1 && wss == 2) // NULL Q_i not accessed: Gmax=-INF if i=-1
 		Q_i = Q->get_Q(i,active_size);
 
 	for(int j=0;j<active_size;j++)
@@ -915,11 +1384,14 @@ int Solver::select_working_set(int &out_i, int &out_j)
 			{
 				double grad_diff=Gmax+G[j];
 				if (G[j] >= Gmax2)
+				{
 					Gmax2 = G[j];
-				if (grad_diff > 0)
+					Gmax2_idx = j;
+				}
+				if (grad_diff > 0 && wss == 2)
 				{
 					double obj_diff; 
-					double quad_coef = QD[i]+QD[j]-2.0*y[i]*Q_i[j];
+					double quad_coef = QD[i]+QD[j]-2.0*y[i]*Q_entry(Q_i,i,j);
 					if (quad_coef > 0)
 						obj_diff = -(grad_diff*grad_diff)/quad_coef;
 					else
@@ -939,11 +1411,14 @@ int Solver::select_working_set(int &out_i, int &out_j)
 			{
 				double grad_diff= Gmax-G[j];
 				if (-G[j] >= Gmax2)
+				{
 					Gmax2 = -G[j];
-				if (grad_diff > 0)
+					Gmax2_idx = j;
+				}
+				if (grad_diff > 0 && wss == 2)
 				{
 					double obj_diff; 
-					double quad_coef = QD[i]+QD[j]+2.0*y[i]*Q_i[j];
+					double quad_coef = QD[i]+QD[j]+2.0*y[i]*Q_entry(Q_i,i,j);
 					if (quad_coef > 0)
 						obj_diff = -(grad_diff*grad_diff)/quad_coef;
 					else
@@ -963,7 +1438,7 @@ int Solver::select_working_set(int &out_i, int &out_j)
 		return 1;
 
 	out_i = Gmax_idx;
-	out_j = Gmin_idx;
+	out_j = (wss == 2)? Gmin_idx : Gmax2_idx;
 	return 0;
 }
 
@@ -1091,66 +1566,86 @@ double Solver::calculate_rho()
 //
 // additional constraints: y[idx]^T \alpha[idx] = 0, where idx = (0:(l-1)) * M + j
 //
+// the variables of threshold j are those whose original index is j modulo M,
+// so the groups are taken from active_set and survive the swaps of shrinking
+//
 class Solver_SVORIM : public Solver
 {
 private:
   int nr_thres;
+  double *Gmax1;	// max { -grad(f)_i * d | y_i*d = +1 } per group
+  double *Gmax2;	// max { -grad(f)_i * d | y_i*d = -1 } per group
+  int *Gmax1_idx;
+  int *Gmax2_idx;
+  int min_active;	// the smallest active set, for the report
 public:
   double* th; // lazy public
-  Solver_SVORIM(const int _nr_thres) { nr_thres = _nr_thres; th = new double[nr_thres];}
-  ~Solver_SVORIM() { delete th; }
+  Solver_SVORIM(const int _nr_thres, int _wss = 1) : Solver(_wss)
+  {
+    nr_thres = _nr_thres;
+    th = new double[nr_thres];
+    Gmax1 = new double[nr_thres];
+    Gmax2 = new double[nr_thres];
+    Gmax1_idx = new int[nr_thres];
+    Gmax2_idx = new int[nr_thres];
+  }
+  ~Solver_SVORIM()
+  {
+    delete[] th;
+    delete[] Gmax1;
+    delete[] Gmax2;
+    delete[] Gmax1_idx;
+    delete[] Gmax2_idx;
+  }
   void Solve(int l, const QMatrix& Q, const double *b, const schar *y,
 	     double *alpha, double Cp, double Cn, double eps,
 	     SolutionInfo* si, int shrinking){
-    Solver::Solve(l,Q,b,y,alpha,Cp,Cn,eps,si,0); // don't do shrinking -- otherwise needs more complicated select_working_set
+    min_active = l;
+    Solver::Solve(l,Q,b,y,alpha,Cp,Cn,eps,si,shrinking);
+    if(shrinking)
+      info("smallest active set = %d of %d\n",min_active,l);
   }
 
   int select_working_set(int& out_i, int& out_j);
   double calculate_rho();
+private:
+  int group(int i) const { return active_set[i] % nr_thres; }
+  void find_violating();
+  bool be_shrunk(int i, double Gmax_up, double Gmax_low);
+  void do_shrinking();
 };
 
-//copied from LIBSVM 2.4 (first order selection)
-int Solver_SVORIM::select_working_set(int &out_i, int &out_j)
+// the maximal violating pair of every group over the active set, in one pass
+void Solver_SVORIM::find_violating()
 {
-	// return i,j which maximize -grad(f)^T d , under constraint
-	// if alpha_i == C, d != +1
-	// if alpha_i == 0, d != -1
-
-	if(active_size != l){
-		return 0;
+	int k;
+	for(k=0;k<nr_thres;k++)
+	{
+		Gmax1[k] = -INF;
+		Gmax2[k] = -INF;
+		Gmax1_idx[k] = -1;
+		Gmax2_idx[k] = -1;
 	}
 
-	double Gdiff = -INF;
-	int G1_idx = -1;
-	int G2_idx = -1;
-
-	for(int k=0;k<nr_thres;k++){
-
-	double Gmax1 = -INF;		// max { -grad(f)_i * d | y_i*d = +1 }
-	int Gmax1_idx = -1;
-
-	double Gmax2 = -INF;		// max { -grad(f)_i * d | y_i*d = -1 }
-	int Gmax2_idx = -1;
-
-
-	for(int i=k;i<l;i+=nr_thres) //only consider things in the same group
+	for(int i=0;i<active_size;i++)
 	{
+		k = group(i);
 		if(y[i]==+1)	// y = +1
 		{
 			if(!is_upper_bound(i))	// d = +1
 			{
-				if(-G[i] > Gmax1)
+				if(-G[i] > Gmax1[k])
 				{
-					Gmax1 = -G[i];
-					Gmax1_idx = i;
+					Gmax1[k] = -G[i];
+					Gmax1_idx[k] = i;
 				}
 			}
 			if(!is_lower_bound(i))	// d = -1
 			{
-				if(G[i] > Gmax2)
+				if(G[i] > Gmax2[k])
 				{
-					Gmax2 = G[i];
-					Gmax2_idx = i;
+					Gmax2[k] = G[i];
+					Gmax2_idx[k] = i;
 				}
 			}
 		}
@@ -1158,80 +1653,205 @@ int Solver_SVORIM::select_working_set(int &out_i, int &out_j)
 		{
 			if(!is_upper_bound(i))	// d = +1
 			{
-				if(-G[i] > Gmax2)
+				if(-G[i] > Gmax2[k])
 				{
-					Gmax2 = -G[i];
-					Gmax2_idx = i;
+					Gmax2[k] = -G[i];
+					Gmax2_idx[k] = i;
 				}
 			}
 			if(!is_lower_bound(i))	// d = -1
 			{
-				if(G[i] > Gmax1)
+				if(G[i] > Gmax1[k])
 				{
-					Gmax1 = G[i];
-					Gmax1_idx = i;
+					Gmax1[k] = G[i];
+					Gmax1_idx[k] = i;
 				}
 			}
 		}
 	}
+}
 
-	if (Gmax1+Gmax2 > Gdiff){
-	  G1_idx = Gmax1_idx;
-	  G2_idx = Gmax2_idx;
-	  Gdiff = Gmax1+Gmax2;
-	}
+//copied from LIBSVM 2.4 (first order selection)
+int Solver_SVORIM::select_working_set(int &out_i, int &out_j)
+{
+	// return i,j which maximize -grad(f)^T d , under constraint
+	// if alpha_i == C, d != +1
+	// if alpha_i == 0, d != -1
+	// with i and j in the same group
+	//
+	// with wss == 2, i is kept and j is chosen in the group of i
+	// as in Solver::select_working_set (second order selection)
 
-	}//end of for r
+	double Gdiff = -INF;
+	int G1_idx = -1;
+	int G2_idx = -1;
+	int g = -1;
+
+	find_violating();
+	for(int k=0;k<nr_thres;k++)
+		if (Gmax1[k]+Gmax2[k] > Gdiff){
+		  G1_idx = Gmax1_idx[k];
+		  G2_idx = Gmax2_idx[k];
+		  Gdiff = Gmax1[k]+Gmax2[k];
+		  g = k;
+		}
 
 	if(Gdiff < eps)
  		return 1;
 
+	if(wss == 2)
+	{
+		int i = G1_idx;
+		double Gmax = Gmax1[g];
+		double obj_diff_min = INF;
+		const Qfloat *Q_i = Q->get_Q(i,active_size);
+
+		for(int j=0;j<active_size;j++)
+		{
+			if(group(j) != g)
+				continue;
+			double grad_diff;
+			double quad_coef;
+			if(y[j]==+1)
+			{
+				if(is_lower_bound(j))
+					continue;
+				grad_diff = Gmax+G[j];
+				quad_coef = QD[i]+QD[j]-2.0*y[i]*Q_entry(Q_i,i,j);
+			}
+			else
+			{
+				if(is_upper_bound(j))
+					continue;
+				grad_diff = Gmax-G[j];
+				quad_coef = QD[i]+QD[j]+2.0*y[i]*Q_entry(Q_i,i,j);
+			}
+			if(grad_diff > 0)
+			{
+				double obj_diff;
+				if(quad_coef > 0)
+					obj_diff = -(grad_diff*grad_diff)/quad_coef;
+				else
+					obj_diff = -(grad_diff*grad_diff)/TAU;
+
+				if(obj_diff <= obj_diff_min)
+				{
+					G2_idx = j;
+					obj_diff_min = obj_diff;
+				}
+			}
+		}
+	}
+
 	out_i = G1_idx;
 	out_j = G2_idx;
 	return 0;  
 }
 
-double Solver_SVORIM::calculate_rho(){
-  if(active_size != l){
-    return 0;
-  }
+bool Solver_SVORIM::be_shrunk(int i, double Gmax_up, double Gmax_low)
+{
+	if(is_upper_bound(i))
+	{
+		if(y[i]==+1)
+			return(-G[i] > Gmax_up);
+		else
+			return(-G[i] > Gmax_low);
+	}
+	else if(is_lower_bound(i))
+	{
+		if(y[i]==+1)
+			return(G[i] > Gmax_low);
+		else	
+			return(G[i] > Gmax_up);
+	}
+	else
+		return(false);
+}
 
-  for(int k=0;k<nr_thres;k++){
-	double r;
-	int nr_free = 0;
-	double ub = INF, lb = -INF, sum_free = 0;
-	for(int i=k;i<l;i+=nr_thres)
+// as Solver::do_shrinking, with the bounds of the group of each variable
+void Solver_SVORIM::do_shrinking()
+{
+	int i, k;
+	double Gdiff = -INF;
+
+	find_violating();
+	for(k=0;k<nr_thres;k++)
+		Gdiff = max(Gdiff, Gmax1[k]+Gmax2[k]);
+
+	if(unshrinked == false && Gdiff <= eps*10) 
 	{
-		double yG = y[i]*G[i];
+		unshrinked = true;
+		reconstruct_gradient();
+		active_size = l;
+		info("*");
+	}
 
-		if(is_lower_bound(i))
-		{
-			if(y[i] > 0)
-				ub = min(ub,yG);
-			else
-				lb = max(lb,yG);
-		}
-		else if(is_upper_bound(i))
+	for(i=0;i<active_size;i++)
+		if (be_shrunk(i, Gmax1[group(i)], Gmax2[group(i)]))
 		{
-			if(y[i] < 0)
-				ub = min(ub,yG);
-			else
-				lb = max(lb,yG);
+			active_size--;
+			while (active_size > i)
+			{
+				if (!be_shrunk(active_size, Gmax1[group(active_size)], Gmax2[group(active_size)]))
+				{
+					swap_index(i,active_size);
+					break;
+				}
+				active_size--;
+			}
 		}
+	min_active = min(min_active, active_size);
+}
+
+double Solver_SVORIM::calculate_rho(){
+  int k;
+  int *nr_free = new int[nr_thres];
+  double *ub = new double[nr_thres];
+  double *lb = new double[nr_thres];
+  double *sum_free = new double[nr_thres];
+
+  for(k=0;k<nr_thres;k++){
+	nr_free[k] = 0;
+	ub[k] = INF;
+	lb[k] = -INF;
+	sum_free[k] = 0;
+  }
+  for(int i=0;i<active_size;i++)
+  {
+	double yG = y[i]*G[i];
+
+	k = group(i);
+	if(is_lower_bound(i))
+	{
+		if(y[i] > 0)
+			ub[k] = min(ub[k],yG);
 		else
-		{
-			++nr_free;
-			sum_free += yG;
-		}
+			lb[k] = max(lb[k],yG);
+	}
+	else if(is_upper_bound(i))
+	{
+		if(y[i] < 0)
+			ub[k] = min(ub[k],yG);
+		else
+			lb[k] = max(lb[k],yG);
 	}
-
-	if(nr_free>0)
-		r = sum_free/nr_free;
 	else
-		r = (ub+lb)/2;
-	th[k] = r;
+	{
+		++nr_free[k];
+		sum_free[k] += yG;
+	}
+  }
+  for(k=0;k<nr_thres;k++){
+	if(nr_free[k]>0)
+		th[k] = sum_free[k]/nr_free[k];
+	else
+		th[k] = (ub[k]+lb[k])/2;
   }
-  
+
+  delete[] nr_free;
+  delete[] ub;
+  delete[] lb;
+  delete[] sum_free;
   return 0;
 }
 
@@ -1516,8 +2136,10 @@ public:
 		int start, j;
 		if((start = cache->get_data(i,&data,len)) < len)
 		{
+			kernel_row(i,data,start,len);
 			for(j=start;j<len;j++)
-				data[j] = (Qfloat)(y[i]*y[j]*(this->*kernel_function)(i,j));
+				if(y[i] != y[j])
+					data[j] = -data[j];
 		}
 		return data;
 	}
@@ -1562,12 +2184,9 @@ public:
 	Qfloat *get_Q(int i, int len) const
 	{
 		Qfloat *data;
-		int start, j;
+		int start;
 		if((start = cache->get_data(i,&data,len)) < len)
-		{
-			for(j=start;j<len;j++)
-				data[j] = (Qfloat)(this->*kernel_function)(i,j);
-		}
+			kernel_row(i,data,start,len);
 		return data;
 	}
 
@@ -1630,10 +2249,7 @@ public:
 		Qfloat *data;
 		int j, real_i = index[i];
 		if(cache->get_data(real_i,&data,l) < l)
-		{
-			for(j=0;j<l;j++)
-				data[j] = (Qfloat)(this->*kernel_function)(real_i,j);
-		}
+			kernel_row(real_i,data,0,l);
 
 		// reorder and copy
 		Qfloat *buf = buffer[next_buffer];
@@ -1707,9 +2323,10 @@ public:
 		  }
 		}
 
-		buffer[0] = new Qfloat[nr_thres*l];
-		buffer[1] = new Qfloat[nr_thres*l];
-		next_buffer = 0;
+		block.index = index;
+		block.sign = sign;
+		block.phase = phase;
+		block.th_cost = th_cost;
 	}
 
 	void swap_index(int i, int j) const
@@ -1720,27 +2337,15 @@ public:
 		swap(QD[i],QD[j]);
 	}
   	
-	Qfloat *get_Q(int i, int len) const
+	// the kernel row of the sample of i, whatever len;
+	// the solver forms Q_ij from it with the block structure
+	Qfloat *get_Q(int i, int) const
 	{
 		Qfloat *data;
 		int real_i = index[i];
 		if(cache->get_data(real_i,&data,l) < l)
-		{
-			for(int j=0;j<l;j++)
-				data[j] = (Qfloat)(this->*kernel_function)(real_i,j);
-		}
-
-		// reorder and copy
-		Qfloat *buf = buffer[next_buffer];
-		next_buffer = 1 - next_buffer;
-		schar si = sign[i];		
-		for(int j=0;j<len;j++){
-			double value = data[index[j]];
-			if (phase[j] == phase[i])
-				value += th_cost;
-			buf[j] = si * sign[j] * value;
-		}
-		return buf;
+			kernel_row(real_i,data,0,l);
+		return data;
 	}
 
 	double *get_QD() const
@@ -1748,14 +2353,17 @@ public:
 		return QD;
 	}
 
+	const QBlock *get_block() const
+	{
+		return &block;
+	}
+
 	~RNK_Q()
 	{
 		delete cache;
 		delete[] sign;
 		delete[] phase;
 		delete[] index;
-		delete[] buffer[0];
-		delete[] buffer[1];
 		delete[] y;
 		delete[] QD;
 	}
@@ -1766,8 +2374,7 @@ private:
 	schar *sign;
 	schar *phase;
 	int *index;
-	mutable int next_buffer;
-	Qfloat *buffer[2];
+	QBlock block;
 	double *QD;
 	int nr_thres;
 	double th_cost;
@@ -1793,7 +2400,7 @@ static void solve_c_svc(
 		if(prob->y[i] > 0) y[i] = +1; else y[i]=-1;
 	}
 
-	Solver s;
+	Solver s(param->wss);
 	s.Solve(l, SVC_Q(*prob,*param,y), minus_ones, y,
 		alpha, Cp, Cn, param->eps, si, param->shrinking);
 
@@ -1890,7 +2497,7 @@ static void solve_one_class(
 		ones[i] = 1;
 	}
 
-	Solver s;
+	Solver s(param->wss);
 	s.Solve(l, ONE_CLASS_Q(*prob,*param), zeros, ones,
 		alpha, 1.0, 1.0, param->eps, si, param->shrinking);
 
@@ -1919,7 +2526,7 @@ static void solve_epsilon_svr(
 		y[i+l] = -1;
 	}
 
-	Solver s;
+	Solver s(param->wss);
 	s.Solve(2*l, SVR_Q(*prob,*param), linear_term, y,
 		alpha2, param->C, param->C, param->eps, si, param->shrinking);
 
@@ -1959,7 +2566,7 @@ static void solve_c_rnk(
 	  }
 	}
 
-	Solver s;
+	Solver s(param->wss);
 	s.Solve(bigl, RNK_Q(*prob,*param, nr_thres, 1), minus_ones, y,
 		bigalpha, param->C, param->C, param->eps, si, param->shrinking);
 
@@ -2005,7 +2612,7 @@ static void solve_svorim(
 	  }
 	}
 
-	Solver_SVORIM s(nr_thres);
+	Solver_SVORIM s(nr_thres, param->wss);
 	s.Solve(bigl, RNK_Q(*prob,*param, nr_thres, 0), minus_ones, y,
 		bigalpha, param->C, param->C, param->eps, si, param->shrinking);
 
@@ -3521,6 +4128,10 @@ const char *svm_check_parameter(const svm_problem *prob, const svm_parameter *pa
 	   param->shrinking != 1)
 		return "shrinking != 0 and shrinking != 1";
 
+	if(param->wss != 1 &&
+	   param->wss != 2)
+		return "wss != 1 and wss != 2";
+
 	if(param->probability != 0 &&
 	   param->probability != 1)
 		return "probability != 0 and probability != 1";
@@ -3601,3 +4212,8 @@ void svm_set_print_string_function(void (*print_func)(const char *))
 	else
 		svm_print_string = print_func;
 }
+
+void svm_set_num_threads(int nr_thread)
+{
+	svm_nr_thread = min(max(nr_thread,1),Thread_Pool::max_size());
+}
@@ -1,7 +1,7 @@
 #ifndef _LIBSVM_H
 #define _LIBSVM_H
 
-#define LIBSVM_VERSION 312
+#define LIBSVM_VERSION 313
 
 #ifdef __cplusplus
 extern "C" {
@@ -44,6 +44,7 @@ struct svm_parameter
 	double p;	/* for EPSILON_SVR */
 	int shrinking;	/* use the shrinking heuristics */
 	int probability; /* do probability estimates */
+	int wss;	/* working set selection, 1 or 2 (not for NU_SVC and NU_SVR) */
 };
 
 /*
@@ -92,6 +93,7 @@ const char *svm_check_parameter(const struct svm_problem *prob, const struct svm
 int svm_check_probability_model(const struct svm_model *model);
 
 void svm_set_print_string_function(void (*print_func)(const char *));
+void svm_set_num_threads(int nr_thread);	/* threads for the kernel columns, 1 by default, at most the online CPUs */
 
 #ifdef __cplusplus
 }
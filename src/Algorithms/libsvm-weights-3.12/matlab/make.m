@@ -12,8 +12,8 @@ if nargin < 1
             else
                 setenv('CFLAGS','-O3 -Wno-unused-result')
             end
-            mex -I.. -std=c++11 -O3 -Wno-unused-result svmtrain.cpp ../svm.cpp svm_model_matlab.cpp
-            mex -I.. -std=c++11 -O3 -Wno-unused-result svmpredict.cpp ../svm.cpp svm_model_matlab.cpp
+            mex -I.. -std=c++11 -O3 -Wno-unused-result -lpthread svmtrain.cpp ../svm.cpp svm_model_matlab.cpp
+            mex -I.. -std=c++11 -O3 -Wno-unused-result -lpthread svmpredict.cpp ../svm.cpp svm_model_matlab.cpp
             delete *.o
         % This part is for MATLAB
         % Add -largeArrayDims on 64-bit machines of MATLAB
@@ -22,8 +22,8 @@ if nargin < 1
                 mex COMPFLAGS="\$COMPFLAGS -std=c99 -O3 -Wno-unused-result" -I.. -largeArrayDims svmtrain.cpp ../svm.cpp svm_model_matlab.cpp
                 mex COMPFLAGS="\$COMPFLAGS -std=c99 -O3 -Wno-unused-result" -I.. -largeArrayDims svmpredict.cpp ../svm.cpp svm_model_matlab.cpp
             else
-                mex CFLAGS="\$CFLAGS -O3 -Wno-unused-result" -I.. -largeArrayDims svmtrain.cpp ../svm.cpp svm_model_matlab.cpp
-                mex CFLAGS="\$CFLAGS -O3 -Wno-unused-result" -I.. -largeArrayDims svmpredict.cpp ../svm.cpp svm_model_matlab.cpp
+                mex CFLAGS="\$CFLAGS -O3 -Wno-unused-result" -I.. -largeArrayDims -lpthread svmtrain.cpp ../svm.cpp svm_model_matlab.cpp
+                mex CFLAGS="\$CFLAGS -O3 -Wno-unused-result" -I.. -largeArrayDims -lpthread svmpredict.cpp ../svm.cpp svm_model_matlab.cpp
             end
         end
     catch err
@@ -41,6 +41,7 @@ void exit_with_help()
 	"-r coef0 : set coef0 in kernel function (default 0)\n"
 	"-c cost : set the parameter C of C-SVC, epsilon-SVR, and nu-SVR (default 1)\n"
 	"-n nu : set the parameter nu of nu-SVC, one-class SVM, and nu-SVR (default 0.5)\n"
+	"-nt threads : set the number of threads for the kernel columns (default 1)\n"
 	"-p epsilon : set the epsilon in loss function of epsilon-SVR (default 0.1)\n"
 	"-m cachesize : set cache memory size in MB (default 100)\n"
 	"-e epsilon : set tolerance of termination criterion (default 0.001)\n"
@@ -111,6 +112,7 @@ int parse_command_line(int nrhs, const mxArray *prhs[], char *model_file_name)
 	char cmd[CMD_LEN];
 	char *argv[CMD_LEN/2];
 	void (*print_func)(const char *) = print_string_matlab;	// default printing to stdout
+	int nr_thread = 1;	// serial
 
 	// default values
 	param.svm_type = C_SVC;
@@ -167,7 +169,10 @@ int parse_command_line(int nrhs, const mxArray *prhs[], char *model_file_name)
 				param.coef0 = atof(argv[i]);
 				break;
 			case 'n':
-				param.nu = atof(argv[i]);
+				if(argv[i-1][2] == 't')
+					nr_thread = atoi(argv[i]);
+				else
+					param.nu = atof(argv[i]);
 				break;
 			case 'm':
 				param.cache_size = atof(argv[i]);
@@ -214,6 +219,7 @@ int parse_command_line(int nrhs, const mxArray *prhs[], char *model_file_name)
 	}
 
 	svm_set_print_string_function(print_func);
+	svm_set_num_threads(nr_thread);
 
 	return 0;
 }
@@ -137,6 +137,7 @@ class svm_parameter(Structure):
 		self.cross_validation = False
 		self.nr_fold = 0
 		self.print_func = None
+		self.nr_thread = 1
 
 	def parse_options(self, options):
 		argv = options.split()
@@ -165,6 +166,9 @@ class svm_parameter(Structure):
 			elif argv[i] == "-n":
 				i = i + 1
 				self.nu = float(argv[i])
+			elif argv[i] == "-nt":
+				i = i + 1
+				self.nr_thread = int(argv[i])
 			elif argv[i] == "-m":
 				i = i + 1
 				self.cache_size = float(argv[i])
@@ -202,6 +206,7 @@ class svm_parameter(Structure):
 			i += 1
 
 		libsvm.svm_set_print_string_function(self.print_func)
+		libsvm.svm_set_num_threads(self.nr_thread)
 		self.weight_label = (c_int*self.nr_weight)()
 		self.weight = (c_double*self.nr_weight)()
 		for i in range(self.nr_weight): 
@@ -296,3 +301,4 @@ fillprototype(libsvm.svm_destroy_param, None, [POINTER(svm_parameter)])
 fillprototype(libsvm.svm_check_parameter, c_char_p, [POINTER(svm_problem), POINTER(svm_parameter)])
 fillprototype(libsvm.svm_check_probability_model, c_int, [POINTER(svm_model)])
 fillprototype(libsvm.svm_set_print_string_function, None, [PRINT_STRING_FUN])
+fillprototype(libsvm.svm_set_num_threads, None, [c_int])
@@ -102,6 +102,7 @@ def svm_train(arg1, arg2=None, arg3=None, arg4 = None):
 	    -r coef0 : set coef0 in kernel function (default 0)
 	    -c cost : set the parameter C of C-SVC, epsilon-SVR, and nu-SVR (default 1)
 	    -n nu : set the parameter nu of nu-SVC, one-class SVM, and nu-SVR (default 0.5)
+	    -nt threads : set the number of threads for the kernel columns (default 1)
 	    -p epsilon : set the epsilon in loss function of epsilon-SVR (default 0.1)
 	    -m cachesize : set cache memory size in MB (default 100)
 	    -e epsilon : set tolerance of termination criterion (default 0.001)
@@ -138,6 +139,7 @@ def svm_train(arg1, arg2=None, arg3=None, arg4 = None):
 	if param.gamma == 0 and prob.n > 0: 
 		param.gamma = 1.0 / prob.n
 	libsvm.svm_set_print_string_function(param.print_func)
+	libsvm.svm_set_num_threads(param.nr_thread)
 	err_msg = libsvm.svm_check_parameter(prob, param)
 	if err_msg:
 		raise ValueError('Error: %s' % err_msg)
@@ -8,6 +8,13 @@
 #include <limits.h>
 #include <locale.h>
 #include "svm.h"
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
 int libsvm_version = LIBSVM_VERSION;
 typedef float Qfloat;
 typedef signed char schar;
@@ -184,6 +191,248 @@ void Cache::swap_index(int i, int j)
 	}
 }
 
+//
+// Thread pool for the kernel columns
+//
+// nr_thread-1 workers wait for a job, and the caller of run works with them.
+// A job [start,end) is cut into one block per thread. Without pthreads
+// (_WIN32), no workers are started and jobs run in the caller.
+// The number of threads is set by svm_set_num_threads, 1 by default.
+//
+#define PARALLEL_MIN 65536	// smallest column part times features filled in parallel
+
+static int svm_nr_thread = 1;
+
+class Thread_Pool
+{
+public:
+	Thread_Pool(int nr_thread);
+	~Thread_Pool();
+	int size() const { return nr_thread; }
+	static int max_size();
+	// task(arg,begin,end) on the blocks of [start,end), waiting for all of them
+	void run(void (*task)(void *, int, int), void *arg, int start, int end);
+private:
+	int nr_thread;		// workers started plus the caller
+#ifndef _WIN32
+	struct worker_t
+	{
+		Thread_Pool *pool;
+		int id;
+		pthread_t thread;
+	};
+	worker_t *workers;
+	pthread_mutex_t lock;
+	pthread_cond_t start_cond;
+	pthread_cond_t done_cond;
+	unsigned long generation;	// incremented for every job
+	int running;		// workers still busy with the job
+	bool quit;
+
+	void (*task)(void *, int, int);	// the current job
+	void *arg;
+	int start, end;
+
+	void run_block(int id);
+	static void *loop(void *ptr);
+#endif
+};
+
+// the online CPUs, the most threads worth starting
+int Thread_Pool::max_size()
+{
+#ifdef _WIN32
+	return 1;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n < 1) ? 1 : (int)min(n,(long)INT_MAX);
+#endif
+}
+
+#ifdef _WIN32
+Thread_Pool::Thread_Pool(int)
+{
+	info("threads are not supported, running serially\n");
+	nr_thread = 1;
+}
+
+Thread_Pool::~Thread_Pool()
+{
+}
+
+void Thread_Pool::run(void (*task_)(void *, int, int), void *arg_, int start_, int end_)
+{
+	task_(arg_,start_,end_);
+}
+#else
+Thread_Pool::Thread_Pool(int nr_thread_)
+{
+	nr_thread_ = min(nr_thread_,max_size());
+	pthread_mutex_init(&lock,NULL);
+	pthread_cond_init(&start_cond,NULL);
+	pthread_cond_init(&done_cond,NULL);
+	generation = 0;
+	running = 0;
+	quit = false;
+
+	nr_thread = 1;
+	workers = new worker_t[max(nr_thread_-1,1)];
+	for(int t=0;t<nr_thread_-1;t++)
+	{
+		workers[t].pool = this;
+		workers[t].id = t+1;
+		if(pthread_create(&workers[t].thread,NULL,loop,&workers[t]) != 0)
+		{
+			info("only %d threads are started\n",nr_thread);
+			break;
+		}
+		nr_thread++;
+	}
+}
+
+Thread_Pool::~Thread_Pool()
+{
+	pthread_mutex_lock(&lock);
+	quit = true;
+	pthread_cond_broadcast(&start_cond);
+	pthread_mutex_unlock(&lock);
+	for(int t=0;t<nr_thread-1;t++)
+		pthread_join(workers[t].thread,NULL);
+	pthread_mutex_destroy(&lock);
+	pthread_cond_destroy(&start_cond);
+	pthread_cond_destroy(&done_cond);
+	delete[] workers;
+}
+
+void Thread_Pool::run_block(int id)
+{
+	size_t n = (size_t)(end-start);
+	int begin = start + (int)(n*(size_t)id/(size_t)nr_thread);
+	int stop = start + (int)(n*(size_t)(id+1)/(size_t)nr_thread);
+	if(begin < stop)
+		task(arg,begin,stop);
+}
+
+void *Thread_Pool::loop(void *ptr)
+{
+	worker_t *worker = (worker_t *)ptr;
+	Thread_Pool *pool = worker->pool;
+	unsigned long generation = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	while(true)
+	{
+		while(!pool->quit && generation == pool->generation)
+			pthread_cond_wait(&pool->start_cond,&pool->lock);
+		if(pool->quit)
+			break;
+		generation = pool->generation;
+		pthread_mutex_unlock(&pool->lock);
+
+		pool->run_block(worker->id);
+
+		pthread_mutex_lock(&pool->lock);
+		if(--pool->running == 0)
+			pthread_cond_signal(&pool->done_cond);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+void Thread_Pool::run(void (*task_)(void *, int, int), void *arg_, int start_, int end_)
+{
+	if(nr_thread == 1)
+	{
+		task_(arg_,start_,end_);
+		return;
+	}
+
+	pthread_mutex_lock(&lock);
+	task = task_;
+	arg = arg_;
+	start = start_;
+	end = end_;
+	running = nr_thread-1;
+	generation++;
+	pthread_cond_broadcast(&start_cond);
+	pthread_mutex_unlock(&lock);
+
+	run_block(0);
+
+	pthread_mutex_lock(&lock);
+	while(running > 0)
+		pthread_cond_wait(&done_cond,&lock);
+	pthread_mutex_unlock(&lock);
+}
+#endif
+
+//
+// Dense rows for the kernel
+//
+// when most features are nonzero the training instances are also kept as
+// contiguous rows of dense_len values, a multiple of DENSE_ALIGN padded with
+// zeros, so the inner loops below have no remainder. AVX-512 or AVX2 is used
+// if the compiler targets it, e.g. with -march=native, otherwise plain loops
+// that add in the same order as the sparse dot.
+//
+#define DENSE_ALIGN 8
+#define DENSE_RATIO 0.5	// smallest fraction of nonzero features for dense rows
+
+#if defined(__AVX512F__)
+
+static inline double sum_pd(__m512d v)
+{
+	double t[8];
+	_mm512_storeu_pd(t,v);
+	return ((t[0]+t[1])+(t[2]+t[3]))+((t[4]+t[5])+(t[6]+t[7]));
+}
+
+static double dense_dot(const double *a, const double *b, int n)
+{
+	__m512d acc = _mm512_setzero_pd();
+	for(int k=0;k<n;k+=8)
+		acc = _mm512_fmadd_pd(_mm512_loadu_pd(a+k),_mm512_loadu_pd(b+k),acc);
+	return sum_pd(acc);
+}
+
+#elif defined(__AVX2__)
+
+#ifdef __FMA__
+#define FMADD_PD(a,b,c) _mm256_fmadd_pd(a,b,c)
+#else
+#define FMADD_PD(a,b,c) _mm256_add_pd(_mm256_mul_pd(a,b),c)
+#endif
+
+static inline double sum_pd(__m256d v)
+{
+	__m128d s = _mm_add_pd(_mm256_castpd256_pd128(v),_mm256_extractf128_pd(v,1));
+	return _mm_cvtsd_f64(s) + _mm_cvtsd_f64(_mm_unpackhi_pd(s,s));
+}
+
+static double dense_dot(const double *a, const double *b, int n)
+{
+	__m256d acc0 = _mm256_setzero_pd();
+	__m256d acc1 = _mm256_setzero_pd();
+	for(int k=0;k<n;k+=8)
+	{
+		acc0 = FMADD_PD(_mm256_loadu_pd(a+k),_mm256_loadu_pd(b+k),acc0);
+		acc1 = FMADD_PD(_mm256_loadu_pd(a+k+4),_mm256_loadu_pd(b+k+4),acc1);
+	}
+	return sum_pd(_mm256_add_pd(acc0,acc1));
+}
+
+#else
+
+static double dense_dot(const double *a, const double *b, int n)
+{
+	double sum = 0;
+	for(int k=0;k<n;k++)
+		sum += a[k] * b[k];
+	return sum;
+}
+
+#endif
+
 //
 // Kernel evaluation
 //
@@ -211,15 +460,32 @@ public:
 	virtual void swap_index(int i, int j) const	// no so const...
 	{
 		swap(x[i],x[j]);
+		if(xd) swap(xd[i],xd[j]);
 		if(x_square) swap(x_square[i],x_square[j]);
 	}
 protected:
 
 	double (Kernel::*kernel_function)(int i, int j) const;
 
+	// data[j] = K(i,j) for start <= j < end
+	void kernel_row(int i, Qfloat *data, int start, int end) const;
+
 private:
 	const svm_node **x;
 	double *x_square;
+	Thread_Pool *pool;	// NULL if the columns are filled serially
+	int min_parallel;	// shortest column part filled by the pool
+
+	struct kernel_row_job
+	{
+		const Kernel *kernel;
+		int i;
+		Qfloat *data;
+	};
+	static void kernel_row_task(void *arg, int begin, int end);
+	const double **xd;	// dense rows, NULL on the sparse path
+	double *xd_space;
+	int dense_len;
 
 	// svm_parameter
 	const int kernel_type;
@@ -228,6 +494,7 @@ private:
 	const double coef0;
 
 	static double dot(const svm_node *px, const svm_node *py);
+	bool make_dense(int l);
 	double kernel_linear(int i, int j) const
 	{
 		return dot(x[i],x[j]);
@@ -248,47 +515,141 @@ private:
 	{
 		return x[i][(int)(x[j][0].value)].value;
 	}
+
+	// the same kernels on the dense rows
+	double kernel_linear_dense(int i, int j) const
+	{
+		return dense_dot(xd[i],xd[j],dense_len);
+	}
+	double kernel_poly_dense(int i, int j) const
+	{
+		return powi(gamma*dense_dot(xd[i],xd[j],dense_len)+coef0,degree);
+	}
+	double kernel_rbf_dense(int i, int j) const
+	{
+		return exp(-gamma*(x_square[i]+x_square[j]-2*dense_dot(xd[i],xd[j],dense_len)));
+	}
+	double kernel_sigmoid_dense(int i, int j) const
+	{
+		return tanh(gamma*dense_dot(xd[i],xd[j],dense_len)+coef0);
+	}
 };
 
 Kernel::Kernel(int l, svm_node * const * x_, const svm_parameter& param)
 :kernel_type(param.kernel_type), degree(param.degree),
  gamma(param.gamma), coef0(param.coef0)
 {
+	clone(x,x_,l);
+
+	bool dense = (kernel_type != PRECOMPUTED && make_dense(l));
+
 	switch(kernel_type)
 	{
 		case LINEAR:
-			kernel_function = &Kernel::kernel_linear;
+			kernel_function = dense ? &Kernel::kernel_linear_dense : &Kernel::kernel_linear;
 			break;
 		case POLY:
-			kernel_function = &Kernel::kernel_poly;
+			kernel_function = dense ? &Kernel::kernel_poly_dense : &Kernel::kernel_poly;
 			break;
 		case RBF:
-			kernel_function = &Kernel::kernel_rbf;
+			kernel_function = dense ? &Kernel::kernel_rbf_dense : &Kernel::kernel_rbf;
 			break;
 		case SIGMOID:
-			kernel_function = &Kernel::kernel_sigmoid;
+			kernel_function = dense ? &Kernel::kernel_sigmoid_dense : &Kernel::kernel_sigmoid;
 			break;
 		case PRECOMPUTED:
 			kernel_function = &Kernel::kernel_precomputed;
 			break;
 	}
 
-	clone(x,x_,l);
-
 	if(kernel_type == RBF)
 	{
 		x_square = new double[l];
 		for(int i=0;i<l;i++)
-			x_square[i] = dot(x[i],x[i]);
+			x_square[i] = dense ? dense_dot(xd[i],xd[i],dense_len) : dot(x[i],x[i]);
 	}
 	else
 		x_square = 0;
+
+	pool = NULL;
+	min_parallel = INT_MAX;
+	if(svm_nr_thread > 1)
+	{
+		double nnz = 0;
+		for(int i=0;i<l;i++)
+			for(const svm_node *px=x[i];px->index!=-1;px++)
+				nnz++;
+		pool = new Thread_Pool(svm_nr_thread);
+		min_parallel = (int)min((double)INT_MAX,max(1.0,(double)PARALLEL_MIN*l/max(nnz,1.0)));
+	}
+}
+
+// copy the instances to dense rows if at least DENSE_RATIO of the features
+// are nonzero, aligned for the SIMD loops; return false to stay sparse
+bool Kernel::make_dense(int l)
+{
+	xd = NULL;
+	xd_space = NULL;
+	dense_len = 0;
+
+	int i, max_index = 0;
+	double nnz = 0;
+	for(i=0;i<l;i++)
+		for(const svm_node *p=x[i];p->index!=-1;p++)
+		{
+			if(p->index < 1)
+				return false;
+			if(p->index > max_index)
+				max_index = p->index;
+			nnz++;
+		}
+	if(max_index == 0 || nnz < DENSE_RATIO*l*max_index)
+		return false;
+
+	dense_len = (max_index+DENSE_ALIGN-1)/DENSE_ALIGN*DENSE_ALIGN;
+	xd_space = new double[(size_t)l*dense_len+DENSE_ALIGN];
+	memset(xd_space,0,sizeof(double)*((size_t)l*dense_len+DENSE_ALIGN));
+	double *row = xd_space;
+	while((size_t)row % (DENSE_ALIGN*sizeof(double)))
+		row++;
+
+	xd = new const double*[l];
+	for(i=0;i<l;i++,row+=dense_len)
+	{
+		for(const svm_node *p=x[i];p->index!=-1;p++)
+			row[p->index-1] = p->value;
+		xd[i] = row;
+	}
+	return true;
 }
 
 Kernel::~Kernel()
 {
 	delete[] x;
 	delete[] x_square;
+	delete[] xd;
+	delete[] xd_space;
+	delete pool;
+}
+
+void Kernel::kernel_row_task(void *arg, int begin, int end)
+{
+	kernel_row_job *job = (kernel_row_job *)arg;
+	const Kernel *kernel = job->kernel;
+	for(int j=begin;j<end;j++)
+		job->data[j] = (Qfloat)(kernel->*(kernel->kernel_function))(job->i,j);
+}
+
+void Kernel::kernel_row(int i, Qfloat *data, int start, int end) const
+{
+	if(end-start < min_parallel)
+	{
+		for(int j=start;j<end;j++)
+			data[j] = (Qfloat)(this->*kernel_function)(i,j);
+		return;
+	}
+	kernel_row_job job = { this, i, data };
+	pool->run(kernel_row_task,&job,start,end);
 }
 
 double Kernel::dot(const svm_node *px, const svm_node *py)
@@ -1283,8 +1644,10 @@ public:
 		int start, j;
 		if((start = cache->get_data(i,&data,len)) < len)
 		{
+			kernel_row(i,data,start,len);
 			for(j=start;j<len;j++)
-				data[j] = (Qfloat)(y[i]*y[j]*(this->*kernel_function)(i,j));
+				if(y[i] != y[j])
+					data[j] = -data[j];
 		}
 		return data;
 	}
@@ -1329,12 +1692,9 @@ public:
 	Qfloat *get_Q(int i, int len) const
 	{
 		Qfloat *data;
-		int start, j;
+		int start;
 		if((start = cache->get_data(i,&data,len)) < len)
-		{
-			for(j=start;j<len;j++)
-				data[j] = (Qfloat)(this->*kernel_function)(i,j);
-		}
+			kernel_row(i,data,start,len);
 		return data;
 	}
 
@@ -1397,10 +1757,7 @@ public:
 		Qfloat *data;
 		int j, real_i = index[i];
 		if(cache->get_data(real_i,&data,l) < l)
-		{
-			for(j=0;j<l;j++)
-				data[j] = (Qfloat)(this->*kernel_function)(real_i,j);
-		}
+			kernel_row(real_i,data,0,l);
 
 		// reorder and copy
 		Qfloat *buf = buffer[next_buffer];
@@ -3211,3 +3568,8 @@ void svm_set_print_string_function(void (*print_func)(const char *))
 	else
 		svm_print_string = print_func;
 }
+
+void svm_set_num_threads(int nr_thread)
+{
+	svm_nr_thread = min(max(nr_thread,1),Thread_Pool::max_size());
+}
@@ -94,6 +94,7 @@ const char *svm_check_parameter(const struct svm_problem *prob, const struct svm
 int svm_check_probability_model(const struct svm_model *model);
 
 void svm_set_print_string_function(void (*print_func)(const char *));
+void svm_set_num_threads(int nr_thread);	/* threads for the kernel columns, 1 by default, at most the online CPUs */
 
 #ifdef __cplusplus
 }
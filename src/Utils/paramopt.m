@@ -97,9 +97,13 @@ for ff = 1:numTests
             param = [];
         end
         
-        model = alg.fitpredict(auxTrain, auxTest, param);
+        % only the test predictions are used, so the training
+        % projection is not requested from the method
+        alg.setParam(param);
+        alg.fit(auxTrain, alg.parameters);
+        [~, predictedTest] = alg.predict(auxTest.patterns);
         
-        result(ff,i) = opt.metric.calculateCrossvalMetric(auxTest.targets, model.predictedTest);
+        result(ff,i) = opt.metric.calculateCrossvalMetric(auxTest.targets, predictedTest);
     end
     
 end